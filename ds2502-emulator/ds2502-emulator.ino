@@ -32,7 +32,8 @@
 // #include "DS2502.h"
 
 // Using GPIO2 on an ESP01 module (Requires 10k pull-up to 3.3V)
-constexpr uint8_t pin_onewire{2};
+// the USI engine needs the line on PB0 (SDA), PB2 has to stay free for its pull-up
+constexpr uint8_t pin_onewire{USI_ENGINE_ENABLE ? 0 : 2};
 
 // // EEPROM strings, the length is always 42 bytes, including 2 bytes of CRC16 checksum.
 // constexpr uint8_t chargerStrlen{42};
@@ -44,8 +45,165 @@ constexpr uint8_t pin_onewire{2};
 // // I made this up, works with Dell Inspiron 15R N5110 and Dell Inspiron 15R 5521
 // // constexpr const char* charger130W = "DELL00AC130195067CN0CDF577243865Q27F2233\x9D\x72";
 
-auto hub = OneWireHub(pin_onewire);
-auto dellCH = DS2502(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A); // address does not matter, laptop uses skipRom -> note that therefore only one slave device is allowed on the bus
+#if MULTIHUB_ENABLE
+#include "src/OneWireMultiHub.h"
+
+// one bus per laptop, all pins on the same port. the clock limits the buses (MULTIHUB_BUS_LIMIT, see README):
+// PB2 and PB3 of the attiny25 @ 8 MHz, PB0..PB3 -> pins 8..11 of an atmega328 @ 16 MHz
+#if defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+constexpr uint8_t pin_bus[]{2, 3};
+#else
+constexpr uint8_t pin_bus[]{8, 9, 10, 11};
+#endif
+
+OneWireMultiHub multihub;
+// each bus gets its own device, pass an image (PROGMEM) as last arguments for a different charger per bus
+DS2502 dellBus[sizeof(pin_bus)]{{0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A},
+                                {0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0B},
+#if !defined(__AVR_ATtiny25__) && !defined(__AVR_ATtiny45__) && !defined(__AVR_ATtiny85__)
+                                {0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0C},
+                                {0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0D}
+#endif
+};
+
+void setup()
+{
+    static_assert(sizeof(pin_bus) <= MULTIHUB_BUS_LIMIT, "more buses than MULTIHUB_BUS_LIMIT");
+
+    for (uint8_t index = 0; index < sizeof(pin_bus); ++index)
+        multihub.attach(pin_bus[index], dellBus[index]);
+}
+
+void loop()
+{
+    multihub.poll(); // does not return
+}
+#elif DUMPER_ENABLE
+#include "src/ChargerDumper.h"
+
+// adapter plugged into the dumper board: data line with a pull-up to 5V on pin 2 of an atmega328 (see README)
+OneWireMaster master(pin_onewire);
+ChargerDumper dumper(master);
+bool adapter_present{false};
+
+void setup()
+{
+    Serial.begin(115200);
+    ChargerDumper::printHeader();
+}
+
+void loop()
+{
+    // the reset doubles as hot-plug detection, every adapter is dumped once per plug-in
+    if (!master.reset())
+        adapter_present = false;
+    else if (!adapter_present)
+    {
+        adapter_present = true;
+        ChargerDump result;
+        const bool valid = dumper.dump(result);
+        ChargerDumper::print(result, valid);
+        return;
+    }
+    delay(DUMPER_POLL_MS);
+}
+#elif PROGRAMMER_ENABLE
+#include "src/ChargerProgrammer.h"
+
+// DS2502_prog board on an atmega328: I/O on pin 2 (pull-up to 5V), PRGM on pin 3, +12V from a bench supply (see README)
+constexpr uint8_t pin_program{3};
+
+// queue of identities, every inserted chip gets the next one. unique serials -> one entry per chip
+constexpr uint8_t image65W[] PROGMEM = "DELL00AC065195033CN05U0927161552F31B8A03\xBC\x8F";
+constexpr uint8_t image90W[] PROGMEM = "DELL00AC090195046CN0C80234866161R23H8A03\x4D\x7C";
+const ChargerImage image_queue[]{{image65W, sizeof(image65W) - 1, nullptr},
+                                 {image90W, sizeof(image90W) - 1, nullptr}};
+constexpr uint8_t image_count{sizeof(image_queue) / sizeof(image_queue[0])};
+
+OneWireMaster master(pin_onewire);
+ChargerProgrammer programmer(master, pin_program);
+uint8_t image_index{0};
+bool chip_present{false};
+
+void setup()
+{
+    Serial.begin(115200);
+    pinMode(LED_BUILTIN, OUTPUT); // on when the queue is through
+    ChargerProgrammer::printHeader();
+}
+
+void loop()
+{
+    // the reset doubles as hot-plug detection, every chip is handled once per insertion, no button in between
+    if (!master.reset())
+        chip_present = false;
+    else if (!chip_present && (image_index < image_count))
+    {
+        chip_present = true;
+        uint8_t rom[8];
+        const uint32_t time_start = millis();
+        const ChargerProgrammer::Result result = programmer.program(image_queue[image_index], rom);
+        ChargerProgrammer::print(rom, image_index, result, millis() - time_start);
+        if ((result == ChargerProgrammer::Result::OK) || (result == ChargerProgrammer::Result::ALREADY_PROGRAMMED))
+            ++image_index; // a failed chip does not use up its image
+        digitalWrite(LED_BUILTIN, (image_index < image_count) ? LOW : HIGH);
+        return;
+    }
+    delay(PROGRAMMER_POLL_MS);
+}
+#elif PROXY_ENABLE
+#include "src/ChargerProxy.h"
+
+// genuine adapter on PB3 (pull-up to the supply of the attiny), learned once into EEPROM, see README
+constexpr uint8_t pin_adapter{3};
+
+OneWireMaster master(pin_adapter);
+ChargerProxy proxy(master);
+CachedDS2502 dellCH(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A); // rom, status and image get replaced by the learned adapter
+#if STATIC_DISPATCH_ENABLE
+#include "src/OneWireHubStatic.h"
+OneWireHubStatic<CachedDS2502> hub(pin_onewire, dellCH);
+#else
+OneWireHub hub(pin_onewire);
+#endif
+
+void setup()
+{
+    // nothing is served before a complete record exists, the laptop sees no adapter until then
+    while (!ChargerProxy::load(dellCH))
+    {
+        if (proxy.learn() != ChargerProxy::Result::OK)
+            delay(PROXY_POLL_MS);
+    }
+#if STATIC_DISPATCH_ENABLE
+    hub.begin();
+#else
+    hub.attach(dellCH);
+#endif
+}
+
+void loop()
+{
+    hub.poll();
+}
+#elif STATIC_DISPATCH_ENABLE
+#include "src/OneWireHubStatic.h"
+
+DS2502 dellCH(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A); // address does not matter, laptop uses skipRom
+OneWireHubStatic<DS2502> hub(pin_onewire, dellCH);        // device is known at compile time, duty() gets called directly
+
+void setup()
+{
+    hub.begin();
+}
+
+void loop()
+{
+    hub.poll();
+}
+#else
+OneWireHub hub(pin_onewire);
+DS2502 dellCH(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A); // address does not matter, laptop uses skipRom -> note that therefore only one slave device is allowed on the bus, constant-initialised
 
 void setup()
 {
@@ -63,3 +221,41 @@ void loop()
     // following function must be called periodically
     hub.poll();
 }
+#endif
+
+#if BOOT_BENCH_ENABLE
+#include <avr/eeprom.h>
+
+#if !(defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__))
+#error "Boot bench uses timer1 of the ATtinyX5"
+#endif
+
+// runs a few cycles after the reset vector (before stack setup, .data copy, .bss clear and constructors), only writes an io-register
+__attribute__((naked, used, section(".init1"))) void bootBenchStart(void)
+{
+    TCCR1 = _BV(CS12) | _BV(CS11); // CK/32 -> 4 us per tick @ 8 MHz, overflow after 1020 us
+}
+
+void bootBenchStop(void)
+{
+    const uint8_t ticks = (TIFR & _BV(TOV1)) ? uint8_t(0xFF) : TCNT1; // 0xFF -> took longer than the timer can tell
+    TCCR1 = 0;
+    eeprom_update_byte(reinterpret_cast<uint8_t *>(BOOT_BENCH_EEPROM_ADDR), ticks); // EEPROM is written in the background, does not stall the bus
+}
+#endif
+
+#if FAST_BOOT_ENABLE || defined(ONEWIREHUB_BARE_METAL)
+// replaces main() of the arduino core, init() configures timer0 for millis(), pwm and the adc -> nothing of it is used by the hub
+// the bare-metal build ("make bare") has no core at all and always starts here
+// hub and device are initialised before this point, so the bus is served right away
+// start-up time of the mcu itself is set by the fuses, see "make fuses_fast"
+int main(void)
+{
+    setup();
+#if BOOT_BENCH_ENABLE
+    bootBenchStop();
+#endif
+    while (true)
+        loop();
+}
+#endif
@@ -0,0 +1,91 @@
+#include "ChargerDumper.h"
+
+#if DUMPER_ENABLE
+
+#include "DS2502.h"
+
+ChargerDumper::ChargerDumper(OneWireMaster &master) : master(master){};
+
+bool ChargerDumper::readRom(uint8_t rom[8])
+{
+    if (!master.reset())
+        return false;
+    master.send(0x33); // READ ROM
+    master.recv(rom, 8);
+    return (rom[0] == DS2502::family_code) && (OneWireItem::crc8(rom, 7) == rom[7]);
+}
+
+bool ChargerDumper::readFromStart(const uint8_t cmd, uint8_t data[], const uint8_t data_length)
+{
+    const uint8_t request[3] = {cmd, 0x00, 0x00}; // target address 0
+
+    if (!master.reset())
+        return false;
+    master.send(0xCC); // SKIP ROM
+    master.send(request, 3);
+    if (master.recv() != OneWireItem::crc8(request, 3))
+        return false;
+
+    master.recv(data, data_length); // device sends up to the end and appends the crc of the data
+    return (master.recv() == OneWireItem::crc8(data, data_length));
+}
+
+bool ChargerDumper::dump(ChargerDump &result)
+{
+    for (result.tries = 1; result.tries <= DUMPER_RETRIES + 1; ++result.tries)
+    {
+        if (readRom(result.rom) &&
+            readFromStart(0xF0, result.memory, MEM_SIZE) && // READ MEMORY
+            readFromStart(0xAA, result.status, STATUS_SIZE)) // READ STATUS
+            return true;
+    }
+    return false;
+}
+
+bool ChargerDumper::checkIdentity(const ChargerDump &result)
+{
+    constexpr uint8_t id_length{chargerStrlen - 2};
+    if (memcmp(result.memory, reinterpret_cast<const uint8_t *>("DELL"), 4) != 0)
+        return false;
+    const uint16_t crc = OneWireItem::crc16(result.memory, id_length);
+    return (result.memory[id_length] == uint8_t(crc)) && (result.memory[id_length + 1] == uint8_t(crc >> 8));
+}
+
+static void printHex(const uint8_t data[], const uint8_t data_length)
+{
+    for (uint8_t index = 0; index < data_length; ++index)
+    {
+        if (data[index] < 0x10)
+            Serial.print('0');
+        Serial.print(data[index], HEX);
+    }
+}
+
+void ChargerDumper::printHeader(void)
+{
+    Serial.println("rom,status,tries,result,identity,memory");
+}
+
+void ChargerDumper::print(const ChargerDump &result, const bool valid)
+{
+    printHex(result.rom, 8);
+    Serial.print(',');
+    printHex(result.status, STATUS_SIZE);
+    Serial.print(',');
+    Serial.print(result.tries);
+    Serial.print(',');
+    if (!valid)
+        Serial.print("crc-error");
+    else if (!checkIdentity(result))
+        Serial.print("no-identity");
+    else
+        Serial.print("ok");
+    Serial.print(',');
+    for (uint8_t index = 0; index < (chargerStrlen - 2); ++index)
+        Serial.print(((result.memory[index] >= 0x20) && (result.memory[index] < 0x7F)) ? char(result.memory[index]) : '.');
+    Serial.print(',');
+    printHex(result.memory, MEM_SIZE);
+    Serial.println();
+}
+
+#endif
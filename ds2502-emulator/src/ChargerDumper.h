@@ -0,0 +1,42 @@
+// reads genuine dell adapters with OneWireMaster: READ ROM, READ MEMORY and READ STATUS of the DS2502 inside,
+// every transfer is checked with the crc8 of the device, the identity string with its crc16/arc
+
+#ifndef CHARGER_DUMPER_H
+#define CHARGER_DUMPER_H
+
+#include "OneWireMaster.h"
+
+#if DUMPER_ENABLE
+
+struct ChargerDump
+{
+    uint8_t rom[8];
+    uint8_t status[8];
+    uint8_t memory[128];
+    uint8_t tries; // attempts it took, DUMPER_RETRIES + 1 -> none got through the crcs
+};
+
+class ChargerDumper
+{
+private:
+    static constexpr uint8_t MEM_SIZE{sizeof(ChargerDump::memory)};
+    static constexpr uint8_t STATUS_SIZE{sizeof(ChargerDump::status)};
+
+    OneWireMaster &master;
+
+    bool readRom(uint8_t rom[8]);
+    bool readFromStart(uint8_t cmd, uint8_t data[], uint8_t data_length); // READ MEMORY / READ STATUS, returns true if both crcs match
+
+public:
+    explicit ChargerDumper(OneWireMaster &master);
+
+    bool dump(ChargerDump &result); // returns true if rom, memory and status got through their crcs
+
+    static bool checkIdentity(const ChargerDump &result); // "DELL..." string with a matching crc16/arc
+
+    static void printHeader(void);
+    static void print(const ChargerDump &result, bool valid); // one csv-line per adapter
+};
+
+#endif
+#endif
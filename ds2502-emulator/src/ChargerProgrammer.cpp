@@ -0,0 +1,188 @@
+#include "ChargerProgrammer.h"
+
+#if PROGRAMMER_ENABLE
+
+#include "DS2502.h"
+
+ChargerProgrammer::ChargerProgrammer(OneWireMaster &master, const uint8_t pin_program) : master(master), pin_program(pin_program)
+{
+    static_assert(PROGRAMMER_TIME_PULSE_US >= 480 && PROGRAMMER_TIME_PULSE_US <= 5000, "programming pulse of the DS2502 is 480us to 5ms");
+    static_assert(PROGRAMMER_TIME_DELAY_US >= 5 && PROGRAMMER_TIME_VERIFY_US >= 5, "DS2502 needs 5us before and after the programming pulse");
+
+    digitalWrite(pin_program, PROGRAMMER_PULSE_LEVEL ^ 1);
+    pinMode(pin_program, OUTPUT);
+}
+
+// line is released by the master at this point (end of the crc-slot), the board switches +12V onto it
+void ChargerProgrammer::pulse(void)
+{
+    delayMicroseconds(PROGRAMMER_TIME_DELAY_US);
+    digitalWrite(pin_program, PROGRAMMER_PULSE_LEVEL);
+    delayMicroseconds(PROGRAMMER_TIME_PULSE_US);
+    digitalWrite(pin_program, PROGRAMMER_PULSE_LEVEL ^ 1);
+    delayMicroseconds(PROGRAMMER_TIME_VERIFY_US);
+}
+
+bool ChargerProgrammer::readRom(uint8_t rom[8])
+{
+    if (!master.reset())
+        return false;
+    master.send(0x33); // READ ROM
+    master.recv(rom, 8);
+    return (rom[0] == DS2502::family_code) && (OneWireItem::crc8(rom, 7) == rom[7]);
+}
+
+bool ChargerProgrammer::readFromStart(const uint8_t cmd, uint8_t data[], const uint8_t data_length)
+{
+    const uint8_t request[3] = {cmd, 0x00, 0x00}; // target address 0
+
+    if (!master.reset())
+        return false;
+    master.send(0xCC); // SKIP ROM, the board holds one chip
+    master.send(request, 3);
+    if (master.recv() != OneWireItem::crc8(request, 3))
+        return false;
+
+    master.recv(data, data_length); // device sends up to the end and appends the crc of the data
+    return (master.recv() == OneWireItem::crc8(data, data_length));
+}
+
+bool ChargerProgrammer::readChip(void)
+{
+    for (uint8_t tries = 0; tries <= PROGRAMMER_RETRIES; ++tries)
+    {
+        if (readFromStart(0xF0, chip_memory, MEM_SIZE) && // READ MEMORY
+            readFromStart(0xAA, chip_status, STATUS_SIZE)) // READ STATUS
+            return true;
+    }
+    return false;
+}
+
+// WRITE MEMORY / WRITE STATUS: cmd, address and the first byte are sent once, every following byte goes to the next address.
+// the device answers each byte with a crc8: the first over cmd, address and data, the following ones over the data with
+// the incremented address as crc-seed. a pulse only follows a matching crc, the device then sends the programmed byte.
+uint8_t ChargerProgrammer::writeRange(const uint8_t cmd, const uint8_t address, const uint8_t data[], const uint8_t data_length)
+{
+    const uint8_t request[4] = {cmd, address, 0x00, data[0]};
+
+    if (!master.reset())
+        return 0;
+    master.send(0xCC); // SKIP ROM
+    master.send(request, 4);
+    uint8_t crc = OneWireItem::crc8(request, 4);
+
+    for (uint8_t index = 0; index < data_length; ++index)
+    {
+        if (index != 0)
+        {
+            master.send(data[index]);
+            crc = OneWireItem::crc8(&data[index], 1, uint8_t(address + index));
+        }
+        if (master.recv() != crc)
+            return index; // no pulse, the reset of the next try ends the transaction
+        pulse();
+        if (master.recv() != data[index])
+            return index; // eprom-bits can be pulsed again, the next try starts with this byte
+    }
+    return data_length;
+}
+
+// the image has to fit over the chip already (only 1 -> 0), checked before anything is written
+ChargerProgrammer::Result ChargerProgrammer::writeDiff(const uint8_t cmd, const uint8_t target[], const uint8_t chip[], const uint8_t size)
+{
+    uint8_t address = 0;
+    while ((address < size) && (target[address] == chip[address]))
+        ++address;
+    if (address == size)
+        return Result::ALREADY_PROGRAMMED;
+
+    uint8_t end = size; // bytes in between that match already are programmed again, a pulse does not change them
+    while (target[end - 1] == chip[end - 1])
+        --end;
+
+    uint8_t retries = 0;
+    while (address < end)
+    {
+        const uint8_t written = writeRange(cmd, address, &target[address], end - address);
+        address += written;
+        if (written != 0)
+            retries = 0;
+        else if (++retries > PROGRAMMER_RETRIES)
+            return Result::WRITE_ERROR;
+    }
+    return Result::OK;
+}
+
+static bool fitsOver(const uint8_t target[], const uint8_t chip[], const uint8_t size)
+{
+    for (uint8_t index = 0; index < size; ++index)
+    {
+        if ((chip[index] & target[index]) != target[index])
+            return false;
+    }
+    return true;
+}
+
+ChargerProgrammer::Result ChargerProgrammer::program(const ChargerImage &image, uint8_t rom[8])
+{
+    const uint8_t memory_length = (image.memory_length > MEM_SIZE) ? MEM_SIZE : image.memory_length;
+    memset(target_memory, static_cast<uint8_t>(0xFF), MEM_SIZE);
+    for (uint8_t index = 0; index < memory_length; ++index)
+        target_memory[index] = pgm_read_byte(&image.memory[index]);
+
+    bool found = false;
+    for (uint8_t tries = 0; !found && (tries <= PROGRAMMER_RETRIES); ++tries)
+        found = readRom(rom);
+    if (!found)
+        return Result::NO_DEVICE;
+
+    if (!readChip())
+        return Result::READ_ERROR;
+
+    for (uint8_t index = 0; index < STATUS_SIZE; ++index)
+        target_status[index] = (image.status == nullptr) ? chip_status[index] : pgm_read_byte(&image.status[index]);
+
+    if (!fitsOver(target_memory, chip_memory, MEM_SIZE) || !fitsOver(target_status, chip_status, STATUS_SIZE))
+        return Result::NOT_BLANK;
+
+    // memory first, the status could write-protect its pages
+    const Result memory_result = writeDiff(0x0F, target_memory, chip_memory, MEM_SIZE); // WRITE MEMORY
+    if ((memory_result != Result::OK) && (memory_result != Result::ALREADY_PROGRAMMED))
+        return memory_result;
+    const Result status_result = writeDiff(0x55, target_status, chip_status, STATUS_SIZE); // WRITE STATUS
+    if ((status_result != Result::OK) && (status_result != Result::ALREADY_PROGRAMMED))
+        return status_result;
+    if ((memory_result == Result::ALREADY_PROGRAMMED) && (status_result == Result::ALREADY_PROGRAMMED))
+        return Result::ALREADY_PROGRAMMED;
+
+    if (!readChip())
+        return Result::READ_ERROR;
+    if ((memcmp(target_memory, chip_memory, MEM_SIZE) != 0) || (memcmp(target_status, chip_status, STATUS_SIZE) != 0))
+        return Result::VERIFY_ERROR;
+    return Result::OK;
+}
+
+void ChargerProgrammer::printHeader(void)
+{
+    Serial.println("rom,image,result,ms");
+}
+
+void ChargerProgrammer::print(const uint8_t rom[8], const uint8_t image_index, const Result result, const uint32_t duration_ms)
+{
+    static const char *const result_names[] = {"ok", "already-programmed", "no-device", "read-error", "not-blank", "write-error", "verify-error"};
+
+    for (uint8_t index = 0; index < 8; ++index)
+    {
+        if (rom[index] < 0x10)
+            Serial.print('0');
+        Serial.print(rom[index], HEX);
+    }
+    Serial.print(',');
+    Serial.print(image_index);
+    Serial.print(',');
+    Serial.print(result_names[static_cast<uint8_t>(result)]);
+    Serial.print(',');
+    Serial.println(duration_ms);
+}
+
+#endif
@@ -0,0 +1,66 @@
+// programs real DS2502 chips on the DS2502_prog board with OneWireMaster: WRITE MEMORY and WRITE STATUS with 12V pulses
+// - the pin "PRGM" of the board switches +12V onto the data line for the programming pulse
+// - bytes are pipelined: after the first one the device increments the address by itself, each byte is cmd-less (data -> crc -> pulse -> read-back)
+// - the chip is read back with READ MEMORY / READ STATUS (crc8 of the device) and compared to the image at the end
+
+#ifndef CHARGER_PROGRAMMER_H
+#define CHARGER_PROGRAMMER_H
+
+#include "OneWireMaster.h"
+
+#if PROGRAMMER_ENABLE
+
+// one identity of the queue, the pointers have to point to flash (PROGMEM)
+struct ChargerImage
+{
+    const uint8_t *memory;
+    uint8_t memory_length; // without a terminating zero, the rest of the 128 bytes stays unprogrammed 0xFF
+    const uint8_t *status; // 8 bytes, nullptr leaves the status memory as it is
+};
+
+class ChargerProgrammer
+{
+public:
+    enum class Result : uint8_t
+    {
+        OK = 0,
+        ALREADY_PROGRAMMED = 1, // chip holds the image already, no pulse was sent
+        NO_DEVICE = 2,          // no presence or no DS2502 (family code, crc of the ROM)
+        READ_ERROR = 3,         // reading the chip did not get through the crcs, also not with the retries
+        NOT_BLANK = 4,          // a bit of the image is 1 where the chip has a 0 already, eprom can't go back
+        WRITE_ERROR = 5,        // crc or read-back of a byte was still wrong after the retries
+        VERIFY_ERROR = 6        // final read-back differs from the image
+    };
+
+private:
+    static constexpr uint8_t MEM_SIZE{128};
+    static constexpr uint8_t STATUS_SIZE{8};
+
+    OneWireMaster &master;
+    uint8_t pin_program;
+
+    uint8_t target_memory[MEM_SIZE]; // image as the chip should read, filled up with 0xFF
+    uint8_t target_status[STATUS_SIZE];
+    uint8_t chip_memory[MEM_SIZE];
+    uint8_t chip_status[STATUS_SIZE];
+
+    void pulse(void);
+
+    bool readRom(uint8_t rom[8]);
+    bool readFromStart(uint8_t cmd, uint8_t data[], uint8_t data_length); // READ MEMORY / READ STATUS, returns true if both crcs match
+    bool readChip(void);
+
+    uint8_t writeRange(uint8_t cmd, uint8_t address, const uint8_t data[], uint8_t data_length); // one pipelined transaction, returns the bytes that got through
+    Result writeDiff(uint8_t cmd, const uint8_t target[], const uint8_t chip[], uint8_t size);      // programs the bytes from the first to the last that differ
+
+public:
+    ChargerProgrammer(OneWireMaster &master, uint8_t pin_program);
+
+    Result program(const ChargerImage &image, uint8_t rom[8]); // rom is filled for the report, even if programming fails
+
+    static void printHeader(void);
+    static void print(const uint8_t rom[8], uint8_t image_index, Result result, uint32_t duration_ms); // one csv-line per chip
+};
+
+#endif
+#endif
@@ -0,0 +1,144 @@
+#include "ChargerProxy.h"
+
+#if PROXY_ENABLE
+
+template class OneWireMemory<CachedDS2502Layout>; // duty() and the status functions, see OneWireMemory.h
+
+// eeprom_*() take the address as a pointer
+static uint8_t *eepromAddress(const uint8_t address)
+{
+    return reinterpret_cast<uint8_t *>(address);
+}
+
+ChargerProxy::ChargerProxy(OneWireMaster &master) : master(master)
+{
+    static_assert(PROXY_EEPROM_IMAGE >= (PROXY_EEPROM_STATUS + STATUS_SIZE), "image of the proxy overlaps its record");
+    static_assert(PROXY_EEPROM_IMAGE < BOOT_BENCH_EEPROM_ADDR, "no space for the image of the proxy below the boot bench");
+};
+
+bool ChargerProxy::readRom(uint8_t rom[8])
+{
+    if (!master.reset())
+        return false;
+    master.send(0x33); // READ ROM
+    master.recv(rom, 8);
+    return (rom[0] == DS2502::family_code) && (OneWireItem::crc8(rom, 7) == rom[7]);
+}
+
+bool ChargerProxy::readFromStart(const uint8_t cmd, uint8_t data[], const uint8_t data_length)
+{
+    const uint8_t request[3] = {cmd, 0x00, 0x00}; // target address 0
+
+    if (!master.reset())
+        return false;
+    master.send(0xCC); // SKIP ROM
+    master.send(request, 3);
+    if (master.recv() != OneWireItem::crc8(request, 3))
+        return false;
+
+    master.recv(data, data_length); // device sends up to the end and appends the crc of the data
+    return (master.recv() == OneWireItem::crc8(data, data_length));
+}
+
+// byte by byte into EEPROM, the slots of the master can wait for each write (~3.4ms), the adapter has no timeout between slots.
+// bytes beyond IMAGE_LIMIT are only counted, length ends behind the last one that is not 0xFF
+bool ChargerProxy::readImage(uint8_t &length, uint8_t &crc)
+{
+    const uint8_t request[3] = {0xF0, 0x00, 0x00}; // READ MEMORY from address 0
+
+    if (!master.reset())
+        return false;
+    master.send(0xCC); // SKIP ROM
+    master.send(request, 3);
+    if (master.recv() != OneWireItem::crc8(request, 3))
+        return false;
+
+    crc = 0;
+    length = 0;
+    for (uint8_t address = 0; address < MEM_SIZE; ++address)
+    {
+        const uint8_t data = master.recv();
+        crc = OneWireItem::crc8(&data, 1, crc);
+        if (address < IMAGE_LIMIT)
+            eeprom_update_byte(eepromAddress(PROXY_EEPROM_IMAGE + address), data); // unchanged bytes are not written
+        if (data != 0xFF)
+            length = address + 1;
+    }
+    return (master.recv() == crc);
+}
+
+uint8_t ChargerProxy::recordCrc(const uint8_t length)
+{
+    uint8_t crc = OneWireItem::crc8(&length, 1);
+    for (uint8_t address = PROXY_EEPROM_ROM; address < (PROXY_EEPROM_IMAGE + length); ++address)
+    {
+        if ((address >= (PROXY_EEPROM_STATUS + STATUS_SIZE)) && (address < PROXY_EEPROM_IMAGE))
+            continue; // unused bytes between record and image
+        const uint8_t data = eeprom_read_byte(eepromAddress(address));
+        crc = OneWireItem::crc8(&data, 1, crc);
+    }
+    return crc;
+}
+
+ChargerProxy::Result ChargerProxy::learn(void)
+{
+    uint8_t rom[8], status[STATUS_SIZE], length, crc;
+    Result result = Result::NO_DEVICE;
+
+    for (uint8_t tries = 0; tries <= PROXY_RETRIES; ++tries)
+    {
+        if (!readRom(rom))
+            continue;
+        result = Result::READ_ERROR;
+        if (!readFromStart(0xAA, status, STATUS_SIZE)) // READ STATUS
+            continue;
+        eeprom_update_byte(eepromAddress(PROXY_EEPROM_LENGTH), 0xFF); // no record from here on, its image gets overwritten
+        if (!readImage(length, crc))                                  // READ MEMORY
+            continue;
+        result = Result::OK;
+        break;
+    }
+    if (result != Result::OK)
+        return result;
+    if (length > IMAGE_LIMIT)
+        return Result::TOO_BIG;
+
+    // the adapter's crc runs over all 128 bytes, the rest behind the image is 0xFF
+    uint8_t readback = 0;
+    for (uint8_t address = 0; address < MEM_SIZE; ++address)
+    {
+        const uint8_t data = (address < length) ? eeprom_read_byte(eepromAddress(PROXY_EEPROM_IMAGE + address)) : uint8_t(0xFF);
+        readback = OneWireItem::crc8(&data, 1, readback);
+    }
+    if (readback != crc)
+        return Result::VERIFY_ERROR;
+
+    eeprom_update_block(rom, eepromAddress(PROXY_EEPROM_ROM), 8);
+    eeprom_update_block(status, eepromAddress(PROXY_EEPROM_STATUS), STATUS_SIZE);
+    eeprom_update_byte(eepromAddress(PROXY_EEPROM_CRC), recordCrc(length));
+    eeprom_update_byte(eepromAddress(PROXY_EEPROM_LENGTH), length); // last, completes the record
+    return Result::OK;
+}
+
+bool ChargerProxy::load(CachedDS2502 &device)
+{
+    uint8_t rom[8], status[STATUS_SIZE];
+    const uint8_t length = eeprom_read_byte(eepromAddress(PROXY_EEPROM_LENGTH));
+    if (length > IMAGE_LIMIT)
+        return false;
+    eeprom_read_block(rom, eepromAddress(PROXY_EEPROM_ROM), 8);
+    if ((rom[0] != DS2502::family_code) || (OneWireItem::crc8(rom, 7) != rom[7]))
+        return false; // e.g. an erased or zeroed EEPROM, their crc would match
+    if (recordCrc(length) != eeprom_read_byte(eepromAddress(PROXY_EEPROM_CRC)))
+        return false;
+
+    eeprom_read_block(status, eepromAddress(PROXY_EEPROM_STATUS), STATUS_SIZE);
+    memcpy(device.ID, rom, 8);
+    device.clearStatus();
+    for (uint8_t address = 0; address < STATUS_SIZE; ++address)
+        device.writeStatus(address, status[address]); // eprom-write onto the cleared status gives the value of the adapter
+    device.setImage(eepromAddress(PROXY_EEPROM_IMAGE), length);
+    return true;
+}
+
+#endif
@@ -0,0 +1,76 @@
+// learns the identity of a genuine adapter once and serves it from then on: OneWireMaster on a second pin reads ROM, status and
+// memory of the DS2502 inside (crc8 of every transfer), the memory goes to EEPROM while it is read (an attiny has no RAM for it)
+// - EEPROM (PROXY_EEPROM_*): programmed length, crc8 of the record, rom, status, then the image up to the last byte that is not 0xFF.
+//   tools/provision writes the same record, the proxy serves a provisioned one without an adapter
+// - the length is set to 0xFF (no record) before the first byte of the image is written and written last, after the image was
+//   read back against the crc of the adapter and the record crc -> an earlier record is never served with a torn image
+// - CachedDS2502 reads the image from EEPROM while sending, rom and status are loaded into RAM, the adapter is out of the path
+
+#ifndef CHARGER_PROXY_H
+#define CHARGER_PROXY_H
+
+#include "OneWireMaster.h"
+
+#if PROXY_ENABLE
+
+#include "DS2502.h"
+
+#if !defined(__AVR__)
+#error "The proxy keeps the adapter in the EEPROM of the AVR"
+#endif
+
+#include <avr/eeprom.h>
+
+// eeprom_read_byte() is a call, the 4 cycles the cpu halts for the read and a few more than lpm, the read engine of
+// OneWireMemory still does less per byte than DS2502::duty() before it. waits while the EEPROM is written (BOOT_BENCH_ENABLE)
+struct CachedDS2502Layout : DS2502Layout
+{
+    static uint8_t readImage(const uint8_t *const address) { return eeprom_read_byte(address); };
+};
+
+extern template class OneWireMemory<CachedDS2502Layout>; // instantiated once, in ChargerProxy.cpp
+
+class CachedDS2502 : public OneWireMemory<CachedDS2502Layout>
+{
+public:
+    // rom, status and image are placeholders until ChargerProxy::load()
+    constexpr CachedDS2502(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7)
+        : OneWireMemory(ID1, ID2, ID3, ID4, ID5, ID6, ID7){};
+};
+
+class ChargerProxy
+{
+public:
+    enum class Result : uint8_t
+    {
+        OK = 0,
+        NO_DEVICE = 1,   // no presence or no DS2502 (family code, crc of the ROM)
+        READ_ERROR = 2,  // reading the adapter did not get through the crcs, also not with the retries
+        TOO_BIG = 3,     // programmed bytes beyond the space of the EEPROM, nothing is served
+        VERIFY_ERROR = 4 // image read back from EEPROM does not match the crc of the adapter
+    };
+
+private:
+    static constexpr uint8_t MEM_SIZE{128};
+    static constexpr uint8_t STATUS_SIZE{8};
+
+    static constexpr uint8_t IMAGE_LIMIT{BOOT_BENCH_EEPROM_ADDR - PROXY_EEPROM_IMAGE}; // programmed bytes that fit
+
+    OneWireMaster &master;
+
+    bool readRom(uint8_t rom[8]);
+    bool readFromStart(uint8_t cmd, uint8_t data[], uint8_t data_length); // READ STATUS, returns true if both crcs match
+    bool readImage(uint8_t &length, uint8_t &crc);                        // READ MEMORY into EEPROM, false on a crc error
+
+    static uint8_t recordCrc(uint8_t length);
+
+public:
+    explicit ChargerProxy(OneWireMaster &master);
+
+    Result learn(void); // reads the adapter on the master pin and stores it, an earlier record is invalid from the first write on
+
+    static bool load(CachedDS2502 &device); // returns false if there is no complete record, the device stays as it is
+};
+
+#endif
+#endif
@@ -0,0 +1,3 @@
+#include "DS2431.h"
+
+template class OneWireMemory<DS2431Layout>; // duty() and the status functions, see OneWireMemory.h
@@ -0,0 +1,52 @@
+// 1Kbit 1-Wire EEPROM: 4 pages, the 8 registers follow at 0x80 and are read with the memory
+// READ MEMORY only and without crc like the part, the scratchpad commands (writes) end the transaction
+// registers: page protection 0x80-0x83 (0x55 protects, 0xAA eprom mode), copy protection 0x84, factory byte 0x85, manufacturer
+// id 0x86-0x87 -> writeStatus(0x80 + n, value), they start as 0xFF (unprotected)
+// native bus-features: none
+
+#ifndef ONEWIRE_DS2431_H
+#define ONEWIRE_DS2431_H
+
+#include "OneWireMemory.h"
+
+struct DS2431Layout
+{
+    static constexpr uint8_t family_code{0x2D};
+    static constexpr uint8_t PAGE_COUNT{4};
+    static constexpr uint8_t PAGE_SHIFT{5}; // 32 bytes per page
+
+    static constexpr uint8_t STATUS_SIZE{8};
+    static constexpr uint16_t STATUS_END{0x88};
+
+    static constexpr uint16_t STATUS_PROTECT{MEMORY_STATUS_NONE}; // a byte per page, not a bitmap
+    static constexpr uint16_t STATUS_USED{MEMORY_STATUS_NONE};
+    static constexpr uint8_t STATUS_USED_SHIFT{0};
+    static constexpr uint16_t STATUS_REDIRECT{MEMORY_STATUS_NONE};
+
+    static constexpr bool STATUS_IN_MEMORY{true};
+    static constexpr bool STATUS_EPROM{false};
+
+    static constexpr bool READ_STATUS{false};   // 0xAA is READ SCRATCHPAD here
+    static constexpr bool READ_PAGE_CRC{false};
+
+    using crc_t = OneWireNoCrc;
+
+    static constexpr uint16_t statusIndex(const uint16_t address) { return ((address >= 0x80) && (address < STATUS_END)) ? uint16_t(address - 0x80) : MEMORY_STATUS_NONE; };
+
+    static constexpr uint8_t statusInit(const uint8_t) { return 0xFF; };
+
+    static uint8_t readImage(const uint8_t *const address) { return pgm_read_byte(address); };
+};
+
+extern template class OneWireMemory<DS2431Layout>; // instantiated once, in DS2431.cpp
+
+class DS2431 : public OneWireMemory<DS2431Layout>
+{
+public:
+    // image_P has to point to flash (PROGMEM), without one the memory reads as unprogrammed
+    constexpr DS2431(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7,
+                     const uint8_t *image_P = nullptr, uint8_t image_length = 0)
+        : OneWireMemory(ID1, ID2, ID3, ID4, ID5, ID6, ID7, image_P, image_length){};
+};
+
+#endif
@@ -0,0 +1,3 @@
+#include "DS2501.h"
+
+template class OneWireMemory<DS2501Layout>; // duty() and the status functions, see OneWireMemory.h
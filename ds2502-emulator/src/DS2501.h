@@ -0,0 +1,26 @@
+// 512bit 1-Wire EEPROM, Add Only Memory: the DS2502 with 2 pages, same status and commands
+// native bus-features: none
+
+#ifndef ONEWIRE_DS2501_H
+#define ONEWIRE_DS2501_H
+
+#include "OneWireMemory.h"
+
+struct DS2501Layout : OneWireEpromLayout
+{
+    static constexpr uint8_t family_code{0x11};
+    static constexpr uint8_t PAGE_COUNT{2};
+};
+
+extern template class OneWireMemory<DS2501Layout>; // instantiated once, in DS2501.cpp
+
+class DS2501 : public OneWireMemory<DS2501Layout>
+{
+public:
+    // image_P has to point to flash (PROGMEM), without one the memory reads as unprogrammed
+    constexpr DS2501(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7,
+                     const uint8_t *image_P = nullptr, uint8_t image_length = 0)
+        : OneWireMemory(ID1, ID2, ID3, ID4, ID5, ID6, ID7, image_P, image_length){};
+};
+
+#endif
@@ -0,0 +1,3 @@
+#include "DS2505.h"
+
+template class OneWireMemory<DS2505Layout>; // duty() and the status functions, see OneWireMemory.h
@@ -0,0 +1,52 @@
+// 16Kbit 1-Wire EEPROM, Add Only Memory: 64 pages with redirection, inverted crc16 instead of crc8
+// status memory (88 bytes) is spread over its address space: write protection of the pages at 0x000, of the redirection
+// bytes at 0x020, used pages at 0x040, redirection at 0x100. the gaps read as 0xFF
+// the image (2KB) and 216 bytes of RAM do not fit an attiny, this one is for bigger mcus
+// native bus-features: none
+
+#ifndef ONEWIRE_DS2505_H
+#define ONEWIRE_DS2505_H
+
+#include "OneWireMemory.h"
+
+struct DS2505Layout : OneWireEpromLayout
+{
+    static constexpr uint8_t family_code{0x0B};
+    static constexpr uint8_t PAGE_COUNT{64};
+
+    static constexpr uint8_t STATUS_SIZE{88};
+    static constexpr uint16_t STATUS_END{0x140};
+
+    static constexpr uint16_t STATUS_PROTECT{0};   // 0x000 - 0x007
+    static constexpr uint16_t STATUS_USED{16};     // 0x040 - 0x047
+    static constexpr uint8_t STATUS_USED_SHIFT{0};
+    static constexpr uint16_t STATUS_REDIRECT{24}; // 0x100 - 0x13F
+
+    static constexpr bool READ_PAGE_CRC{false};
+
+    using crc_t = uint16_t;
+
+    static constexpr uint16_t statusIndex(const uint16_t address)
+    {
+        return (address < 0x008)                       ? address
+               : ((address >= 0x020) && (address < 0x028)) ? uint16_t(address - 0x020 + 8)
+               : ((address >= 0x040) && (address < 0x048)) ? uint16_t(address - 0x040 + 16)
+               : ((address >= 0x100) && (address < 0x140)) ? uint16_t(address - 0x100 + 24)
+                                                           : MEMORY_STATUS_NONE;
+    };
+
+    static constexpr uint8_t statusInit(const uint8_t) { return 0xFF; };
+};
+
+extern template class OneWireMemory<DS2505Layout>; // instantiated once, in DS2505.cpp
+
+class DS2505 : public OneWireMemory<DS2505Layout>
+{
+public:
+    // image_P has to point to flash (PROGMEM), without one the memory reads as unprogrammed
+    constexpr DS2505(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7,
+                     const uint8_t *image_P = nullptr, uint16_t image_length = 0)
+        : OneWireMemory(ID1, ID2, ID3, ID4, ID5, ID6, ID7, image_P, image_length){};
+};
+
+#endif
@@ -3,28 +3,69 @@
 
 #include "platform.h"
 
-OneWireHub::OneWireHub(const uint8_t pin)
+#if WATCHDOG_ENABLE
+static ResetRecord reset_record __attribute__((section(".noinit")));
+static constexpr uint8_t RESTART_STUCK_LINE{0xA5}; // marks a restart requested by waitStuckLine()
+static uint8_t restart_request __attribute__((section(".noinit")));
+static bool stuck_restarted __attribute__((section(".noinit"))); // only one restart per stuck episode, the line may be held by someone else
+
+#if defined(__AVR__)
+// runs before .data/.bss init and constructors: after a watchdog-reset the watchdog stays enabled with its shortest timeout, so it has to go first
+__attribute__((naked, used, section(".init3"))) static void watchdogBoot(void)
 {
-    _error = Error::NO_ERROR;
-
-    slave_list = nullptr;
-
-    // prepare pin
-    pin_bitMask = PIN_TO_BITMASK(pin);
-    pin_baseReg = PIN_TO_BASEREG(pin);
-    pinMode(pin, INPUT); // first port-access should by done by this FN, does more than DIRECT_MODE_....
-    DIRECT_WRITE_LOW(pin_baseReg, pin_bitMask);
+    const uint8_t mcusr = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
 
-    static_assert(VALUE_IPL, "Your architecture has not been calibrated yet, please run examples/debug/calibrate_by_bus_timing and report instructions per loop (IPL) to https://github.com/orgua/OneWireHub");
-    static_assert(ONEWIRE_TIME_VALUE_MIN > 2, "YOUR ARCHITECTURE IS TOO SLOW, THIS MAY RESULT IN TIMING-PROBLEMS"); // it could work though, never tested
+    if (mcusr & _BV(WDRF))
+    {
+        reset_record.cause = (restart_request == RESTART_STUCK_LINE) ? ResetCause::STUCK_LINE : ResetCause::WATCHDOG;
+        ++reset_record.count;
+    }
+    else
+    {
+        // .noinit only survives watchdog-resets meaningfully: brown-out, external and a jump to 0 (no flag) may leave garbage behind
+        if (mcusr & _BV(PORF))
+            reset_record.cause = ResetCause::POWER_ON;
+        else if (mcusr & _BV(BORF))
+            reset_record.cause = ResetCause::BROWN_OUT;
+        else
+            reset_record.cause = ResetCause::EXTERNAL;
+        reset_record.error = Error::NO_ERROR;
+        reset_record.count = 0;
+        stuck_restarted = false;
+    }
+    restart_request = 0;
 }
+#endif
+#endif
 
+#if !STATIC_DISPATCH_ENABLE
 // attach a sensor to the hub
 void OneWireHub::attach(OneWireItem &sensor)
 {
     slave_list = &sensor;
+    start();
+}
+#endif
+
+void OneWireHub::start(void)
+{
+    // prepare pin, not in the constructor: that one is constexpr so the hub needs no run-time initialisation
+    pin_bitMask = PIN_TO_BITMASK(pin);
+    pin_baseReg = PIN_TO_BASEREG(pin);
+    pinMode(pin, INPUT); // first port-access should by done by this FN, does more than DIRECT_MODE_....
+    DIRECT_WRITE_LOW(pin_baseReg, pin_bitMask);
+
+#if USI_ENGINE_ENABLE
+    usiAttach();
+#endif
+#if WATCHDOG_ENABLE
+    wdt_enable(WATCHDOG_TIMEOUT); // supervision starts here, poll() has to be called continuously from now on
+#endif
 }
 
+#if !STATIC_DISPATCH_ENABLE
 bool OneWireHub::detach(const OneWireItem &sensor)
 {
     return 0;
@@ -45,21 +86,95 @@ bool OneWireHub::poll(void)
         // if (slave_count == 0)
         //     return true;
 
-        // Once reset is done, go to next step
-        if (checkReset())
-            return false;
-
-        // Reset is complete, tell the master we are present
-        if (showPresence())
-            return false;
+        // reset and presence, plus the upkeep that fits in between transactions
+        if (waitForCmd())
+            return pollFailed();
 
         // Now that the master should know we are here, we will get a command from the master
         if (recvAndProcessCmd())
-            return false;
+            return pollFailed();
 
         // on total success we want to start again, because the next reset could only be ~125 us away
     }
 }
+#endif
+
+bool OneWireHub::waitForCmd(void)
+{
+#if WATCHDOG_ENABLE
+    wdt_reset();
+#endif
+
+#if ADAPTIVE_TIMING_ENABLE
+    if (learn_bits == ADAPTIVE_LEARN_BITS)
+        learnTiming(); // between transactions, the master waits for our presence
+#endif
+
+#if POWERUP_PRESENCE_ENABLE
+    // line came up, announce the device before the master asks
+    if (powerup_armed && showPowerUpPresence())
+        return true;
+#endif
+
+    // Once reset is done, go to next step
+    if (checkReset())
+        return true;
+
+    // Reset is complete, tell the master we are present
+    if (showPresence())
+        return true;
+
+#if USI_ENGINE_ENABLE
+    usiSync(); // reset and presence went through the USI as well
+#endif
+
+#if WATCHDOG_ENABLE
+    stuck_restarted = false; // bus is alive, a new stuck episode may restart the mcu again
+#endif
+    return false;
+}
+
+#if WATCHDOG_ENABLE
+bool OneWireHub::pollFailed(void)
+{
+    if (_error == Error::NO_ERROR)
+        return false;
+
+    reset_record.error = _error;
+
+    if ((_error == Error::VERY_LONG_RESET) || (_error == Error::PRESENCE_LOW_ON_LINE))
+        waitStuckLine();
+
+    return false;
+}
+
+// the bus is held low far beyond a reset: make sure it is not us, then wait for it with the watchdog fed.
+// if it stays low for STUCK_LINE_PERIODS the mcu restarts once to get rid of any wedged state, after that it just listens
+void OneWireHub::waitStuckLine(void)
+{
+    DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+
+    uint8_t periods = STUCK_LINE_PERIODS;
+    while (waitLoopsWhilePinIs(ONEWIRE_TIME_RESET_MAX[0], false) == 0)
+    {
+        wdt_reset();
+
+        if ((periods != 0) && (--periods == 0) && !stuck_restarted)
+        {
+            stuck_restarted = true;
+            restart_request = RESTART_STUCK_LINE;
+            wdt_enable(WDTO_15MS);
+            while (true)
+                ;
+        }
+    }
+}
+
+const ResetRecord &OneWireHub::getResetRecord(void)
+{
+    return reset_record;
+}
+#endif
 
 bool OneWireHub::checkReset(void) // there is a specific high-time needed before a reset may occur -->  >120us
 {
@@ -74,11 +189,26 @@ bool OneWireHub::checkReset(void) // there is a specific high-time needed before
 
     DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
 
+#if ADAPTIVE_TIMING_ENABLE
+    learn_zero = false; // the low that follows is no write-zero
+#endif
+
     // is entered if there are two resets within a given time (timeslot-detection can issue this skip)
+    // sendBit() / recvBit() found the bus low for SLOT_MAX while waiting for the end of a slot (the low may have started up to READ_MAX
+    // before they looked), or sendBit() found it still low READ_MAX after the falling edge of a read slot -> only the rest of RESET_MIN is missing
     if (_error == Error::RESET_IN_PROGRESS)
     {
         _error = Error::NO_ERROR;
-        if (waitLoopsWhilePinIs(ONEWIRE_TIME_RESET_MIN[od_mode] - ONEWIRE_TIME_SLOT_MAX[od_mode] - ONEWIRE_TIME_READ_MAX[od_mode], false) == 0) // last number should read: max(ONEWIRE_TIME_WRITE_ZERO,ONEWIRE_TIME_READ_MAX)
+        const bool in_slot = reset_in_slot;
+        reset_in_slot = false;
+#if USI_ENGINE_ENABLE
+        // the engine reports it after USI_TIME_RESET_US of low, only the end of the reset is missing
+        waitLoopsWhilePinIs(ONEWIRE_TIME_RESET_MAX[0], false);
+        return false;
+#endif
+        const timeOW_t loops_missing = in_slot ? (timeResetMin() - ONEWIRE_TIME_READ_MAX[od_mode])
+                                               : (timeResetMin() - timeSlotMax() - ONEWIRE_TIME_READ_MAX[od_mode]); // last number should read: max(ONEWIRE_TIME_WRITE_ZERO,ONEWIRE_TIME_READ_MAX)
+        if (waitLoopsWhilePinIs(loops_missing, false) == 0)
         {
 #if OVERDRIVE_ENABLE
             const timeOW_t loops_remaining = waitLoopsWhilePinIs(ONEWIRE_TIME_RESET_MAX[0], false); // showPresence() wants to start at high, so wait for it
@@ -109,6 +239,9 @@ bool OneWireHub::checkReset(void) // there is a specific high-time needed before
     if (loops_remaining == 0)
     {
         _error = Error::VERY_LONG_RESET;
+#if POWERUP_PRESENCE_ENABLE
+        powerup_armed = true; // no master resets that long -> unplugged (or stuck), the line coming up again is a plug-in
+#endif
         return true;
     }
 
@@ -119,10 +252,19 @@ bool OneWireHub::checkReset(void) // there is a specific high-time needed before
     };
 #endif
 
+#if ADAPTIVE_TIMING_ENABLE
+    if (learn_bits < ADAPTIVE_LEARN_BITS)
+    {
+        const timeOW_t loops_reset = ONEWIRE_TIME_RESET_MAX[0] - loops_remaining;
+        if ((loops_reset > ONEWIRE_TIME_ADAPT_RESET_MIN_LOW) && (loops_reset < seen_reset_min))
+            seen_reset_min = static_cast<uint16_t>(loops_reset);
+    }
+#endif
+
     // If the master pulled low for to short this will trigger an error
     // if (loops_remaining > (ONEWIRE_TIME_RESET_MAX[0] - ONEWIRE_TIME_RESET_MIN[od_mode])) _error = Error::VERY_SHORT_RESET; // could be activated again, like the error above, errorhandling is mature enough now
 
-    return (loops_remaining > (ONEWIRE_TIME_RESET_MAX[0] - ONEWIRE_TIME_RESET_MIN[od_mode]));
+    return (loops_remaining > (ONEWIRE_TIME_RESET_MAX[0] - timeResetMin()));
 }
 
 bool OneWireHub::showPresence(void)
@@ -147,12 +289,35 @@ bool OneWireHub::showPresence(void)
     if (waitLoopsWhilePinIs((ONEWIRE_TIME_PRESENCE_MAX[od_mode] - ONEWIRE_TIME_PRESENCE_MIN[od_mode]), false) == 0)
     {
         _error = Error::PRESENCE_LOW_ON_LINE;
+#if POWERUP_PRESENCE_ENABLE
+        powerup_armed = true; // unplugged right after a reset or in the middle of a transaction
+#endif
         return true;
     }
 
     return false;
 }
 
+#if POWERUP_PRESENCE_ENABLE
+// a real DS2502 pulls the line low once it gets powered by the pull-up of the master, it signals its arrival without a reset.
+// the hub does the same at power-up and after a disconnect: the pulse follows the rising edge, a master with hot-plug detection queries right away
+bool OneWireHub::showPowerUpPresence(void)
+{
+    DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+
+    // still disconnected: stay armed and let poll() come back, like a line that stays low after a reset
+    if (waitLoopsWhilePinIs(ONEWIRE_TIME_RESET_TIMEOUT, false) == 0)
+    {
+        _error = Error::VERY_LONG_RESET;
+        return true;
+    }
+
+    powerup_armed = false;
+    return showPresence(); // waits PRESENCE_TIMEOUT of high first, like after a reset
+}
+#endif
+
+#if !STATIC_DISPATCH_ENABLE
 bool OneWireHub::recvAndProcessCmd(void)
 {
     uint8_t address[8], cmd;
@@ -181,6 +346,7 @@ bool OneWireHub::recvAndProcessCmd(void)
 
     return (_error != Error::NO_ERROR);
 }
+#endif
 
 // info: check for errors after calling and break/return if possible, returns true if error is detected
 // NOTE: if called separately you need to handle interrupts, should be disabled during this FN
@@ -188,21 +354,23 @@ bool OneWireHub::sendBit(const bool value)
 {
     const bool writeZero = !value;
 
+#if WATCHDOG_ENABLE
+    wdt_reset(); // bit-slots can be 15ms apart, so a byte-wise feed is not enough
+#endif
+
     // Wait for bus to rise HIGH, signaling end of last timeslot
-    timeOW_t retries = ONEWIRE_TIME_SLOT_MAX[od_mode];
+    timeOW_t retries = timeSlotMax();
     while ((DIRECT_READ(pin_baseReg, pin_bitMask) == 0) && (--retries != 0))
         ;
     if (retries == 0)
     {
         _error = Error::RESET_IN_PROGRESS;
+        reset_in_slot = false;
         return true;
     }
 
     // Wait for bus to fall LOW, start of new timeslot
-    retries = ONEWIRE_TIME_MSG_HIGH_TIMEOUT;
-    while ((DIRECT_READ(pin_baseReg, pin_bitMask) != 0) && (--retries != 0))
-        ;
-    if (retries == 0)
+    if (waitLoopsForSlot(ONEWIRE_TIME_MSG_HIGH_TIMEOUT) == 0)
     {
         _error = Error::AWAIT_TIMESLOT_TIMEOUT_HIGH;
         return true;
@@ -213,19 +381,29 @@ bool OneWireHub::sendBit(const bool value)
     {
         DIRECT_MODE_OUTPUT(pin_baseReg, pin_bitMask);
         retries = ONEWIRE_TIME_WRITE_ZERO[od_mode];
+        while ((DIRECT_READ(pin_baseReg, pin_bitMask) == 0) && (--retries != 0))
+            ;
+        DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+        retries = ONEWIRE_TIME_READ_MAX[od_mode] - ONEWIRE_TIME_WRITE_ZERO[od_mode];
     }
     else
     {
         retries = ONEWIRE_TIME_READ_MAX[od_mode];
     }
 
-    while ((DIRECT_READ(pin_baseReg, pin_bitMask) == 0) && (--retries != 0))
-        ; // TODO: we should check for (!retries) because there could be a reset in progress...
-    DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+    // a read-slot of the master is short, still low after READ_MAX means the master stopped reading and sends a reset.
+    // hand it to checkReset() right away instead of finding it in the next sendBit() or after a timeout
+    if (waitLoopsWhilePinIs(retries, false) == 0)
+    {
+        _error = Error::RESET_IN_PROGRESS;
+        reset_in_slot = true;
+        return true;
+    }
 
     return false;
 }
 
+#if !USI_ENGINE_ENABLE
 // should be the preferred function for writes, returns true if error occurred
 bool OneWireHub::send(const uint8_t address[], const uint8_t data_length)
 {
@@ -285,6 +463,8 @@ bool OneWireHub::send(const uint8_t address[], const uint8_t data_length, uint16
     return (bytes_sent != data_length);
 }
 
+#endif
+
 bool OneWireHub::send(const uint8_t dataByte)
 {
     return send(&dataByte, 1);
@@ -293,34 +473,80 @@ bool OneWireHub::send(const uint8_t dataByte)
 // NOTE: if called separately you need to handle interrupts, should be disabled during this FN
 bool OneWireHub::recvBit(void)
 {
+#if WATCHDOG_ENABLE
+    wdt_reset();
+#endif
+
     // Wait for bus to rise HIGH, signaling end of last timeslot
-    timeOW_t retries = ONEWIRE_TIME_SLOT_MAX[od_mode];
+    timeOW_t retries = timeSlotMax();
     while ((DIRECT_READ(pin_baseReg, pin_bitMask) == 0) && (--retries != 0))
         ;
     if (retries == 0)
     {
         _error = Error::RESET_IN_PROGRESS;
+        reset_in_slot = false;
         return true;
     }
 
+#if ADAPTIVE_TIMING_ENABLE
+    if (learn_zero)
+    {
+        // the zero was sampled READ_MIN into the slot, the rest of it was spent above
+        const uint16_t loops_zero = static_cast<uint16_t>(time_read_min + time_slot_max - retries);
+        if (loops_zero < seen_zero_min)
+            seen_zero_min = loops_zero;
+        if (loops_zero > seen_zero_max)
+            seen_zero_max = loops_zero;
+        learn_zero = false;
+    }
+#endif
+
     // Wait for bus to fall LOW, start of new timeslot
-    retries = ONEWIRE_TIME_MSG_HIGH_TIMEOUT;
-    while ((DIRECT_READ(pin_baseReg, pin_bitMask) != 0) && (--retries != 0))
-        ;
-    if (retries == 0)
+    if (waitLoopsForSlot(ONEWIRE_TIME_MSG_HIGH_TIMEOUT) == 0)
     {
         _error = Error::AWAIT_TIMESLOT_TIMEOUT_HIGH;
         return true;
     }
 
+#if GLITCH_FILTER_ENABLE
+    static_assert(ONEWIRE_TIME_READ_MIN[0] > (ONEWIRE_TIME_GLITCH_MIN[0] + ONEWIRE_TIME_SAMPLE_GAP[0]), "Timings are wrong");
+    static_assert(ONEWIRE_TIME_READ_MAX[0] > (ONEWIRE_TIME_READ_MIN[0] + ONEWIRE_TIME_SAMPLE_GAP[0]), "Timings are wrong");
+
+    // majority of three samples around the read point, one spike can't flip the bit (the edge-filter already took GLITCH_MIN)
+    wait(ONEWIRE_TIME_READ_MIN[od_mode] - ONEWIRE_TIME_GLITCH_MIN[od_mode] - ONEWIRE_TIME_SAMPLE_GAP[od_mode]);
+    uint8_t ones = DIRECT_READ(pin_baseReg, pin_bitMask);
+    wait(ONEWIRE_TIME_SAMPLE_GAP[od_mode]);
+    ones += DIRECT_READ(pin_baseReg, pin_bitMask);
+    wait(ONEWIRE_TIME_SAMPLE_GAP[od_mode]);
+    ones += DIRECT_READ(pin_baseReg, pin_bitMask);
+
+    return (ones > 1);
+#else
     // wait a specific time to do a read (data is valid by then), // first difference to inner-loop of write()
-    retries = ONEWIRE_TIME_READ_MIN[od_mode];
+    retries = timeReadMin();
     while ((DIRECT_READ(pin_baseReg, pin_bitMask) == 0) && (--retries != 0))
         ;
 
+#if ADAPTIVE_TIMING_ENABLE
+    if (learn_bits < ADAPTIVE_LEARN_BITS)
+    {
+        ++learn_bits;
+        if (retries > 0)
+        {
+            const uint16_t loops_one = static_cast<uint16_t>(time_read_min - retries);
+            if (loops_one > seen_one_max)
+                seen_one_max = loops_one;
+        }
+        else
+            learn_zero = true; // length is known when the next bit starts
+    }
+#endif
+
     return (retries > 0);
+#endif
 }
 
+#if !USI_ENGINE_ENABLE
 bool OneWireHub::recv(uint8_t address[], const uint8_t data_length)
 {
     noInterrupts(); // will be enabled at the end of function
@@ -395,6 +621,8 @@ bool OneWireHub::recv(uint8_t address[], const uint8_t data_length, uint16_t &cr
     return (bytes_received != data_length);
 }
 
+#endif
+
 void OneWireHub::wait(const uint16_t timeout_us) const
 {
     timeOW_t loops = timeUsToLoops(timeout_us);
@@ -427,11 +655,67 @@ timeOW_t OneWireHub::waitLoopsWhilePinIs(volatile timeOW_t retries, const bool p
     return retries;
 }
 
+#if ADAPTIVE_TIMING_ENABLE
+// runs once between two transactions, keeps the defaults for windows that were not observed
+void OneWireHub::learnTiming(void)
+{
+    learn_bits = ADAPTIVE_LEARN_BITS + 1;
+
+    if ((seen_one_max != 0) && (seen_zero_min != 0xFFFF))
+    {
+        timeOW_t read_min = (static_cast<timeOW_t>(seen_one_max) + seen_zero_min) / 2;
+        if (read_min < ONEWIRE_TIME_ADAPT_READ_MIN_LOW)
+            read_min = ONEWIRE_TIME_ADAPT_READ_MIN_LOW;
+        if (read_min > ONEWIRE_TIME_ADAPT_READ_MIN_HIGH)
+            read_min = ONEWIRE_TIME_ADAPT_READ_MIN_HIGH;
+        time_read_min = read_min;
+
+        timeOW_t slot_max = static_cast<timeOW_t>(seen_zero_max) + (seen_zero_max / 4);
+        if (slot_max < ONEWIRE_TIME_ADAPT_SLOT_MAX_LOW)
+            slot_max = ONEWIRE_TIME_ADAPT_SLOT_MAX_LOW;
+        if (slot_max > ONEWIRE_TIME_SLOT_MAX[0])
+            slot_max = ONEWIRE_TIME_SLOT_MAX[0];
+        time_slot_max = slot_max;
+    }
+
+    if (seen_reset_min != 0xFFFF)
+    {
+        timeOW_t reset_min = static_cast<timeOW_t>(seen_reset_min) - (seen_reset_min / 8);
+        if (reset_min < ONEWIRE_TIME_ADAPT_RESET_MIN_LOW)
+            reset_min = ONEWIRE_TIME_ADAPT_RESET_MIN_LOW;
+        time_reset_min = reset_min;
+    }
+}
+#endif
+
+timeOW_t OneWireHub::waitLoopsForSlot(timeOW_t retries) const
+{
+#if GLITCH_FILTER_ENABLE
+    static_assert(timeUsToLoops(MASTER_TIME_WRITE_ONE_US) > (ONEWIRE_TIME_GLITCH_MIN[0] + 1), "write-one / read-slot lows of the master would be filtered as spikes");
+
+    while (true)
+    {
+        while ((DIRECT_READ(pin_baseReg, pin_bitMask) != 0) && (--retries != 0))
+            ;
+        if (retries == 0)
+            return 0;
+        // low has to last ONEWIRE_TIME_GLITCH_MIN to be a slot, shorter ones are spikes -> keep waiting
+        if (waitLoopsWhilePinIs(ONEWIRE_TIME_GLITCH_MIN[od_mode], false) == 0)
+            return retries;
+    }
+#else
+    while ((DIRECT_READ(pin_baseReg, pin_bitMask) != 0) && (--retries != 0))
+        ;
+    return retries;
+#endif
+}
+
 void OneWireHub::waitLoops1ms(void)
 {
     //
 }
 
+#ifndef ONEWIREHUB_BARE_METAL
 // this calibration calibrates timing with the longest low-state on the OW-Bus.
 // first it measures some resets with the millis()-fn to get real timing.
 // after that it measures with a waitLoops()-FN to determine the instructions-per-loop-value for the used architecture
@@ -492,6 +776,7 @@ timeOW_t OneWireHub::waitLoopsCalibrate(void)
 
     return value_ipl;
 }
+#endif
 
 void OneWireHub::waitLoopsDebug(void) const
 {
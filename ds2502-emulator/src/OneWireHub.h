@@ -57,6 +57,27 @@ enum class Error : uint8_t
     RESET_IN_PROGRESS = 15
 };
 
+enum class ResetCause : uint8_t
+{
+    POWER_ON = 0,
+    EXTERNAL = 1,
+    BROWN_OUT = 2,
+    WATCHDOG = 3,  // code got wedged, watchdog was not fed in time
+    STUCK_LINE = 4 // hub restarted itself, bus was held low for STUCK_LINE_PERIODS
+};
+
+// survives watchdog-resets (.noinit), is cleared by every other reset cause
+struct ResetRecord
+{
+    ResetCause cause;
+    Error error;   // last error poll() ran into before the reset
+    uint8_t count; // resets by watchdog or stuck-line since the last other reset
+};
+
+#if WATCHDOG_ENABLE
+constexpr uint8_t WATCHDOG_TIMEOUT{WDTO_60MS}; // worst case between two feeds is a bit-slot with ONEWIRE_TIME_MSG_HIGH_TIMEOUT (~15ms)
+#endif
+
 class OneWireItem;
 
 class OneWireHub
@@ -71,12 +92,56 @@ private:
     static constexpr bool od_mode{false};
 #endif
 
-    Error _error;
+protected:
+    Error _error; // OneWireHubStatic dispatches commands itself
 
+private:
     io_reg_t pin_bitMask;
     volatile io_reg_t *pin_baseReg;
+    uint8_t pin; // bitMask and baseReg get resolved in start()
+    bool reset_in_slot; // RESET_IN_PROGRESS was found inside a read slot (low since its falling edge), not while waiting for the end of one
 
+#if !STATIC_DISPATCH_ENABLE
     OneWireItem *slave_list; // private slave-list (use attach/detach)
+#endif
+
+#if ADAPTIVE_TIMING_ENABLE
+    timeOW_t time_read_min; // learned windows, start as the ONEWIRE_TIME_* defaults
+    timeOW_t time_slot_max;
+    timeOW_t time_reset_min;
+
+    uint16_t seen_one_max;   // longest write-one of the master in loops
+    uint16_t seen_zero_min;  // shortest write-zero
+    uint16_t seen_zero_max;  // longest write-zero
+    uint16_t seen_reset_min; // shortest reset
+    uint8_t learn_bits;      // master-bits observed, ADAPTIVE_LEARN_BITS -> learned windows get applied, above -> done
+    bool learn_zero;         // last bit was a zero, the next recvBit() measures its length
+
+    void learnTiming(void);
+#endif
+
+    // active windows, either the ONEWIRE_TIME_* constants or the learned ones
+    timeOW_t timeReadMin(void) const;
+    timeOW_t timeSlotMax(void) const;
+    timeOW_t timeResetMin(void) const;
+
+#if USI_ENGINE_ENABLE
+    void usiAttach(void); // takes USI, timer0 and timer1
+    void usiSync(void);   // after the presence pulse: the next slot is the first bit of a byte
+    void usiBegin(bool sending);
+    void usiEnd(void);
+    bool usiByte(uint8_t &data, bool sending); // returns true on reset or if no slot came
+#endif
+
+#if POWERUP_PRESENCE_ENABLE
+    bool powerup_armed; // set at power-up and when the line was low far beyond a reset (disconnect), cleared by the pulse
+
+    bool showPowerUpPresence(void); // returns true if error occurred
+#endif
+
+#if WATCHDOG_ENABLE
+    void waitStuckLine(void); // returns as soon as the bus is high again
+#endif
 
     // struct IDTree
     // {
@@ -95,7 +160,9 @@ private:
 
     bool checkReset(void);    // returns true if error occurred
     bool showPresence(void);  // returns true if error occurred
+#if !STATIC_DISPATCH_ENABLE
     bool recvAndProcessCmd(); // returns true if error occurred
+#endif
 
     void wait(timeOW_t loops_wait) const;
     void wait(uint16_t timeout_us) const;
@@ -104,8 +171,53 @@ private:
     timeOW_t
     waitLoopsWhilePinIs(volatile timeOW_t retries, bool pin_value = false) const;
 
+    inline __attribute__((always_inline))
+    timeOW_t
+    waitLoopsForSlot(timeOW_t retries) const; // returns 0 if the master did not start a timeslot
+
+protected:
+    // building blocks of poll(), OneWireHubStatic brings its own command dispatch
+    void start(void);      // engine and watchdog, once the devices are known
+    bool waitForCmd(void); // reset and presence, returns true if error occurred
+#if WATCHDOG_ENABLE
+    bool pollFailed(void); // keeps the reset-record up to date, returns false like poll() on error
+#else
+    bool pollFailed(void) { return false; };
+#endif
+
 public:
-    explicit OneWireHub(uint8_t pin);
+    // constexpr: a global hub is constant-initialised, the pin is set up in attach() / begin()
+    constexpr explicit OneWireHub(const uint8_t pin)
+        :
+#if OVERDRIVE_ENABLE
+          od_mode(false),
+#endif
+          _error(Error::NO_ERROR), pin_bitMask(0), pin_baseReg(nullptr), pin(pin), reset_in_slot(false)
+#if !STATIC_DISPATCH_ENABLE
+          ,
+          slave_list(nullptr)
+#endif
+#if ADAPTIVE_TIMING_ENABLE
+          ,
+          time_read_min(ONEWIRE_TIME_READ_MIN[0]), time_slot_max(ONEWIRE_TIME_SLOT_MAX[0]), time_reset_min(ONEWIRE_TIME_RESET_MIN[0]),
+          seen_one_max(0), seen_zero_min(0xFFFF), seen_zero_max(0), seen_reset_min(0xFFFF), learn_bits(0), learn_zero(false)
+#endif
+#if POWERUP_PRESENCE_ENABLE
+          ,
+          powerup_armed(true)
+#endif
+    {
+#if ADAPTIVE_TIMING_ENABLE
+        static_assert(!OVERDRIVE_ENABLE, "Adaptive timing only learns normal speed");
+        static_assert(!GLITCH_FILTER_ENABLE, "Adaptive timing measures with single samples, disable the glitch filter");
+        static_assert(ADAPTIVE_LEARN_BITS < 255, "learn_bits would overflow");
+        static_assert(ONEWIRE_TIME_ADAPT_READ_MIN_HIGH < ONEWIRE_TIME_READ_MAX[0], "Timings are wrong");
+        static_assert(ONEWIRE_TIME_ADAPT_RESET_MIN_LOW > (ONEWIRE_TIME_SLOT_MAX[0] + ONEWIRE_TIME_READ_MAX[0]), "Timings are wrong"); // checkReset() subtracts the learned SLOT_MAX (<= the constant) and READ_MAX from the learned RESET_MIN
+        static_assert(ONEWIRE_TIME_SLOT_MAX[0] < 0xFFFF, "seen_* would overflow");
+#endif
+        static_assert(VALUE_IPL, "Your architecture has not been calibrated yet, please run examples/debug/calibrate_by_bus_timing and report instructions per loop (IPL) to https://github.com/orgua/OneWireHub");
+        static_assert(ONEWIRE_TIME_VALUE_MIN > 2, "YOUR ARCHITECTURE IS TOO SLOW, THIS MAY RESULT IN TIMING-PROBLEMS"); // it could work though, never tested
+    };
 
     ~OneWireHub() = default; // nothing special to do here
 
@@ -115,6 +227,7 @@ public:
     OneWireHub &operator=(const OneWireHub &hub) = delete; // disallow copy assignment
     OneWireHub &operator=(OneWireHub &&hub) = delete;      // disallow move assignment
 
+#if !STATIC_DISPATCH_ENABLE
     void attach(OneWireItem &sensor);
     bool detach(const OneWireItem &sensor);
     bool detach(uint8_t slave_number);
@@ -122,6 +235,11 @@ public:
     uint8_t getIndexOfNextSensorInList(uint8_t index_start = 0) const;
 
     bool poll(void);
+#endif
+
+#if WATCHDOG_ENABLE
+    static const ResetRecord &getResetRecord(void); // why the mcu was reset last time
+#endif
 
     bool sendBit(bool value);                                                 // returns 1 if error occurred
     bool send(uint8_t dataByte);                                              // returns 1 if error occurred
@@ -134,7 +252,9 @@ public:
     bool recv(uint8_t address[], uint8_t data_length = 1);              // returns 1 if error occurred
     bool recv(uint8_t address[], uint8_t data_length, uint16_t &crc16); // returns 1 if error occurred
 
-    timeOW_t waitLoopsCalibrate(void); // returns Instructions per loop
+#ifndef ONEWIREHUB_BARE_METAL
+    timeOW_t waitLoopsCalibrate(void); // returns Instructions per loop, needs micros() of the core
+#endif
     void waitLoops1ms(void);
     void waitLoopsDebug(void) const;
 
@@ -146,4 +266,14 @@ public:
     Error clearError(void);
 };
 
+#if ADAPTIVE_TIMING_ENABLE
+inline timeOW_t OneWireHub::timeReadMin(void) const { return time_read_min; }
+inline timeOW_t OneWireHub::timeSlotMax(void) const { return time_slot_max; }
+inline timeOW_t OneWireHub::timeResetMin(void) const { return time_reset_min; }
+#else
+inline timeOW_t OneWireHub::timeReadMin(void) const { return ONEWIRE_TIME_READ_MIN[od_mode]; }
+inline timeOW_t OneWireHub::timeSlotMax(void) const { return ONEWIRE_TIME_SLOT_MAX[od_mode]; }
+inline timeOW_t OneWireHub::timeResetMin(void) const { return ONEWIRE_TIME_RESET_MIN[od_mode]; }
+#endif
+
 #endif
@@ -0,0 +1,120 @@
+// OneWireHub with its devices fixed at compile time: OneWireHubStatic<DS2502> hub(pin, device);
+// - the command byte is dispatched to Device::duty() directly, no vtable, no indirect call -> LTO can inline duty() into poll()
+// - ROM commands SKIP ROM (one device) and MATCH ROM, the bit-engine (wait-loops or USI) is the one of OneWireHub
+// - with STATIC_DISPATCH_ENABLE the devices lose their vtable, without it the calls are still resolved statically
+
+#ifndef ONEWIREHUB_ONEWIREHUBSTATIC_H
+#define ONEWIREHUB_ONEWIREHUBSTATIC_H
+
+#include "OneWireHub.h"
+#include "OneWireItem.h"
+
+// compile-time list of device references, walked by recursion (c++11 has no fold-expressions)
+template <typename... Devices>
+class OneWireDeviceList;
+
+template <>
+class OneWireDeviceList<>
+{
+public:
+    constexpr OneWireDeviceList(void){};
+
+    bool dutyMatching(OneWireHub *const hub, const uint8_t rom[8]) const { return false; };
+};
+
+template <typename Device, typename... Others>
+class OneWireDeviceList<Device, Others...>
+{
+private:
+    Device &device;
+    OneWireDeviceList<Others...> others;
+
+public:
+    constexpr OneWireDeviceList(Device &device, Others &...others) : device(device), others(others...){};
+
+    // qualified call: resolved at compile time even if Device is still polymorphic
+    void dutyFirst(OneWireHub *const hub) const { device.Device::duty(hub); };
+
+    // returns false if no device has this ROM, it stays quiet until the next reset then
+    bool dutyMatching(OneWireHub *const hub, const uint8_t rom[8]) const
+    {
+        if (memcmp(device.ID, rom, 8) == 0)
+        {
+            device.Device::duty(hub);
+            return true;
+        }
+        return others.dutyMatching(hub, rom);
+    };
+};
+
+template <typename... Devices>
+class OneWireHubStatic : public OneWireHub
+{
+private:
+    static_assert(sizeof...(Devices) > 0, "OneWireHubStatic needs at least one device");
+
+    const OneWireDeviceList<Devices...> devices;
+
+    bool recvAndDispatchCmd(void); // returns true if error occurred
+
+public:
+    constexpr explicit OneWireHubStatic(const uint8_t pin, Devices &...devices) : OneWireHub(pin), devices(devices...){};
+
+    void begin(void) { start(); }; // like attach() of OneWireHub, supervision starts here
+
+    bool poll(void);
+};
+
+template <typename... Devices>
+bool OneWireHubStatic<Devices...>::poll(void)
+{
+    _error = Error::NO_ERROR;
+
+    while (true)
+    {
+        if (waitForCmd())
+            return pollFailed();
+
+        if (recvAndDispatchCmd())
+            return pollFailed();
+    }
+}
+
+template <typename... Devices>
+bool OneWireHubStatic<Devices...>::recvAndDispatchCmd(void)
+{
+    uint8_t cmd, rom[8];
+
+    recv(&cmd);
+
+    if (_error == Error::RESET_IN_PROGRESS)
+        return false; // stay in poll()-loop and trigger another datastream-detection
+    if (_error != Error::NO_ERROR)
+        return true;
+
+    switch (cmd)
+    {
+    case 0xCC: // SKIP ROM, only one device may answer
+        if (sizeof...(Devices) == 1)
+            devices.dutyFirst(this);
+        else
+            _error = Error::INCORRECT_ONEWIRE_CMD;
+        break;
+
+    case 0x55: // MATCH ROM
+        if (recv(rom, 8))
+            break;
+        devices.dutyMatching(this, rom);
+        break;
+
+    default: // Unknown command
+        _error = Error::INCORRECT_ONEWIRE_CMD;
+    }
+
+    if (_error == Error::RESET_IN_PROGRESS)
+        return false;
+
+    return (_error != Error::NO_ERROR);
+}
+
+#endif // ONEWIREHUB_ONEWIREHUBSTATIC_H
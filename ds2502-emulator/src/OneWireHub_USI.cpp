@@ -0,0 +1,255 @@
+// alternative byte-engine for the ATtinyX5 (USI_ENGINE_ENABLE), replaces the bit-banged send() / recv()
+// - USI in two-wire mode: SDA (PB0) is open-drain and driven by the msb of USIDR, so the 1-Wire line has to be on PB0
+// - start-condition detector (SDA falls while SCL / PB2 is pulled high) marks the start of every slot
+// - timer0 compare A clocks the USI: one shift releases a write-zero and samples the master-bit at the same moment
+// - timer0 compare B catches a reset (line still low), otherwise it stops the timer until the next slot
+// - timer1 is restarted by every slot, its compare A ends a byte the master does not finish (AWAIT_TIMESLOT_TIMEOUT_HIGH)
+// the cpu only restarts the timer per slot (and loads the next bit while sending), bytes are handed over at the counter overflow
+
+#include "OneWireHub.h"
+#include "OneWireItem.h"
+
+#if USI_ENGINE_ENABLE
+
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#if !(defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__))
+#error "USI engine is written for the USI and timer0 of the ATtinyX5"
+#endif
+
+static constexpr uint8_t USI_TIMER_PRESCALER{_BV(CS01) | _BV(CS00)};            // CK/64 -> 8 us per tick @ 8 MHz
+static constexpr uint8_t USI_TIMEOUT_PRESCALER{_BV(CS13) | _BV(CS11) | _BV(CS10)}; // timer1 CK/1024 -> 128 us per tick @ 8 MHz
+static constexpr uint8_t USI_COUNT_BYTE{16 - 8};                       // 4 bit counter overflows after 8 shifts
+static constexpr uint8_t USI_TWO_WIRE{_BV(USIWM1) | _BV(USICS0)};      // two-wire without clock-hold, clocked by timer0 compare A
+
+// rounded to the nearest tick, not truncated
+constexpr uint32_t usiTicks(const uint16_t time_us)
+{
+    return (microsecondsToClockCycles(time_us) + 32) / 64;
+}
+
+constexpr uint32_t usiTicksToUs(const uint32_t ticks)
+{
+    return ticks * 64 / microsecondsToClockCycles(1);
+}
+
+constexpr uint32_t usiTimeoutTicks(const uint16_t time_us)
+{
+    return uint32_t(microsecondsToClockCycles(time_us)) / 1024;
+}
+
+static volatile bool usi_sending; // fall-isr puts the next bit on the line
+static volatile uint8_t usi_tx;   // rest of the byte that is sent, lsb next
+static volatile uint8_t usi_rx;   // USIDR at the overflow, first bit of the master is the msb
+static volatile bool usi_done;    // byte is through
+static volatile bool usi_reset;   // line was still low at USI_TIME_RESET_US
+static volatile bool usi_timeout; // no slot for USI_TIME_TIMEOUT_US
+
+// start of a slot, latency ~3 us @ 8 MHz (the master samples at ~15 us)
+ISR(USI_START_vect)
+{
+    if (usi_sending)
+    {
+        USIDR = (usi_tx & 0x01) ? 0xFF : 0x7F; // msb low drives the write-zero right away, the next shift releases it
+        usi_tx >>= 1;
+    }
+    GTCCR = _BV(PSR0); // prescaler starts with the slot, no jitter of one tick
+    TCNT0 = 0;
+    TCNT1 = 0; // the master is still there, restart the timeout
+    TCCR0B = USI_TIMER_PRESCALER;
+    USISR = _BV(USISIF) | (USISR & 0x0F); // release the start-detector, keep the bit counter
+}
+
+ISR(USI_OVF_vect)
+{
+    usi_rx = USIDR;
+    USISR = _BV(USIOIF) | USI_COUNT_BYTE;
+    usi_done = true;
+}
+
+// no slot is that long: stop the timer before compare A shifts again, a low line is a reset
+ISR(TIMER0_COMPB_vect)
+{
+    TCCR0B = 0;
+    if (!(PINB & _BV(PB0)))
+        usi_reset = true;
+}
+
+ISR(TIMER1_COMPA_vect)
+{
+    usi_timeout = true;
+}
+
+// after init() of the arduino core, timer0 is taken from millis()
+void OneWireHub::usiAttach(void)
+{
+    static_assert(usiTicks(USI_TIME_SLOT_US) > 1, "Timings are wrong");
+    static_assert(usiTicks(USI_TIME_RESET_US) < 256, "Timings are wrong");
+    static_assert(usiTimeoutTicks(USI_TIME_TIMEOUT_US) < 256, "timeout does not fit timer1, lower USI_TIME_TIMEOUT_US");
+    // checked with the rounded times: the shift is taken >= 1 tick after the edge-isr, that one comes ~3us late
+    static_assert(usiTicksToUs(usiTicks(USI_TIME_SLOT_US)) > 15 && (usiTicksToUs(usiTicks(USI_TIME_SLOT_US)) + 3) < 60,
+                  "write-zero has to last past the master sample, reading has to end before a write-zero does");
+    static_assert(USI_TIME_RESET_US > 120, "reset could be a slot");
+    static_assert(!OVERDRIVE_ENABLE, "USI engine only does normal speed");
+    static_assert(!GLITCH_FILTER_ENABLE && !ADAPTIVE_TIMING_ENABLE, "filter and learning are part of the bit-banged engine");
+
+    TCCR0B = 0;
+    TCCR0A = 0;
+    OCR0A = usiTicks(USI_TIME_SLOT_US);
+    OCR0B = usiTicks(USI_TIME_RESET_US);
+    TCCR1 = 0;
+    OCR1A = usiTimeoutTicks(USI_TIME_TIMEOUT_US);
+    TIMSK = (TIMSK & ~(_BV(TOIE0) | _BV(OCIE0A) | _BV(OCIE1B) | _BV(TOIE1))) | _BV(OCIE0B) | _BV(OCIE1A);
+
+    DDRB &= ~_BV(PB2); // SCL stays high -> every fall of SDA is a start condition
+    PORTB |= _BV(PB2);
+
+    USIDR = 0xFF;
+    USISR = _BV(USISIF) | _BV(USIOIF) | _BV(USIPF) | USI_COUNT_BYTE;
+    USICR = _BV(USISIE) | _BV(USIOIE) | USI_TWO_WIRE; // stays on, bit-banged reset and presence work with PORTB0 low
+}
+
+// the only point where the byte boundary is known, send() and recv() keep counter and flags: a slot or a reset that comes
+// between two of them is counted (or reported) by the next one
+void OneWireHub::usiSync(void)
+{
+    noInterrupts();
+    usi_sending = false;
+    usi_done = false;
+    usi_reset = false;
+    USIDR = 0xFF;
+    USISR = _BV(USIOIF) | USI_COUNT_BYTE;
+    interrupts();
+}
+
+void OneWireHub::usiBegin(const bool sending)
+{
+    if (sending)
+    {
+        USIDR = 0xFF; // received bits may be in there, a zero would drive the line. the fall-isr loads the bits from now on
+        DIRECT_WRITE_HIGH(pin_baseReg, pin_bitMask); // driver follows the msb of USIDR now
+        DIRECT_MODE_OUTPUT(pin_baseReg, pin_bitMask);
+    }
+}
+
+void OneWireHub::usiEnd(void)
+{
+    DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+    DIRECT_WRITE_LOW(pin_baseReg, pin_bitMask);
+    usi_sending = false;
+}
+
+// sends or receives one byte, the cpu sleeps meanwhile. returns true if the master sent a reset or did not start a slot in time
+bool OneWireHub::usiByte(uint8_t &data, const bool sending)
+{
+    usi_tx = data; // the last slot of the previous byte is over, the next one has not started yet
+    usi_sending = sending;
+
+    noInterrupts();
+    usi_timeout = false;
+    TCNT1 = 0;
+    TIFR = _BV(OCF1A);
+    TCCR1 = USI_TIMEOUT_PRESCALER;
+    while (!usi_done && !usi_reset && !usi_timeout)
+    {
+#if WATCHDOG_ENABLE
+        wdt_reset();
+#endif
+        sleep_enable();
+        interrupts(); // sei takes effect after the next instruction, no wake-up gets lost
+        sleep_cpu();
+        sleep_disable();
+        noInterrupts();
+    }
+    TCCR1 = 0;
+    const bool done = usi_done;
+    usi_done = false;
+    interrupts();
+
+    if (usi_reset)
+    {
+        _error = Error::RESET_IN_PROGRESS;
+        return true;
+    }
+
+    if (!done)
+    {
+        _error = Error::AWAIT_TIMESLOT_TIMEOUT_HIGH; // master paused, the watchdog would have restarted the mcu
+        return true;
+    }
+
+    // first bit of the master was shifted in first and ended as msb
+    uint8_t value = usi_rx;
+    value = uint8_t((value & 0xF0) >> 4) | uint8_t((value & 0x0F) << 4);
+    value = uint8_t((value & 0xCC) >> 2) | uint8_t((value & 0x33) << 2);
+    value = uint8_t((value & 0xAA) >> 1) | uint8_t((value & 0x55) << 1);
+    data = value;
+    return false;
+}
+
+bool OneWireHub::send(const uint8_t address[], const uint8_t data_length)
+{
+    usiBegin(true);
+    for (uint8_t bytes_sent = 0; bytes_sent < data_length; ++bytes_sent)
+    {
+        uint8_t data = address[bytes_sent];
+        if (usiByte(data, true))
+        {
+            usiEnd();
+            return true;
+        }
+    }
+    usiEnd();
+    return false;
+}
+
+bool OneWireHub::send(const uint8_t address[], const uint8_t data_length, uint16_t &crc16)
+{
+    usiBegin(true);
+    for (uint8_t bytes_sent = 0; bytes_sent < data_length; ++bytes_sent)
+    {
+        uint8_t data = address[bytes_sent];
+        if (usiByte(data, true))
+        {
+            usiEnd();
+            return true;
+        }
+        crc16 = OneWireItem::crc16(address[bytes_sent], crc16);
+    }
+    usiEnd();
+    return false;
+}
+
+bool OneWireHub::recv(uint8_t address[], const uint8_t data_length)
+{
+    usiBegin(false);
+    for (uint8_t bytes_received = 0; bytes_received < data_length; ++bytes_received)
+    {
+        if (usiByte(address[bytes_received], false))
+        {
+            usiEnd();
+            return true;
+        }
+    }
+    usiEnd();
+    return false;
+}
+
+bool OneWireHub::recv(uint8_t address[], const uint8_t data_length, uint16_t &crc16)
+{
+    usiBegin(false);
+    for (uint8_t bytes_received = 0; bytes_received < data_length; ++bytes_received)
+    {
+        if (usiByte(address[bytes_received], false))
+        {
+            usiEnd();
+            return true;
+        }
+        crc16 = OneWireItem::crc16(address[bytes_received], crc16);
+    }
+    usiEnd();
+    return false;
+}
+
+#endif
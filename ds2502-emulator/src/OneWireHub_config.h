@@ -7,37 +7,137 @@
 /////////////////////////////////////////////////////
 
 // INFO: had to go with a define because some compilers use constexpr as simple const --> massive problems
-#define HUB_SLAVE_LIMIT 1  // set the limit of the hub HERE, max is 32 devices
-#define OVERDRIVE_ENABLE 0 // support overdrive for the slaves
+#define HUB_SLAVE_LIMIT 1         // set the limit of the hub HERE, max is 32 devices
+#define OVERDRIVE_ENABLE 0        // support overdrive for the slaves
+#define FAST_BOOT_ENABLE 0        // sketch brings its own main(): no init() of the arduino core (millis-timer, pwm, adc), hub polls right after the static init
+#ifndef GLITCH_FILTER_ENABLE      // may come from the command line, e.g. a fleetsim with and without filter
+#define GLITCH_FILTER_ENABLE 0    // slot edges need a minimum low-width, recvBit() takes the majority of 3 samples -> a single spike from the dc-dc can't break a transaction
+#endif
+#define ADAPTIVE_TIMING_ENABLE 0  // measure reset, write-one and write-zero widths of the master, then move READ_MIN, SLOT_MAX and RESET_MIN to match (within bounds below)
+#define WATCHDOG_ENABLE 0         // hub feeds the watchdog in poll() and per bit, a wedged mcu restarts and is listening again within WATCHDOG_TIMEOUT
+#define POWERUP_PRESENCE_ENABLE 0 // presence pulse without a reset when the line comes up (power-up, plug-in after a disconnect) like a real DS2502, the master finds the device right away
+#ifndef STATIC_DISPATCH_ENABLE    // may come from the command line, "make size_dispatch" builds both
+#define STATIC_DISPATCH_ENABLE 0  // sketch uses OneWireHubStatic<devices>: command dispatch is resolved at compile time, devices lose their vtable, OneWireHub::attach() and poll() are gone
+#endif
+#define BOOT_BENCH_ENABLE 0       // needs FAST_BOOT_ENABLE, stores timer1-ticks (4 us each) from reset-vector to first poll() in EEPROM, see "make read_boot_bench"
+#define USI_ENGINE_ENABLE 0       // ATtinyX5 only, USI and timer0 clock the bits of send() / recv(), needs the 1-Wire line on PB0 (see README)
+#define MULTIHUB_ENABLE 0         // OneWireMultiHub: one mcu serves several independent buses (pins of one port), each with its own DS2502
+#define MULTIHUB_BUS_LIMIT 2      // buses of a OneWireMultiHub, max is 8 (one port), the clock limits it further: 2 @ 8 MHz, 4 @ 16 MHz (see README)
+#define DUMPER_ENABLE 0           // firmware is a 1-Wire master instead: dumps every adapter that gets plugged in to Serial (ATmega board, see README)
+#define PROGRAMMER_ENABLE 0       // firmware drives the DS2502_prog board instead: programs the next image of a queue into every DS2502 that gets inserted (ATmega board, see README)
+#define MEASURED_TIMING_ENABLE 0  // normal speed windows come from OneWireHub_measured.h, generated by tools/owtiming from captures of the master (see README)
+#define PROXY_ENABLE 0            // learns a genuine adapter once on a second pin (OneWireMaster, crc-checked), keeps it in EEPROM and serves it from there (see README)
 
 constexpr bool USE_SERIAL_DEBUG{false}; // give debug messages when printError() is called (be aware! it may produce heisenbugs, timing is critical) SHOULD NOT be enabled with < 20 MHz uC
 constexpr uint8_t GPIO_DEBUG_PIN{7};    // digital pin
 constexpr uint32_t REPETITIONS{5000};   // for measuring the loop-delay --> 10000L takes ~110ms on atmega328p@16Mhz
 
+constexpr uint8_t STUCK_LINE_PERIODS{20};       // bus held low for this many ONEWIRE_TIME_RESET_MAX (~20ms) -> hub restarts itself via watchdog, once per episode
+constexpr uint8_t BOOT_BENCH_EEPROM_ADDR{0x7F}; // last byte of the 128 byte EEPROM, only 0xFF-padding of the charger image lives there, the proxy stops below
+constexpr uint8_t DUMPER_RETRIES{3};            // more reads of an adapter when a crc does not match
+constexpr uint16_t DUMPER_POLL_MS{50};          // pause between the resets that look for a new adapter
+constexpr uint8_t PROGRAMMER_RETRIES{3};        // more tries of a read or of a byte that did not get through the crc or read-back
+constexpr uint16_t PROGRAMMER_POLL_MS{50};      // pause between the resets that look for a new chip
+constexpr uint8_t PROGRAMMER_PULSE_LEVEL{1};    // level of the PRGM pin that switches +12V onto the data line
+constexpr uint8_t PROXY_EEPROM_LENGTH{0x00};    // record of an adapter (learned by the proxy or written by tools/provision): programmed bytes of the image, 0xFF -> no record
+constexpr uint8_t PROXY_EEPROM_CRC{0x01};       // crc8 over length, rom, status and image
+constexpr uint8_t PROXY_EEPROM_ROM{0x02};       // 8 bytes
+constexpr uint8_t PROXY_EEPROM_STATUS{0x0A};    // 8 bytes
+constexpr uint8_t PROXY_EEPROM_IMAGE{0x12};     // the image from here up to BOOT_BENCH_EEPROM_ADDR
+constexpr uint8_t PROXY_RETRIES{3};             // more reads of the adapter when a crc does not match
+constexpr uint16_t PROXY_POLL_MS{50};           // pause between the resets that look for the adapter while nothing is learned
+
 static_assert(!(USE_SERIAL_DEBUG && (microsecondsToClockCycles(1) < 20)), "Serial debug is enabled in OW-Config. SHOULD NOT be enabled with < 20 MHz uC");
+static_assert(!BOOT_BENCH_ENABLE || FAST_BOOT_ENABLE, "Boot bench relies on timer1 untouched by the arduino init(), enable FAST_BOOT_ENABLE");
+static_assert((DUMPER_ENABLE + MULTIHUB_ENABLE + PROGRAMMER_ENABLE + PROXY_ENABLE) <= 1, "Dumper, multi-hub, programmer and proxy are different firmwares, enable only one");
 
 /// the following TIME-values are in microseconds and are taken mostly from the ds2408 datasheet
 //  arrays contain the normal timing value and the overdrive-value, the literal "_us" converts the value right away to a usable unit
 //  should be --> datasheet
 //  was       --> shagrat-legacy
 
+// normal speed windows of the hub in microseconds, the ONEWIRE_TIME_* below are built from them
+#if MEASURED_TIMING_ENABLE
+#include "OneWireHub_measured.h"
+#else
+constexpr uint16_t HUB_TIME_RESET_MIN_US{430};
+constexpr uint16_t HUB_TIME_RESET_MAX_US{960};
+constexpr uint16_t HUB_TIME_PRESENCE_TIMEOUT_US{20};
+constexpr uint16_t HUB_TIME_PRESENCE_MIN_US{160};
+constexpr uint16_t HUB_TIME_SLOT_MAX_US{135};
+constexpr uint16_t HUB_TIME_READ_MIN_US{20};
+constexpr uint16_t HUB_TIME_READ_MAX_US{60};
+constexpr uint16_t HUB_TIME_WRITE_ZERO_US{30};
+#endif
+
 // Reset: every low-state of the master between MIN & MAX microseconds will be recognized as a Reset
-constexpr timeOW_t ONEWIRE_TIME_RESET_TIMEOUT = {5000_us};      // for not hanging to long in reset-detection, lower value is better for more responsive applications, but can miss resets
-constexpr timeOW_t ONEWIRE_TIME_RESET_MIN[2] = {430_us, 48_us}; // should be 480
-constexpr timeOW_t ONEWIRE_TIME_RESET_MAX[2] = {960_us, 80_us}; // from ds2413
+constexpr timeOW_t ONEWIRE_TIME_RESET_TIMEOUT = {5000_us};                                    // for not hanging to long in reset-detection, lower value is better for more responsive applications, but can miss resets
+constexpr timeOW_t ONEWIRE_TIME_RESET_MIN[2] = {timeUsToLoops(HUB_TIME_RESET_MIN_US), 48_us}; // should be 480
+constexpr timeOW_t ONEWIRE_TIME_RESET_MAX[2] = {timeUsToLoops(HUB_TIME_RESET_MAX_US), 80_us}; // from ds2413
 
 // Presence: slave waits TIMEOUT and emits a low state after the reset with ~MIN length, if the bus stays low after that and exceeds MAX the hub will issue an error
-constexpr timeOW_t ONEWIRE_TIME_PRESENCE_TIMEOUT = {20_us};        // probe measures 25us, duration of high state between reset and presence
-constexpr timeOW_t ONEWIRE_TIME_PRESENCE_MIN[2] = {160_us, 8_us};  // was 125
-constexpr timeOW_t ONEWIRE_TIME_PRESENCE_MAX[2] = {480_us, 32_us}; // should be 280, was 480
+constexpr timeOW_t ONEWIRE_TIME_PRESENCE_TIMEOUT = {timeUsToLoops(HUB_TIME_PRESENCE_TIMEOUT_US)};  // probe measures 25us, duration of high state between reset and presence
+constexpr timeOW_t ONEWIRE_TIME_PRESENCE_MIN[2] = {timeUsToLoops(HUB_TIME_PRESENCE_MIN_US), 8_us}; // was 125
+constexpr timeOW_t ONEWIRE_TIME_PRESENCE_MAX[2] = {480_us, 32_us};                                 // should be 280, was 480
 
-constexpr timeOW_t ONEWIRE_TIME_MSG_HIGH_TIMEOUT = {15000_us}; // there can be these inactive / high timeperiods after reset / presence, this value defines the timeout for these
-constexpr timeOW_t ONEWIRE_TIME_SLOT_MAX[2] = {135_us, 30_us}; // should be 120, measured from falling edge to next falling edge
+constexpr timeOW_t ONEWIRE_TIME_MSG_HIGH_TIMEOUT = {15000_us};                              // there can be these inactive / high timeperiods after reset / presence, this value defines the timeout for these
+constexpr timeOW_t ONEWIRE_TIME_SLOT_MAX[2] = {timeUsToLoops(HUB_TIME_SLOT_MAX_US), 30_us}; // should be 120, measured from falling edge to next falling edge
 
 // read and write from the viewpoint of the slave!!!!
-constexpr timeOW_t ONEWIRE_TIME_READ_MIN[2] = {20_us, 4_us};   // should be 15, was 30, says when it is safe to read a valid bit
-constexpr timeOW_t ONEWIRE_TIME_READ_MAX[2] = {60_us, 10_us};  // low states (zeros) of a master should not exceed this time in a slot
-constexpr timeOW_t ONEWIRE_TIME_WRITE_ZERO[2] = {30_us, 8_us}; // the hub holds a zero for this long
+constexpr timeOW_t ONEWIRE_TIME_READ_MIN[2] = {timeUsToLoops(HUB_TIME_READ_MIN_US), 4_us};     // should be 15, was 30, says when it is safe to read a valid bit
+constexpr timeOW_t ONEWIRE_TIME_READ_MAX[2] = {timeUsToLoops(HUB_TIME_READ_MAX_US), 10_us};    // low states (zeros) of a master should not exceed this time in a slot
+constexpr timeOW_t ONEWIRE_TIME_WRITE_ZERO[2] = {timeUsToLoops(HUB_TIME_WRITE_ZERO_US), 8_us}; // the hub holds a zero for this long
+
+// glitch filter (GLITCH_FILTER_ENABLE), budget: slot-start is recognized GLITCH_MIN later (write-zero of the hub starts later, master samples at ~15us),
+// last sample is taken SAMPLE_GAP after READ_MIN (has to stay below READ_MAX). @8MHz one loop is ~1.6us, so both are one loop
+// a slot has to be low for GLITCH_MIN + one loop to be seen every time -> shortest write-one / read-slot low of the master (tLOW1, tRL) is ~3.3us, not the 1us of the datasheet
+constexpr timeOW_t ONEWIRE_TIME_GLITCH_MIN[2] = {2_us, 1_us}; // low-states shorter than this are spikes, not the start of a slot
+constexpr timeOW_t ONEWIRE_TIME_SAMPLE_GAP[2] = {3_us, 1_us}; // distance between the 3 samples of the majority vote, centered on READ_MIN
+
+// adaptive timing (ADAPTIVE_TIMING_ENABLE), normal speed only: after ADAPTIVE_LEARN_BITS bits of the master the windows are set once
+// - READ_MIN:  middle between the longest write-one (includes rise-time of the line) and the shortest write-zero
+// - SLOT_MAX:  longest write-zero + 1/4
+// - RESET_MIN: shortest reset - 1/8
+constexpr uint8_t ADAPTIVE_LEARN_BITS{64};                      // that is ~2 transactions of the dell (cmd, read-cmd, address)
+constexpr timeOW_t ONEWIRE_TIME_ADAPT_READ_MIN_LOW = {10_us};   // sample point never gets earlier than this
+constexpr timeOW_t ONEWIRE_TIME_ADAPT_READ_MIN_HIGH = {40_us};  // ... or later than this, must stay below READ_MAX
+constexpr timeOW_t ONEWIRE_TIME_ADAPT_SLOT_MAX_LOW = {70_us};   // learned slot max stays above the write-zero of the spec (60us)
+constexpr timeOW_t ONEWIRE_TIME_ADAPT_RESET_MIN_LOW = {300_us}; // no slot is that long, resets are only learned above this
+
+// 1-Wire master (OneWireMaster), standard speed values of maxim AN126 in microseconds, slots are 70us -> ~1.8 kByte/s
+constexpr uint16_t MASTER_TIME_RESET_US{480};          // H: reset low
+constexpr uint16_t MASTER_TIME_PRESENCE_SAMPLE_US{70}; // I: presence is sampled this long after the release
+constexpr uint16_t MASTER_TIME_RESET_REST_US{410};     // J: rest of the reset-high time
+constexpr uint16_t MASTER_TIME_WRITE_ONE_US{6};        // A: low of a write-one and of a read-slot
+constexpr uint16_t MASTER_TIME_WRITE_ONE_REST_US{64};  // B
+constexpr uint16_t MASTER_TIME_WRITE_ZERO_US{60};      // C
+constexpr uint16_t MASTER_TIME_WRITE_ZERO_REST_US{10}; // D
+constexpr uint16_t MASTER_TIME_READ_SAMPLE_US{9};      // E: sample after the end of A
+constexpr uint16_t MASTER_TIME_READ_REST_US{55};       // F
+
+// DS2502 programming pulse (PROGRAMMER_ENABLE), datasheet values in microseconds
+constexpr uint16_t PROGRAMMER_TIME_DELAY_US{5};   // tDP: end of the crc-slot to the pulse
+constexpr uint16_t PROGRAMMER_TIME_PULSE_US{500}; // tPROG: 480 to 5000
+constexpr uint16_t PROGRAMMER_TIME_VERIFY_US{5};  // tDV: end of the pulse to the slot that reads the byte back
+
+// USI engine (USI_ENGINE_ENABLE), timer0 runs from the start of each slot (~3us late, isr-latency @8MHz) in ticks of 64 cycles (8us @8MHz),
+// the times get rounded to the nearest tick: 30us -> 32us, 430us -> 432us @8MHz
+constexpr uint16_t USI_TIME_SLOT_US{30};       // write-zero gets released and the master-bit sampled here, one shift of the USI does both
+constexpr uint16_t USI_TIME_RESET_US{430};     // line still low -> reset, else the timer stops until the next slot
+constexpr uint16_t USI_TIME_TIMEOUT_US{15000}; // no slot for this long -> AWAIT_TIMESLOT_TIMEOUT_HIGH like ONEWIRE_TIME_MSG_HIGH_TIMEOUT, timer1 in ticks of 1024 cycles
+
+// multi-bus engine (MULTIHUB_ENABLE), one step is the edge-watch of the port and the state-step of one bus, edges are timestamped with timer1.
+// bits are told apart by the low-width of the master, so the only hard deadlines are the start and the release of a write-zero.
+// cycle counts are estimates for avr-gcc -Os, only the latency per number of buses follows from them (OneWireMultiHub.h), widths come from the timer
+constexpr uint8_t MULTIHUB_TIMER_CYCLES{8};                                      // timer1 runs free at CK/8 -> 1 us per tick @ 8 MHz
+constexpr uint8_t MULTIHUB_CYCLES_STEP{32};                                      // step without anything to do
+constexpr uint8_t MULTIHUB_CYCLES_EVENT{48};                                     // extra of a step that handles an edge, a timeout or a byte (crc, lpm, redirection)
+constexpr uint16_t MULTIHUB_TIME_ONE_MAX_US{37};                                 // low-width of the master below this is a one (write-one <= 15us, write-zero >= 60us)
+constexpr uint16_t MULTIHUB_TIME_HOLD_US{16};                                    // write-zero of the hub lasts at least this long, the master samples at ~15us
+constexpr uint16_t MULTIHUB_TIME_ZERO_MARGIN_US{3};                              // write-zero of the hub is on the line this long before the master samples (A + E)
+constexpr uint16_t MULTIHUB_TIME_RESET_MIN_US{HUB_TIME_RESET_MIN_US};            // like ONEWIRE_TIME_RESET_MIN
+constexpr uint16_t MULTIHUB_TIME_PRESENCE_WAIT_US{HUB_TIME_PRESENCE_TIMEOUT_US}; // like ONEWIRE_TIME_PRESENCE_TIMEOUT
+constexpr uint16_t MULTIHUB_TIME_PRESENCE_US{HUB_TIME_PRESENCE_MIN_US};          // like ONEWIRE_TIME_PRESENCE_MIN
 
 // VALUES FOR STATIC ASSERTS
 constexpr timeOW_t ONEWIRE_TIME_VALUE_MAX = {ONEWIRE_TIME_MSG_HIGH_TIMEOUT};
@@ -0,0 +1,17 @@
+// normal speed windows of the hub, generated by tools/owtiming for MEASURED_TIMING_ENABLE -> don't edit, measure again
+// master: dell-65w-legit dell-65w-legit-2, margin 15 %
+// reference device: dell-65w-legit dell-65w-legit-2
+
+#ifndef ONEWIREHUB_MEASURED_H
+#define ONEWIREHUB_MEASURED_H
+
+constexpr uint16_t HUB_TIME_RESET_MIN_US{460};       // shortest reset 541.2us - margin
+constexpr uint16_t HUB_TIME_RESET_MAX_US{624};       // longest reset 542.0us + margin
+constexpr uint16_t HUB_TIME_PRESENCE_TIMEOUT_US{22}; // median wait of the reference device
+constexpr uint16_t HUB_TIME_PRESENCE_MIN_US{121};    // median presence of the reference device
+constexpr uint16_t HUB_TIME_SLOT_MAX_US{102};        // READ_MAX + 1/4, like ADAPTIVE_TIMING_ENABLE
+constexpr uint16_t HUB_TIME_READ_MIN_US{34};         // middle of write-one 7.2us + margin and write-zero 69.8us - margin
+constexpr uint16_t HUB_TIME_READ_MAX_US{82};         // longest write-zero 71.0us + margin
+constexpr uint16_t HUB_TIME_WRITE_ZERO_US{41};       // median read-zero hold of the reference device
+
+#endif // ONEWIREHUB_MEASURED_H
@@ -1,17 +1,5 @@
 #include "OneWireItem.h"
 
-OneWireItem::OneWireItem(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7)
-{
-    ID[0] = ID1;
-    ID[1] = ID2;
-    ID[2] = ID3;
-    ID[3] = ID4;
-    ID[4] = ID5;
-    ID[5] = ID6;
-    ID[6] = ID7;
-    ID[7] = crc8(ID, 7);
-}
-
 void OneWireItem::sendID(OneWireHub *const hub) const
 {
     hub->send(ID, 8);
@@ -76,6 +64,18 @@ uint8_t OneWireItem::crc8(const uint8_t data[], const uint8_t data_size, const u
     return crc;
 }
 
+// built by the compiler from crc8Byte(), the first half takes the low nibble of crc ^ data, the second one the high nibble
+const uint8_t OneWireItem::crc8_nibbles[32] PROGMEM = {
+    crc8Byte(0, 0x00), crc8Byte(0, 0x01), crc8Byte(0, 0x02), crc8Byte(0, 0x03),
+    crc8Byte(0, 0x04), crc8Byte(0, 0x05), crc8Byte(0, 0x06), crc8Byte(0, 0x07),
+    crc8Byte(0, 0x08), crc8Byte(0, 0x09), crc8Byte(0, 0x0A), crc8Byte(0, 0x0B),
+    crc8Byte(0, 0x0C), crc8Byte(0, 0x0D), crc8Byte(0, 0x0E), crc8Byte(0, 0x0F),
+    crc8Byte(0, 0x00), crc8Byte(0, 0x10), crc8Byte(0, 0x20), crc8Byte(0, 0x30),
+    crc8Byte(0, 0x40), crc8Byte(0, 0x50), crc8Byte(0, 0x60), crc8Byte(0, 0x70),
+    crc8Byte(0, 0x80), crc8Byte(0, 0x90), crc8Byte(0, 0xA0), crc8Byte(0, 0xB0),
+    crc8Byte(0, 0xC0), crc8Byte(0, 0xD0), crc8Byte(0, 0xE0), crc8Byte(0, 0xF0),
+};
+
 uint16_t OneWireItem::crc16(const uint8_t address[], const uint8_t length, const uint16_t init)
 {
     uint16_t crc = init; // init value
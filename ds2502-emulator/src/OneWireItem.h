@@ -16,7 +16,10 @@
 class OneWireItem
 {
 public:
-    OneWireItem(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7);
+    // constexpr so a global item is constant-initialised (ID and its crc land in .data, no constructor runs at boot)
+    constexpr OneWireItem(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7)
+        : ID{ID1, ID2, ID3, ID4, ID5, ID6, ID7,
+             crc8Byte(crc8Byte(crc8Byte(crc8Byte(crc8Byte(crc8Byte(crc8Byte(0, ID1), ID2), ID3), ID4), ID5), ID6), ID7)} {};
 
     ~OneWireItem() = default; // TODO: detach if deleted before hub
 
@@ -30,10 +33,28 @@ public:
 
     void sendID(OneWireHub *hub) const;
 
+#if !STATIC_DISPATCH_ENABLE
     virtual void duty(OneWireHub *hub) = 0;
+#endif // otherwise every device brings a plain duty(OneWireHub *hub), OneWireHubStatic calls it directly
 
     static uint8_t crc8(const uint8_t data[], uint8_t data_size, uint8_t crc_init = 0);
 
+    // compile-time variant of crc8() for a single byte, only meant for constant expressions (slow recursion otherwise)
+    static constexpr uint8_t crc8Byte(const uint8_t crc, const uint8_t data, const uint8_t bits = 8)
+    {
+        return (bits == 0) ? crc : crc8Byte(static_cast<uint8_t>(((crc ^ data) & 0x01) ? ((crc >> 1) ^ 0x8C) : (crc >> 1)), static_cast<uint8_t>(data >> 1), static_cast<uint8_t>(bits - 1));
+    }
+
+    // crc8 of one more byte from two lookups in crc8_nibbles (the crc is linear: table[a ^ b] = table[a] ^ table[b]),
+    // two lpm instead of the bit-loop of crc8() -> for the read engine of OneWireMemory, between two slots (cycles not measured yet)
+    static uint8_t crc8Update(const uint8_t crc, const uint8_t data)
+    {
+        const uint8_t index = crc ^ data;
+        return pgm_read_byte(&crc8_nibbles[index & 0x0F]) ^ pgm_read_byte(&crc8_nibbles[16 + (index >> 4)]);
+    }
+
+    static const uint8_t crc8_nibbles[32]; // PROGMEM, crc8Byte() of the low nibbles and of the high nibbles
+
     // takes ~(5.1-7.0)µs/byte (Atmega328P@16MHz) depends from address_size (see debug-crc-comparison.ino)
     // important: the final crc is expected to be inverted (crc=~crc) !!!
     static uint16_t crc16(const uint8_t address[], uint8_t len, uint16_t init = 0);
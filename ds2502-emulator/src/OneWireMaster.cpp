@@ -0,0 +1,92 @@
+#include "OneWireMaster.h"
+
+OneWireMaster::OneWireMaster(const uint8_t pin)
+{
+    pin_bitMask = PIN_TO_BITMASK(pin);
+    pin_baseReg = PIN_TO_BASEREG(pin);
+    pinMode(pin, INPUT); // first port-access should by done by this FN, does more than DIRECT_MODE_....
+    DIRECT_WRITE_LOW(pin_baseReg, pin_bitMask);
+
+    static_assert(MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US <= 15, "master samples too late for a write-one of the slave");
+    static_assert(MASTER_TIME_WRITE_ZERO_US >= 60, "write-zero is too short for the slave");
+}
+
+bool OneWireMaster::reset(void)
+{
+    if (!DIRECT_READ(pin_baseReg, pin_bitMask))
+        return false; // line is held low, no reset possible
+
+    DIRECT_MODE_OUTPUT(pin_baseReg, pin_bitMask);
+    delayMicroseconds(MASTER_TIME_RESET_US);
+
+    noInterrupts();
+    DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+    delayMicroseconds(MASTER_TIME_PRESENCE_SAMPLE_US);
+    const bool presence = !DIRECT_READ(pin_baseReg, pin_bitMask);
+    interrupts();
+
+    delayMicroseconds(MASTER_TIME_RESET_REST_US);
+    return presence;
+}
+
+void OneWireMaster::sendBit(const bool value)
+{
+    noInterrupts();
+    DIRECT_MODE_OUTPUT(pin_baseReg, pin_bitMask);
+    if (value)
+    {
+        delayMicroseconds(MASTER_TIME_WRITE_ONE_US);
+        DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+        interrupts();
+        delayMicroseconds(MASTER_TIME_WRITE_ONE_REST_US);
+    }
+    else
+    {
+        delayMicroseconds(MASTER_TIME_WRITE_ZERO_US);
+        DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+        interrupts();
+        delayMicroseconds(MASTER_TIME_WRITE_ZERO_REST_US);
+    }
+}
+
+void OneWireMaster::send(const uint8_t dataByte)
+{
+    for (uint8_t bitMask = 0x01; bitMask != 0; bitMask <<= 1)
+        sendBit(static_cast<bool>(bitMask & dataByte));
+}
+
+void OneWireMaster::send(const uint8_t address[], const uint8_t data_length)
+{
+    for (uint8_t bytes_sent = 0; bytes_sent < data_length; ++bytes_sent)
+        send(address[bytes_sent]);
+}
+
+bool OneWireMaster::recvBit(void)
+{
+    noInterrupts();
+    DIRECT_MODE_OUTPUT(pin_baseReg, pin_bitMask);
+    delayMicroseconds(MASTER_TIME_WRITE_ONE_US);
+    DIRECT_MODE_INPUT(pin_baseReg, pin_bitMask);
+    delayMicroseconds(MASTER_TIME_READ_SAMPLE_US);
+    const bool value = DIRECT_READ(pin_baseReg, pin_bitMask);
+    interrupts();
+    delayMicroseconds(MASTER_TIME_READ_REST_US);
+    return value;
+}
+
+uint8_t OneWireMaster::recv(void)
+{
+    uint8_t value = 0;
+    for (uint8_t bitMask = 0x01; bitMask != 0; bitMask <<= 1)
+    {
+        if (recvBit())
+            value |= bitMask;
+    }
+    return value;
+}
+
+void OneWireMaster::recv(uint8_t address[], const uint8_t data_length)
+{
+    for (uint8_t bytes_received = 0; bytes_received < data_length; ++bytes_received)
+        address[bytes_received] = recv();
+}
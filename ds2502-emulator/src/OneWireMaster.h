@@ -0,0 +1,34 @@
+// bit-banged 1-Wire master on the pin-macros of platform.h, standard speed only
+// timing is done with delayMicroseconds(), interrupts are off during the time-critical part of each slot
+
+#ifndef ONEWIRE_MASTER_H
+#define ONEWIRE_MASTER_H
+
+#include "OneWireHub.h"
+
+class OneWireMaster
+{
+private:
+    io_reg_t pin_bitMask;
+    volatile io_reg_t *pin_baseReg;
+
+public:
+    explicit OneWireMaster(uint8_t pin);
+
+    ~OneWireMaster() = default;
+
+    OneWireMaster(const OneWireMaster &master) = delete;            // disallow copy constructor
+    OneWireMaster &operator=(const OneWireMaster &master) = delete; // disallow copy assignment
+
+    bool reset(void); // returns true if a device answered with a presence-pulse
+
+    void sendBit(bool value);
+    void send(uint8_t dataByte);
+    void send(const uint8_t address[], uint8_t data_length);
+
+    bool recvBit(void);
+    uint8_t recv(void);
+    void recv(uint8_t address[], uint8_t data_length);
+};
+
+#endif
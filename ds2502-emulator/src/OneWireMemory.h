@@ -0,0 +1,428 @@
+// core of the 1-Wire memory devices, one template over the layout of the part: class DS2502 : public OneWireMemory<DS2502Layout>
+// - the image lives in flash (PROGMEM), each device carries its own, the rest of the memory reads as unprogrammed 0xFF.
+//   the layout reads it (readImage()), the CachedDS2502 of the proxy from EEPROM
+// - status bytes (registers of the DS2431) live in RAM, the page redirection of the status is resolved whenever it changes
+// - one read engine for every part: the redirection is looked up once per page, the crc of the layout is kept per byte,
+//   crc8 with the nibble tables of OneWireItem, crc16 in the bit-loop of OneWireHub::send()
+// - reads only, write commands end the transaction (no programming pulse, no scratchpad)
+
+#ifndef ONEWIREHUB_ONEWIREMEMORY_H
+#define ONEWIREHUB_ONEWIREMEMORY_H
+
+#include "OneWireItem.h"
+
+constexpr uint16_t MEMORY_STATUS_NONE{0xFFFF}; // layout has no such field / status address has no byte behind it
+
+// the crc of a layout without one (DS2431 READ MEMORY), the read engine skips it at compile time
+struct OneWireNoCrc
+{
+};
+
+// status-layout of the EPROM parts (DS2501, DS2502): byte 0 holds the write protection (bit per page) and the used pages
+// (upper nibble), one inverted redirection byte per page follows, the last byte is factory programmed to 0x00
+struct OneWireEpromLayout
+{
+    static constexpr uint8_t PAGE_SHIFT{5}; // 32 bytes per page
+
+    static constexpr uint8_t STATUS_SIZE{8};
+    static constexpr uint16_t STATUS_END{8}; // status address space of READ STATUS
+
+    static constexpr uint16_t STATUS_PROTECT{0x00}; // bitmap, a cleared bit protects the page
+    static constexpr uint16_t STATUS_USED{0x00};    // bitmap, a cleared bit marks the page as used
+    static constexpr uint8_t STATUS_USED_SHIFT{4};  // bit of page 0 in the used-bitmap
+    static constexpr uint16_t STATUS_REDIRECT{0x01};
+
+    static constexpr bool STATUS_IN_MEMORY{false}; // status addresses follow the memory, READ MEMORY reads both (registers of the DS2431)
+    static constexpr bool STATUS_EPROM{true};      // writes can only clear bits
+
+    static constexpr bool READ_STATUS{true};   // READ STATUS (0xAA)
+    static constexpr bool READ_PAGE_CRC{true}; // READ DATA / GENERATE CRC (0xC3), a crc after every page
+
+    using crc_t = uint8_t;
+
+    static constexpr uint16_t statusIndex(const uint16_t address) { return (address < STATUS_SIZE) ? address : MEMORY_STATUS_NONE; };
+
+    static constexpr uint8_t statusInit(const uint8_t index) { return (index == (STATUS_SIZE - 1)) ? 0x00 : 0xFF; };
+
+    static uint8_t readImage(const uint8_t *const address) { return pgm_read_byte(address); }; // lpm, 3 cycles
+};
+
+// index lists for the constexpr constructor (c++11 has no std::index_sequence)
+template <uint8_t... Indices>
+struct OneWireMemoryIndices
+{
+};
+
+template <uint8_t Count, uint8_t... Indices>
+struct OneWireMemoryCount : OneWireMemoryCount<Count - 1, Count - 1, Indices...>
+{
+};
+
+template <uint8_t... Indices>
+struct OneWireMemoryCount<0, Indices...>
+{
+    using type = OneWireMemoryIndices<Indices...>;
+};
+
+// addresses of a part up to 256 bytes stay 8 bit, the avr compares and counts them in one register
+template <bool Wide>
+struct OneWireMemoryAddress
+{
+    using type = uint8_t;
+};
+
+template <>
+struct OneWireMemoryAddress<true>
+{
+    using type = uint16_t;
+};
+
+// the byte-functions of the read engine, one overload per crc of a layout
+inline bool memoryRecv(OneWireHub *const hub, uint8_t data[], const uint8_t length, OneWireNoCrc &)
+{
+    return hub->recv(data, length);
+}
+
+inline bool memoryRecv(OneWireHub *const hub, uint8_t data[], const uint8_t length, uint8_t &crc)
+{
+    if (hub->recv(data, length))
+        return true;
+    for (uint8_t index = 0; index < length; ++index)
+        crc = OneWireItem::crc8Update(crc, data[index]);
+    return false;
+}
+
+inline bool memoryRecv(OneWireHub *const hub, uint8_t data[], const uint8_t length, uint16_t &crc)
+{
+    return hub->recv(data, length, crc);
+}
+
+inline bool memorySend(OneWireHub *const hub, const uint8_t data, OneWireNoCrc &)
+{
+    return hub->send(&data);
+}
+
+inline bool memorySend(OneWireHub *const hub, const uint8_t data, uint8_t &crc)
+{
+    if (hub->send(&data))
+        return true;
+    crc = OneWireItem::crc8Update(crc, data);
+    return false;
+}
+
+inline bool memorySend(OneWireHub *const hub, const uint8_t data, uint16_t &crc)
+{
+    return hub->send(&data, 1, crc);
+}
+
+inline bool memorySendCrc(OneWireHub *const hub, const OneWireNoCrc &)
+{
+    return false;
+}
+
+inline bool memorySendCrc(OneWireHub *const hub, const uint8_t crc)
+{
+    return hub->send(&crc);
+}
+
+inline bool memorySendCrc(OneWireHub *const hub, const uint16_t crc)
+{
+    const uint8_t inverted[2]{static_cast<uint8_t>(~crc), static_cast<uint8_t>(~crc >> 8)}; // crc16 is sent inverted, lsb first
+    return hub->send(inverted, 2);
+}
+
+template <typename Layout>
+class OneWireMemory : public OneWireItem
+{
+public:
+    static constexpr uint8_t PAGE_COUNT{Layout::PAGE_COUNT};
+    static constexpr uint8_t PAGE_SHIFT{Layout::PAGE_SHIFT}; // address >> PAGE_SHIFT -> page
+    static constexpr uint16_t PAGE_SIZE{1 << PAGE_SHIFT};    // bytes
+    static constexpr uint16_t MEM_SIZE{PAGE_COUNT * PAGE_SIZE};
+    static constexpr uint8_t STATUS_SIZE{Layout::STATUS_SIZE};
+
+    static constexpr uint16_t ADDRESS_END{(MEM_SIZE > Layout::STATUS_END) ? MEM_SIZE : Layout::STATUS_END}; // of memory and status
+
+    using address_t = typename OneWireMemoryAddress<(ADDRESS_END > 0xFF)>::type;
+    using crc_t = typename Layout::crc_t;
+
+private:
+    static constexpr address_t PAGE_MASK{PAGE_SIZE - 1};
+
+    uint8_t status[STATUS_SIZE];     // eprom status bytes / eeprom registers
+    address_t page_base[PAGE_COUNT]; // resolved redirection: first address of the page that is read instead, rebuilt when status changes
+
+    const uint8_t *image; // PROGMEM (or where readImage() of the layout reads), each device can carry its own identity
+    address_t image_size; // programmed bytes, the rest reads as unprogrammed 0xFF
+
+    template <uint8_t... Status, uint8_t... Pages>
+    constexpr OneWireMemory(OneWireMemoryIndices<Status...>, OneWireMemoryIndices<Pages...>, uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4,
+                            uint8_t ID5, uint8_t ID6, uint8_t ID7, const uint8_t *image_P, address_t image_length)
+        : OneWireItem(ID1, ID2, ID3, ID4, ID5, ID6, ID7), status{Layout::statusInit(Status)...},
+          page_base{static_cast<address_t>(address_t(Pages) << PAGE_SHIFT)...},
+          image{image_P}, image_size{(image_length > MEM_SIZE) ? address_t(MEM_SIZE) : image_length} {};
+
+    address_t translateRedirection(address_t source_address) const;
+    void updateRedirection(void);
+
+    uint8_t readMemoryByte(address_t address) const;
+
+    bool sendMemory(OneWireHub *hub, address_t address, address_t end, crc_t &crc) const; // returns true if the master stopped reading
+    bool sendStatus(OneWireHub *hub, address_t address, crc_t &crc) const;
+
+public:
+    static constexpr uint8_t family_code{Layout::family_code};
+
+    // constexpr so the device is constant-initialised, status equals the state after clearStatus()
+    // image_P has to point to flash (PROGMEM), without a terminating zero in image_length
+    constexpr OneWireMemory(uint8_t ID1, uint8_t ID2, uint8_t ID3, uint8_t ID4, uint8_t ID5, uint8_t ID6, uint8_t ID7,
+                            const uint8_t *image_P = nullptr, address_t image_length = 0)
+        : OneWireMemory(typename OneWireMemoryCount<STATUS_SIZE>::type(), typename OneWireMemoryCount<PAGE_COUNT>::type(),
+                        ID1, ID2, ID3, ID4, ID5, ID6, ID7, image_P, image_length)
+    {
+        static_assert((PAGE_COUNT & (PAGE_COUNT - 1)) == 0, "the redirection masks the page, PAGE_COUNT has to be a power of 2");
+        static_assert(MEM_SIZE <= 0x8000, "Implementation does not cover the whole address-space");
+        static_assert(!Layout::STATUS_IN_MEMORY || (Layout::STATUS_END > MEM_SIZE), "registers in the memory space have to follow the memory");
+    };
+
+#if STATIC_DISPATCH_ENABLE
+    void duty(OneWireHub *hub);
+#else
+    void duty(OneWireHub *hub) final;
+#endif
+
+    uint8_t readMemory(address_t address) const; // with page redirection, like the master sees it
+
+    void setImage(const uint8_t *image_P, address_t image_length); // e.g. once the length is known at runtime
+
+    void clearStatus(void);
+
+    uint8_t writeStatus(uint16_t address, uint8_t value); // eprom: bits can only be cleared, returns the new value
+    uint8_t readStatus(uint16_t address) const;
+
+    void setPageProtection(uint8_t page);
+    bool getPageProtection(uint8_t page) const;
+
+    void setPageUsed(uint8_t page);
+    bool getPageUsed(uint8_t page) const;
+
+    bool setPageRedirection(uint8_t page_source, uint8_t page_destin);
+    uint8_t getPageRedirection(uint8_t page) const;
+};
+
+template <typename Layout>
+void OneWireMemory<Layout>::duty(OneWireHub *const hub)
+{
+    uint8_t reg_TA[2], cmd; // Target address, command
+    crc_t crc{};
+
+    if (memoryRecv(hub, &cmd, 1, crc))
+        return;
+
+    if (memoryRecv(hub, reg_TA, 2, crc))
+        return;
+
+    if (reg_TA[1] > ((ADDRESS_END - 1) >> 8))
+        return; // upper byte of target address is beyond the memory of the part
+
+    address_t address = static_cast<address_t>(reg_TA[0] | (reg_TA[1] << 8));
+
+    switch (cmd)
+    {
+    case 0xF0: // READ MEMORY
+
+        if (memorySendCrc(hub, crc))
+            break;
+
+        crc = crc_t(); // reInit CRC and send data
+        if (sendMemory(hub, address, address_t(MEM_SIZE), crc))
+            return;
+        if (Layout::STATUS_IN_MEMORY && sendStatus(hub, (address > MEM_SIZE) ? address : address_t(MEM_SIZE), crc))
+            return;
+        memorySendCrc(hub, crc);
+        break; // datasheet says we should return all 1s, send(255), till reset, nothing to do here, 1s are passive
+
+    case 0xAA: // READ STATUS, same scheme as READ MEMORY
+
+        if (!Layout::READ_STATUS || memorySendCrc(hub, crc))
+            break;
+
+        crc = crc_t();
+        if (sendStatus(hub, address, crc))
+            return;
+        memorySendCrc(hub, crc);
+        break;
+
+    case 0xC3: // READ DATA / GENERATE CRC, like READ MEMORY with a crc after the end of every page
+
+        if (!Layout::READ_PAGE_CRC || memorySendCrc(hub, crc))
+            break;
+
+        while (address < MEM_SIZE)
+        {
+            const address_t page_end = static_cast<address_t>((address | PAGE_MASK) + 1);
+            crc = crc_t();
+            if (sendMemory(hub, address, page_end, crc) || memorySendCrc(hub, crc))
+                return;
+            address = page_end;
+        }
+        break;
+    }
+}
+
+// the read engine: the redirection is looked up once per page, then the bytes of the page follow from flash
+template <typename Layout>
+bool OneWireMemory<Layout>::sendMemory(OneWireHub *const hub, address_t address, const address_t end, crc_t &crc) const
+{
+    while (address < end)
+    {
+        const address_t page_end = static_cast<address_t>((address | PAGE_MASK) + 1);
+        const address_t run_end = (page_end < end) ? page_end : end;
+        address_t source = translateRedirection(address);
+        for (; address < run_end; ++address, ++source)
+        {
+            if (memorySend(hub, readMemoryByte(source), crc))
+                return true;
+        }
+    }
+    return false;
+}
+
+template <typename Layout>
+bool OneWireMemory<Layout>::sendStatus(OneWireHub *const hub, address_t address, crc_t &crc) const
+{
+    for (; address < Layout::STATUS_END; ++address)
+    {
+        const uint16_t index = Layout::statusIndex(address);
+        if (memorySend(hub, (index < STATUS_SIZE) ? status[index] : uint8_t(0xFF), crc)) // gaps of the status space read as 0xFF
+            return true;
+    }
+    return false;
+}
+
+template <typename Layout>
+uint8_t OneWireMemory<Layout>::readMemoryByte(const address_t address) const
+{
+    if (address >= image_size)
+        return 0xFF;
+    return Layout::readImage(&image[address]);
+}
+
+template <typename Layout>
+uint8_t OneWireMemory<Layout>::readMemory(const address_t address) const
+{
+    return readMemoryByte(translateRedirection(address));
+}
+
+template <typename Layout>
+void OneWireMemory<Layout>::setImage(const uint8_t *const image_P, const address_t image_length)
+{
+    image = image_P;
+    image_size = (image_length > MEM_SIZE) ? address_t(MEM_SIZE) : image_length;
+}
+
+template <typename Layout>
+typename OneWireMemory<Layout>::address_t OneWireMemory<Layout>::translateRedirection(const address_t source_address) const
+{
+    return page_base[(source_address >> PAGE_SHIFT) & (PAGE_COUNT - 1)] | (source_address & PAGE_MASK);
+}
+
+// resolves the inverted redirection-bytes of the status once, so reading memory is a table lookup per page
+template <typename Layout>
+void OneWireMemory<Layout>::updateRedirection(void)
+{
+    for (uint8_t page = 0; page < PAGE_COUNT; ++page)
+    {
+        const uint8_t destin_page = getPageRedirection(page);
+        page_base[page] = static_cast<address_t>(address_t(((destin_page == 0x00) || (destin_page >= PAGE_COUNT)) ? page : destin_page) << PAGE_SHIFT);
+    }
+}
+
+template <typename Layout>
+void OneWireMemory<Layout>::clearStatus(void)
+{
+    for (uint8_t index = 0; index < STATUS_SIZE; ++index)
+        status[index] = Layout::statusInit(index);
+    updateRedirection();
+}
+
+template <typename Layout>
+uint8_t OneWireMemory<Layout>::writeStatus(const uint16_t address, const uint8_t value)
+{
+    const uint16_t index = Layout::statusIndex(address);
+    if (index >= STATUS_SIZE)
+        return 0x00;
+    if (Layout::STATUS_EPROM)
+        status[index] &= value; // eprom, only 1 -> 0 possible
+    else
+        status[index] = value;
+    if ((index >= Layout::STATUS_REDIRECT) && (index < (Layout::STATUS_REDIRECT + PAGE_COUNT)))
+        updateRedirection();
+    return status[index];
+}
+
+template <typename Layout>
+uint8_t OneWireMemory<Layout>::readStatus(const uint16_t address) const
+{
+    const uint16_t index = Layout::statusIndex(address);
+    if (index >= STATUS_SIZE)
+        return 0x00;
+    return status[index];
+}
+
+template <typename Layout>
+void OneWireMemory<Layout>::setPageProtection(const uint8_t page)
+{
+    if ((Layout::STATUS_PROTECT != MEMORY_STATUS_NONE) && (page < PAGE_COUNT))
+        status[Layout::STATUS_PROTECT + (page >> 3)] &= ~(uint8_t(1 << (page & 7)));
+}
+
+template <typename Layout>
+bool OneWireMemory<Layout>::getPageProtection(const uint8_t page) const
+{
+    if ((Layout::STATUS_PROTECT == MEMORY_STATUS_NONE) || (page >= PAGE_COUNT))
+        return true;
+    return ((status[Layout::STATUS_PROTECT + (page >> 3)] & uint8_t(1 << (page & 7))) == 0);
+}
+
+template <typename Layout>
+void OneWireMemory<Layout>::setPageUsed(const uint8_t page)
+{
+    const uint8_t bit = page + Layout::STATUS_USED_SHIFT;
+    if ((Layout::STATUS_USED != MEMORY_STATUS_NONE) && (page < PAGE_COUNT))
+        status[Layout::STATUS_USED + (bit >> 3)] &= ~(uint8_t(1 << (bit & 7)));
+}
+
+template <typename Layout>
+bool OneWireMemory<Layout>::getPageUsed(const uint8_t page) const
+{
+    const uint8_t bit = page + Layout::STATUS_USED_SHIFT;
+    if ((Layout::STATUS_USED == MEMORY_STATUS_NONE) || (page >= PAGE_COUNT))
+        return true;
+    return ((status[Layout::STATUS_USED + (bit >> 3)] & uint8_t(1 << (bit & 7))) == 0);
+}
+
+template <typename Layout>
+bool OneWireMemory<Layout>::setPageRedirection(const uint8_t page_source, const uint8_t page_destin)
+{
+    if (Layout::STATUS_REDIRECT == MEMORY_STATUS_NONE)
+        return false;
+    if (page_source >= PAGE_COUNT)
+        return false; // really available
+    if (page_destin >= PAGE_COUNT)
+        return false; // virtual mem of the device
+
+    status[page_source + Layout::STATUS_REDIRECT] = (page_destin == page_source) ? uint8_t(0xFF) : uint8_t(~page_destin); // datasheet dictates this, so no page can be redirected to page 0
+    updateRedirection();
+    return true;
+}
+
+template <typename Layout>
+uint8_t OneWireMemory<Layout>::getPageRedirection(const uint8_t page) const
+{
+    if ((Layout::STATUS_REDIRECT == MEMORY_STATUS_NONE) || (page >= PAGE_COUNT))
+        return 0x00;
+    return ~(status[page + Layout::STATUS_REDIRECT]); // only used to rebuild page_base, the read path does not invert anymore
+}
+
+#endif // ONEWIREHUB_ONEWIREMEMORY_H
@@ -0,0 +1,379 @@
+#include "OneWireMultiHub.h"
+
+#if MULTIHUB_ENABLE
+
+static_assert(microsecondsToClockCycles(MULTIHUB_TIME_HOLD_US) + 2 * multiHubLatencyCycles(MULTIHUB_BUS_LIMIT) < microsecondsToClockCycles(60),
+              "write-zero could be released after the slot, too many buses for this clock (see README)");
+static_assert(microsecondsToClockCycles(15) + multiHubLatencyCycles(MULTIHUB_BUS_LIMIT) < microsecondsToClockCycles(MULTIHUB_TIME_ONE_MAX_US),
+              "write-one could be taken as a zero, too many buses for this clock (see README)");
+static_assert(microsecondsToClockCycles(MULTIHUB_TIME_ONE_MAX_US) + multiHubLatencyCycles(MULTIHUB_BUS_LIMIT) < microsecondsToClockCycles(60),
+              "write-zero could be taken as a one, too many buses for this clock (see README)");
+static_assert(MULTIHUB_WRITE_ZERO_CYCLES < microsecondsToClockCycles(MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US - MULTIHUB_TIME_ZERO_MARGIN_US),
+              "write-zero starts too late for the master");
+static_assert(MULTIHUB_TIME_RESET_MIN_US > 120, "reset could be a slot");
+static_assert(multiHubLatencyCycles(1) < 256 * MULTIHUB_TIMER_CYCLES, "a step would miss an overflow of the 8 bit timer count");
+static_assert(microsecondsToClockCycles(MULTIHUB_TIME_RESET_MIN_US) / MULTIHUB_TIMER_CYCLES < 0x8000, "reset does not fit the 16 bit tick");
+
+// only the low byte of timer1 is read (timer1 of the ATtinyX5 has no more), watchEdges() extends it to 16 bit
+static_assert(MULTIHUB_TIMER_CYCLES == 8, "update the prescaler of timer1");
+#if defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__)
+static inline void timerStart(void) { TCCR1 = _BV(CS12); } // CK/8, normal mode, no interrupt
+static inline uint8_t timerCount(void) { return TCNT1; }
+#else
+static inline void timerStart(void)
+{
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11); // CK/8, normal mode, no interrupt
+}
+static inline uint8_t timerCount(void) { return TCNT1L; }
+#endif
+
+OneWireMultiHub::OneWireMultiHub(void)
+{
+    bus_count = 0;
+    pin_baseReg = nullptr;
+    level = 0;
+    zero_mask = 0;
+    fell = 0;
+    rose = 0;
+    tick = 0;
+}
+
+bool OneWireMultiHub::attach(const uint8_t pin, DS2502 &device)
+{
+    if (bus_count >= MULTIHUB_BUS_LIMIT)
+        return false;
+
+    volatile io_reg_t *const baseReg = PIN_TO_BASEREG(pin);
+    if ((bus_count != 0) && (baseReg != pin_baseReg))
+        return false; // one port-read has to cover all buses
+
+    pin_baseReg = baseReg;
+
+    Bus &bus = bus_list[bus_count++];
+    bus.device = &device;
+    bus.mask = PIN_TO_BITMASK(pin);
+    bus.state = BusState::IDLE;
+    bus.phase = BusPhase::ROM_CMD;
+    bus.tick_edge = 0;
+
+    pinMode(pin, INPUT); // first port-access should by done by this FN, does more than DIRECT_MODE_....
+    DIRECT_WRITE_LOW(pin_baseReg, bus.mask);
+
+#if WATCHDOG_ENABLE
+    wdt_enable(WATCHDOG_TIMEOUT);
+#endif
+    return true;
+}
+
+uint8_t OneWireMultiHub::getBusCount(void) const
+{
+    return bus_count;
+}
+
+void OneWireMultiHub::poll(void)
+{
+    noInterrupts(); // the edge-watch has to run before every step, nothing may come in between
+    timerStart();   // takes timer1, it runs free from now on
+    level = *pin_baseReg;
+    tick = timerCount();
+
+    while (true)
+    {
+#if WATCHDOG_ENABLE
+        wdt_reset();
+#endif
+        for (uint8_t index = 0; index < bus_count; ++index)
+        {
+            watchEdges();
+            step(bus_list[index]);
+        }
+    }
+}
+
+// the fast path, runs before every step: a falling edge on any bus that sends a zero is pulled low right away
+inline void OneWireMultiHub::watchEdges(void)
+{
+    const io_reg_t pins = *pin_baseReg;
+    const io_reg_t pins_fell = level & ~pins;
+    DIRECT_MODE_OUTPUT(pin_baseReg, pins_fell & zero_mask);
+    fell |= pins_fell;
+    rose |= pins & ~level;
+    level = pins;
+
+    const uint8_t count = timerCount();
+    if (count < uint8_t(tick))
+        tick += 0x100; // low byte wrapped since the last edge-watch, at most one step ago
+    tick = (tick & 0xFF00) | count;
+}
+
+void OneWireMultiHub::step(Bus &bus)
+{
+    const io_reg_t mask = bus.mask;
+
+    if ((fell | rose) & mask)
+    {
+        const bool bus_fell = (fell & mask) != 0;
+        const bool bus_rose = (rose & mask) != 0;
+        fell &= ~mask;
+        rose &= ~mask;
+
+        // both edges since the last step: the line level tells the order
+        if (bus_rose && !(level & mask))
+            onRise(bus);
+        if (bus_fell)
+            onFall(bus);
+        if (bus_rose && (level & mask))
+            onRise(bus);
+        return;
+    }
+
+    const uint16_t ticks = tick - bus.tick_edge;
+
+    switch (bus.state)
+    {
+    case BusState::RX_LOW:
+        if (ticks >= TICKS_ONE_MAX)
+            onBit(bus, false); // rise of the zero is ignored in RX_HIGH
+        break;
+
+    case BusState::TX_HOLD:
+        if (ticks >= TICKS_HOLD)
+        {
+            release(bus);
+            onBit(bus, false);
+        }
+        break;
+
+    case BusState::PRESENCE_WAIT:
+        if (ticks >= TICKS_PRESENCE_WAIT)
+        {
+            DIRECT_MODE_OUTPUT(pin_baseReg, mask);
+            level &= ~mask; // own edge, not the start of a slot
+            bus.tick_edge = tick;
+            bus.state = BusState::PRESENCE_LOW;
+        }
+        break;
+
+    case BusState::PRESENCE_LOW:
+        if (ticks >= TICKS_PRESENCE)
+        {
+            release(bus);
+            bus.tick_edge = tick; // the rise that follows is no end of a reset
+            startRx(bus, BusPhase::ROM_CMD);
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+void OneWireMultiHub::onFall(Bus &bus)
+{
+    if ((bus.state == BusState::PRESENCE_WAIT) || (bus.state == BusState::PRESENCE_LOW))
+        return;
+
+    bus.tick_edge = tick;
+
+    if (bus.state == BusState::RX_HIGH)
+        bus.state = BusState::RX_LOW;
+    else if (bus.state == BusState::TX_HIGH)
+    {
+        if (zero_mask & bus.mask)
+            bus.state = BusState::TX_HOLD; // already pulled low by watchEdges()
+        else
+            onBit(bus, true);
+    }
+}
+
+void OneWireMultiHub::onRise(Bus &bus)
+{
+    if ((bus.state == BusState::PRESENCE_WAIT) || (bus.state == BusState::PRESENCE_LOW))
+        return;
+
+    if (uint16_t(tick - bus.tick_edge) >= TICKS_RESET_MIN)
+    {
+        // reset ends every transaction, no matter where the bus was
+        release(bus);
+        zero_mask &= ~bus.mask;
+        bus.tick_edge = tick;
+        bus.state = BusState::PRESENCE_WAIT;
+        return;
+    }
+
+    if (bus.state == BusState::RX_LOW)
+        onBit(bus, true);
+}
+
+// a slot is done, value is the bit that went over the line
+void OneWireMultiHub::onBit(Bus &bus, const bool value)
+{
+    if ((bus.phase >= BusPhase::MEM_CMD) && (bus.phase != BusPhase::CRC_CMD) && (bus.phase != BusPhase::CRC_DATA))
+    {
+        const bool mix = ((bus.crc & 0x01) != 0) != value;
+        bus.crc >>= 1;
+        if (mix)
+            bus.crc ^= 0x8C;
+    }
+
+    if ((bus.state == BusState::RX_LOW) || (bus.state == BusState::RX_HIGH))
+    {
+        if (value)
+            bus.data |= bus.bit;
+        bus.state = BusState::RX_HIGH;
+        bus.bit <<= 1;
+        if (bus.bit == 0)
+            rxByte(bus);
+    }
+    else
+    {
+        bus.state = BusState::TX_HIGH;
+        bus.bit <<= 1;
+        if (bus.bit == 0)
+            txByte(bus);
+        else
+            prepareTxBit(bus);
+    }
+}
+
+void OneWireMultiHub::startRx(Bus &bus, const BusPhase phase)
+{
+    zero_mask &= ~bus.mask;
+    bus.phase = phase;
+    bus.state = BusState::RX_HIGH;
+    bus.data = 0;
+    bus.bit = 0x01;
+}
+
+void OneWireMultiHub::startTx(Bus &bus, const BusPhase phase, const uint8_t data)
+{
+    bus.phase = phase;
+    bus.state = BusState::TX_HIGH;
+    bus.data = data;
+    bus.bit = 0x01;
+    prepareTxBit(bus);
+}
+
+void OneWireMultiHub::prepareTxBit(Bus &bus)
+{
+    if (bus.data & bus.bit)
+        zero_mask &= ~bus.mask;
+    else
+        zero_mask |= bus.mask;
+}
+
+void OneWireMultiHub::rxByte(Bus &bus)
+{
+    const uint8_t data = bus.data;
+
+    switch (bus.phase)
+    {
+    case BusPhase::ROM_CMD:
+        bus.crc = 0;
+        if (data == 0xCC) // SKIP ROM
+            startRx(bus, BusPhase::MEM_CMD);
+        else if (data == 0x33) // READ ROM
+        {
+            bus.address = 0;
+            startTx(bus, BusPhase::ROM_READ, bus.device->ID[0]);
+        }
+        else if (data == 0x55) // MATCH ROM
+        {
+            bus.address = 0;
+            startRx(bus, BusPhase::ROM_MATCH);
+        }
+        else
+            bus.state = BusState::IDLE;
+        break;
+
+    case BusPhase::ROM_MATCH:
+        if (data != bus.device->ID[bus.address])
+            bus.state = BusState::IDLE; // other device is addressed, wait for the next reset
+        else if (++bus.address == 8)
+            startRx(bus, BusPhase::MEM_CMD);
+        else
+            startRx(bus, BusPhase::ROM_MATCH);
+        break;
+
+    case BusPhase::MEM_CMD:
+        bus.cmd = data;
+        if ((data == 0xF0) || (data == 0xAA)) // READ MEMORY, READ STATUS
+            startRx(bus, BusPhase::ADDR_LO);
+        else
+            bus.state = BusState::IDLE;
+        break;
+
+    case BusPhase::ADDR_LO:
+        bus.address = data;
+        startRx(bus, BusPhase::ADDR_HI);
+        break;
+
+    case BusPhase::ADDR_HI:
+        if (data != 0)
+            bus.state = BusState::IDLE; // upper byte of target address should not contain any data
+        else
+            startTx(bus, BusPhase::CRC_CMD, bus.crc);
+        break;
+
+    default:
+        bus.state = BusState::IDLE;
+        break;
+    }
+}
+
+void OneWireMultiHub::txByte(Bus &bus)
+{
+    switch (bus.phase)
+    {
+    case BusPhase::ROM_READ:
+        if (++bus.address < 8)
+            startTx(bus, BusPhase::ROM_READ, bus.device->ID[bus.address]);
+        else
+            startRx(bus, BusPhase::MEM_CMD);
+        break;
+
+    case BusPhase::CRC_CMD:
+        bus.crc = 0; // reInit CRC and send data
+        sendData(bus);
+        break;
+
+    case BusPhase::DATA:
+        ++bus.address;
+        sendData(bus);
+        break;
+
+    default: // CRC_DATA, datasheet says we should return all 1s till reset, 1s are passive
+        zero_mask &= ~bus.mask;
+        bus.state = BusState::IDLE;
+        break;
+    }
+}
+
+// next byte of memory or status, the crc after the last one
+void OneWireMultiHub::sendData(Bus &bus)
+{
+    const DS2502 &device = *bus.device;
+
+    if (bus.cmd == 0xF0)
+    {
+        if (bus.address < DS2502::MEM_SIZE)
+            startTx(bus, BusPhase::DATA, device.readMemory(bus.address));
+        else
+            startTx(bus, BusPhase::CRC_DATA, bus.crc);
+    }
+    else
+    {
+        if (bus.address < DS2502::STATUS_SIZE)
+            startTx(bus, BusPhase::DATA, device.readStatus(bus.address));
+        else
+            startTx(bus, BusPhase::CRC_DATA, bus.crc);
+    }
+}
+
+void OneWireMultiHub::release(const Bus &bus)
+{
+    DIRECT_MODE_INPUT(pin_baseReg, bus.mask);
+}
+
+#endif
@@ -0,0 +1,130 @@
+// serves several independent 1-Wire buses from one mcu, every bus has its own pin (all on one port) and its own DS2502
+// - the port is read once per step, falling edges of all buses are answered at once (write-zero), no bus blocks the others
+// - every edge-watch reads timer1 (free-running), widths and timeouts are measured in its ticks instead of counted steps
+// - every bus runs a small state-machine, bits are told apart by the measured low-width instead of a fixed sample point
+// - normal speed, ROM commands SKIP / READ / MATCH ROM, device commands READ MEMORY and READ STATUS like DS2502::duty()
+
+#ifndef ONEWIRE_MULTIHUB_H
+#define ONEWIRE_MULTIHUB_H
+
+#include "OneWireHub.h"
+
+#if MULTIHUB_ENABLE
+
+#include "DS2502.h"
+
+#if (MULTIHUB_BUS_LIMIT > 8) || (MULTIHUB_BUS_LIMIT < 1)
+#error "Buslimit has to be 1 to 8 (one port)"
+#endif
+
+#if !defined(__AVR__)
+#error "OneWireMultiHub reads the whole port at once, only implemented for AVR"
+#endif
+
+// one tick is one count of timer1 (MULTIHUB_TIMER_CYCLES), it does not depend on how long the steps really take
+constexpr uint16_t multiHubTicks(const uint16_t time_us)
+{
+    return uint16_t(time_us * microsecondsToClockCycles(1) / MULTIHUB_TIMER_CYCLES);
+}
+
+// one sweep over all buses: an edge is noticed by its bus at most this late, a timeout is handled at most this late
+// (estimate, every step of the sweep carries an event)
+constexpr uint32_t multiHubLatencyCycles(const uint8_t bus_count)
+{
+    return uint32_t(bus_count) * (MULTIHUB_CYCLES_STEP + MULTIHUB_CYCLES_EVENT);
+}
+
+// falling edge to write-zero, does not depend on the number of buses: the port is watched before every step
+constexpr uint32_t MULTIHUB_WRITE_ZERO_CYCLES{MULTIHUB_CYCLES_STEP + MULTIHUB_CYCLES_EVENT};
+
+class OneWireMultiHub
+{
+private:
+    enum class BusState : uint8_t
+    {
+        IDLE = 0,          // not addressed, ones are passive -> only watch for a reset
+        PRESENCE_WAIT = 1, // reset is over, wait ONEWIRE presence-timeout
+        PRESENCE_LOW = 2,  // hub drives the presence-pulse
+        RX_HIGH = 3,       // wait for the master to start a slot
+        RX_LOW = 4,        // slot started, rise before MULTIHUB_TIME_ONE_MAX_US is a one
+        TX_HIGH = 5,       // next bit is prepared, a zero gets pulled by the edge-watch
+        TX_HOLD = 6        // hub holds a write-zero
+    };
+
+    enum class BusPhase : uint8_t
+    {
+        ROM_CMD = 0,
+        ROM_MATCH = 1, // address counts the bytes of the ID
+        ROM_READ = 2,
+        MEM_CMD = 3,
+        ADDR_LO = 4,
+        ADDR_HI = 5,
+        CRC_CMD = 6, // crc of command and address
+        DATA = 7,    // address is the memory pointer
+        CRC_DATA = 8
+    };
+
+    struct Bus
+    {
+        DS2502 *device;
+        io_reg_t mask; // pin of the bus in the port
+        BusState state;
+        BusPhase phase;
+        uint16_t tick_edge; // last falling edge, or the start of the current presence-state
+        uint8_t data;       // byte in transfer, lsb first
+        uint8_t bit;        // mask of the current bit in data
+        uint8_t crc;        // crc8 of the transferred bits, see BusPhase
+        uint8_t cmd;
+        uint8_t address;
+    };
+
+    static constexpr uint16_t TICKS_ONE_MAX{multiHubTicks(MULTIHUB_TIME_ONE_MAX_US)};
+    static constexpr uint16_t TICKS_HOLD{multiHubTicks(MULTIHUB_TIME_HOLD_US)};
+    static constexpr uint16_t TICKS_RESET_MIN{multiHubTicks(MULTIHUB_TIME_RESET_MIN_US)};
+    static constexpr uint16_t TICKS_PRESENCE_WAIT{multiHubTicks(MULTIHUB_TIME_PRESENCE_WAIT_US)};
+    static constexpr uint16_t TICKS_PRESENCE{multiHubTicks(MULTIHUB_TIME_PRESENCE_US)};
+
+    Bus bus_list[MULTIHUB_BUS_LIMIT];
+    uint8_t bus_count;
+
+    volatile io_reg_t *pin_baseReg; // shared by all buses
+
+    // only touched with interrupts off, plain members so the compiler can keep them in registers
+    io_reg_t level;     // port at the last edge-watch
+    io_reg_t zero_mask; // buses that answer the next slot with a zero
+    io_reg_t fell;      // falling edges not yet seen by their bus
+    io_reg_t rose;      // rising edges not yet seen by their bus
+    uint16_t tick;      // timer1 at the last edge-watch, the 8 bit of the counter extended by software
+
+    inline __attribute__((always_inline)) void watchEdges(void);
+    void step(Bus &bus);
+
+    void onFall(Bus &bus);
+    void onRise(Bus &bus);
+    void onBit(Bus &bus, bool value);
+
+    void startRx(Bus &bus, BusPhase phase);
+    void startTx(Bus &bus, BusPhase phase, uint8_t data);
+    void prepareTxBit(Bus &bus);
+    void rxByte(Bus &bus);
+    void txByte(Bus &bus);
+    void sendData(Bus &bus);
+    void release(const Bus &bus);
+
+public:
+    OneWireMultiHub(void);
+
+    ~OneWireMultiHub() = default;
+
+    OneWireMultiHub(const OneWireMultiHub &hub) = delete;            // disallow copy constructor
+    OneWireMultiHub &operator=(const OneWireMultiHub &hub) = delete; // disallow copy assignment
+
+    bool attach(uint8_t pin, DS2502 &device); // returns false if the limit is reached or the pin is on another port
+
+    uint8_t getBusCount(void) const;
+
+    void poll(void); // serves all attached buses, disables interrupts and never returns
+};
+
+#endif
+#endif
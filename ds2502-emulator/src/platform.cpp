@@ -12,3 +12,118 @@ void noInterrupts(){};
 void interrupts(){};
 
 #endif // ONEWIREHUB_FALLBACK_BASIC_FNs
+
+#ifdef ONEWIREHUB_BARE_METAL
+
+// comes with the arduino core otherwise, every OneWireItem has a vtable
+extern "C" void __cxa_pure_virtual(void)
+{
+    while (true)
+    {
+    }
+}
+
+#endif // ONEWIREHUB_BARE_METAL
+
+#ifdef ONEWIREHUB_LINUX_GPIO
+
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+static int gpio_line_fd{-1};
+static bool gpio_line_low{false};
+static uint64_t gpio_next_read{0}; // ns, pace of the wait-loops
+static GpioLineStats gpio_stats{};
+
+static uint64_t monotonicNs(void)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return uint64_t(now.tv_sec) * 1000000000ULL + uint64_t(now.tv_nsec);
+}
+
+static void countTime(const uint64_t time_start, uint64_t &sum, uint64_t &longest)
+{
+    const uint64_t time_ns = monotonicNs() - time_start;
+    sum += time_ns;
+    if (time_ns > longest)
+        longest = time_ns;
+}
+
+bool gpioLineOpen(const char *const chip, const uint32_t offset)
+{
+    const int chip_fd = open(chip, O_RDONLY | O_CLOEXEC);
+    if (chip_fd < 0)
+        return false;
+
+    gpio_v2_line_request request{};
+    request.offsets[0] = offset;
+    request.num_lines = 1;
+    request.config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    strncpy(request.consumer, "OneWireHub", sizeof(request.consumer) - 1);
+    const int result = ioctl(chip_fd, GPIO_V2_GET_LINE_IOCTL, &request);
+    close(chip_fd);
+    if (result < 0)
+        return false;
+
+    gpio_line_fd = request.fd;
+    gpio_line_low = false;
+    return true;
+}
+
+// every read takes one wait-loop of the attiny, so the loop-counts of the config keep their time.
+// a read that comes late (slow ioctl, preemption, work of the hub in between) starts a new pace instead of hurrying the next ones
+bool gpioLineRead(void)
+{
+    uint64_t now = monotonicNs();
+    while (now < gpio_next_read)
+        now = monotonicNs();
+    if (now > gpio_next_read + GPIO_LATE_LOOPS * GPIO_LOOP_NS)
+    {
+        if (gpio_next_read != 0)
+            ++gpio_stats.late_reads;
+        gpio_next_read = now;
+    }
+    gpio_next_read += GPIO_LOOP_NS;
+
+    gpio_v2_line_values values{};
+    values.mask = 1;
+    const bool valid = (ioctl(gpio_line_fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) == 0);
+    ++gpio_stats.reads;
+    countTime(now, gpio_stats.read_ns, gpio_stats.read_ns_max);
+    return !valid || ((values.bits & 1) != 0); // a failed read looks like an idle line
+}
+
+void gpioLineDrive(const bool pull_low)
+{
+    if (pull_low == gpio_line_low)
+        return; // the hub sets the direction more often than it changes it, each change is a syscall
+    gpio_line_low = pull_low;
+
+    gpio_v2_line_config config{};
+    if (pull_low)
+    {
+        config.flags = GPIO_V2_LINE_FLAG_OUTPUT | GPIO_V2_LINE_FLAG_OPEN_DRAIN;
+        config.num_attrs = 1;
+        config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+        config.attrs[0].attr.values = 0;
+        config.attrs[0].mask = 1;
+    }
+    else
+    {
+        config.flags = GPIO_V2_LINE_FLAG_INPUT;
+    }
+
+    const uint64_t time_start = monotonicNs();
+    ioctl(gpio_line_fd, GPIO_V2_LINE_SET_CONFIG_IOCTL, &config);
+    ++gpio_stats.drives;
+    countTime(time_start, gpio_stats.drive_ns, gpio_stats.drive_ns_max);
+}
+
+GpioLineStats gpioLineStats(void) { return gpio_stats; }
+
+#endif // ONEWIREHUB_LINUX_GPIO
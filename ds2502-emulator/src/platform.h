@@ -17,9 +17,17 @@
 
 #if defined(__AVR__) /* arduino (all with atmega, atiny) */
 
+#include <avr/wdt.h>
+
 #define PIN_TO_BASEREG(pin) (portInputRegister(digitalPinToPort(pin)))
 #define PIN_TO_BITMASK(pin) (digitalPinToBitMask(pin))
+#ifdef ONEWIREHUB_WCET_SAMPLES // set by "make bare"
+// every sample of the line leaves its address in .debug_wcet_samples: not loaded, no instruction -> tools/wcet measures the gaps between them
+#define WCET_SAMPLE_MARKER() __asm__ __volatile__("1:\n\t.pushsection .debug_wcet_samples,\"\",@progbits\n\t.long 1b\n\t.popsection")
+#define DIRECT_READ(base, mask) ({ WCET_SAMPLE_MARKER(); (((*(base)) & (mask)) ? 1 : 0); })
+#else
 #define DIRECT_READ(base, mask) (((*(base)) & (mask)) ? 1 : 0)
+#endif
 #define DIRECT_MODE_INPUT(base, mask) ((*((base) + 1)) &= ~(mask))
 #define DIRECT_MODE_OUTPUT(base, mask) ((*((base) + 1)) |= (mask))
 #define DIRECT_WRITE_LOW(base, mask) ((*((base) + 2)) &= ~(mask))
@@ -265,6 +273,55 @@ static inline __attribute__((always_inline)) void directWriteHigh(volatile io_re
 #define DIRECT_WRITE_LOW(base, pin) directWriteLow(base, pin)
 #define DIRECT_WRITE_HIGH(base, pin) directWriteHigh(base, pin)
 
+#elif defined(ONEWIREHUB_HOST_SIM) /* PC, hub runs against a simulated bus in virtual time, see tools/fleetsim.cpp */
+
+#include <inttypes.h>
+
+#define PIN_TO_BASEREG(pin) (0)
+#define PIN_TO_BITMASK(pin) (pin)
+#define DIRECT_READ(base, pin) simBusRead()
+#define DIRECT_WRITE_LOW(base, pin) ((void)0) // only the direction drives the line, like the open-drain use on the avr
+#define DIRECT_WRITE_HIGH(base, pin) ((void)0)
+#define DIRECT_MODE_INPUT(base, pin) simBusDrive(false)
+#define DIRECT_MODE_OUTPUT(base, pin) simBusDrive(true)
+using io_reg_t = uint32_t;       // define special datatype for register-access
+constexpr uint8_t VALUE_IPL{13}; // same loops as the attiny25 (8 MHz below), every read advances the virtual time by one loop
+
+bool simBusRead(void);           // provided by the simulator, one bus per thread
+void simBusDrive(bool pull_low); // hub pulls the line low or releases it
+
+#elif defined(ONEWIREHUB_LINUX_GPIO) /* linux userspace, the line is a gpio of a character device (e.g. gpio-sim), see tools/gpiobench.cpp */
+
+#include <inttypes.h>
+
+#define PIN_TO_BASEREG(pin) (0)
+#define PIN_TO_BITMASK(pin) (pin)
+#define DIRECT_READ(base, pin) gpioLineRead()
+#define DIRECT_WRITE_LOW(base, pin) ((void)0) // open-drain, only the direction drives the line
+#define DIRECT_WRITE_HIGH(base, pin) ((void)0)
+#define DIRECT_MODE_INPUT(base, pin) gpioLineDrive(false)
+#define DIRECT_MODE_OUTPUT(base, pin) gpioLineDrive(true)
+using io_reg_t = uint32_t;             // define special datatype for register-access
+constexpr uint8_t VALUE_IPL{13};       // same loops as the attiny25 (8 MHz below), every read is paced to one loop
+constexpr uint32_t GPIO_LOOP_NS{1625}; // 13 cycles @ 8 MHz
+constexpr uint32_t GPIO_LATE_LOOPS{2}; // a read this far behind its pace restarts the pace, the wait-loop got longer
+
+struct GpioLineStats
+{
+    uint64_t reads;
+    uint64_t late_reads;
+    uint64_t read_ns; // time in the ioctl, sum and longest
+    uint64_t read_ns_max;
+    uint64_t drives;
+    uint64_t drive_ns;
+    uint64_t drive_ns_max;
+};
+
+bool gpioLineOpen(const char *chip, uint32_t offset); // e.g. "/dev/gpiochip1", one line per process, requested as input
+bool gpioLineRead(void);
+void gpioLineDrive(bool pull_low); // open-drain output at low or input
+GpioLineStats gpioLineStats(void);
+
 #else // any unknown architecture, including PC
 
 #include <inttypes.h>
@@ -288,7 +345,10 @@ constexpr uint8_t VALUE_IPL{10}; // instructions per loop, uncalibrated so far -
 // these used functions are mockups
 ////////////////////////////////////////////////////////////////////////////////////////////////
 
-#ifndef ARDUINO
+#if !defined(ARDUINO) && defined(__AVR__)
+#define ONEWIREHUB_BARE_METAL              // avr-gcc and avr-libc without the arduino core, see "make bare"
+#define ONEWIREHUB_FALLBACK_ADDITIONAL_FNs // no uart on the attiny, Serial stays a mockup
+#elif !defined(ARDUINO)
 #define ONEWIREHUB_FALLBACK_BASIC_FNs
 #define ONEWIREHUB_FALLBACK_ADDITIONAL_FNs // to load up Serial below
 #endif
@@ -297,6 +357,64 @@ constexpr uint8_t VALUE_IPL{10}; // instructions per loop, uncalibrated so far -
 #define ONEWIREHUB_FALLBACK_ADDITIONAL_FNs // to load up Serial below
 #endif
 
+#ifdef ONEWIREHUB_BARE_METAL
+// the few parts of the arduino core the firmware uses, on the one port of the ATtinyX5 (pin n is PBn)
+// nothing runs in the background: no timer0-isr for millis(), no init() of pwm and adc
+
+#include <avr/interrupt.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+#include <util/delay_basic.h>
+
+#if !(defined(__AVR_ATtiny25__) || defined(__AVR_ATtiny45__) || defined(__AVR_ATtiny85__))
+#error "Bare-metal build maps the pins to PORTB of the ATtinyX5"
+#endif
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define LOW 0x0
+#define HIGH 0x1
+
+#define microsecondsToClockCycles(a) ((a) * (F_CPU / 1000000L))
+#define digitalPinToPort(pin) (0)
+#define portInputRegister(port) (&PINB)
+#define digitalPinToBitMask(pin) (_BV(pin))
+#define noInterrupts() cli()
+#define interrupts() sei()
+
+static inline void pinMode(const uint8_t pin, const uint8_t mode)
+{
+    if (mode == OUTPUT)
+        DDRB |= _BV(pin);
+    else
+        DDRB &= ~_BV(pin);
+}
+
+static inline void digitalWrite(const uint8_t pin, const uint8_t value)
+{
+    if (value == LOW)
+        PORTB &= ~_BV(pin);
+    else
+        PORTB |= _BV(pin);
+}
+
+// busy wait, 4 cycles per round of _delay_loop_2()
+static inline void delayMicroseconds(const uint16_t time_us)
+{
+    if (time_us != 0)
+        _delay_loop_2(uint16_t(time_us * microsecondsToClockCycles(1) / 4));
+}
+
+// busy wait as well, for the poll intervals of the dumper and the proxy. no millis() and micros(): they need the timer0-isr of the core
+static inline void delay(uint32_t time_ms)
+{
+    while (time_ms-- != 0)
+        delayMicroseconds(1000);
+}
+
+#endif // ONEWIREHUB_BARE_METAL
+
 #ifdef ONEWIREHUB_FALLBACK_BASIC_FNs
 
 #define INPUT 1
@@ -305,7 +423,11 @@ constexpr uint8_t VALUE_IPL{10}; // instructions per loop, uncalibrated so far -
 #define HIGH 1
 #define LOW 0
 
+#ifdef ONEWIREHUB_HOST_SIM
+static thread_local bool mockup_pin_value[256]; // every worker of the simulator runs its own hubs
+#else
 static bool mockup_pin_value[256];
+#endif
 
 template <typename T1>
 bool digitalRead(const T1 pin) { return (mockup_pin_value[pin & 0xFF] != 0); }; // mock up outputs
@@ -325,7 +447,11 @@ T1 *portInputRegister(const T1 port) { return port; };
 template <typename T1>
 T1 digitalPinToBitMask(const T1 pin) { return pin; };
 
+#if defined(ONEWIREHUB_HOST_SIM) || defined(ONEWIREHUB_LINUX_GPIO)
+constexpr uint32_t microsecondsToClockCycles(const uint32_t micros) { return (8 * micros); }; // simulated attiny25 @ 8 MHz
+#else
 constexpr uint32_t microsecondsToClockCycles(const uint32_t micros) { return (100 * micros); }; // mockup, emulate 100 MHz CPU
+#endif
 
 template <typename T1>
 void delayMicroseconds(const T1 micros){};
@@ -375,6 +501,8 @@ public:
 
 } Serial;
 
+#ifndef ONEWIREHUB_BARE_METAL // avr-libc brings them (string.h), and delay() is above
+
 template <typename T1, typename T2>
 void memset(T1 *const address, const T1 initValue, const T2 bytes)
 {
@@ -410,8 +538,17 @@ bool memcmp(const T1 *const source_A, const T1 *const source_B, const T2 bytes)
 void delay(uint32_t time_millis);
 uint32_t millis(void);
 
+#endif // ONEWIREHUB_BARE_METAL
+
+#if !defined(__AVR__) // avr-libc brings these as macros
 void wdt_reset(void);
 void wdt_enable(...);
+#endif
+
+#ifndef WDTO_15MS
+#define WDTO_15MS 0
+#define WDTO_60MS 2
+#endif
 
 #ifndef PROGMEM
 #define PROGMEM
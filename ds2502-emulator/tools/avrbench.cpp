@@ -0,0 +1,569 @@
+// firmware in the loop: the built elf runs cycle by cycle in simavr, the master of this process drives the 1-Wire pin of the simulated mcu
+// - this is the code avr-gcc emitted, with the core, the isr and the fuses of the build -> no mockups of platform.h involved
+// - master: AN126 timing in cycles of the mcu clock, the query of the EC (common/ecquery.h): reset, presence, 0xCC, 0xF0 0x08 0x00, then the crc and 3 bytes
+// - the line is the wired-and of the master and the pin (ddr set, port low), the pin reads the line while the firmware releases it
+// - per scenario: cycles from the release of a reset to the presence, from the start of a read slot to the low of the hub and to its
+//   release, margins to the sample points of the master. error scenarios (one per Error path the master can provoke) also report the
+//   recovery: shortest gap after the error that still gets the next query through, bisected over fresh runs
+// - seeds of owfuzz (-s, common/masterscript.h) run as further error scenarios: the worst cases of the host build in cycles
+// - output is csv (scenario,metric,value), with -c an earlier csv is compared line by line -> numbers of one commit against the last
+//
+// needs libsimavr and libelf, not part of "make all": make build/avrbench
+//
+// usage: avrbench [-m mcu] [-f f_cpu] [-p pin_of_port_b] [-c previous.csv] [-s seed ..] firmware.elf
+
+#include "../src/DS2502.h"
+#include "../src/OneWireHub.h"
+#include "common/ecquery.h"
+#include "common/masterscript.h"
+
+#include <simavr/avr_ioport.h>
+#include <simavr/sim_avr.h>
+#include <simavr/sim_cycle_timers.h>
+#include <simavr/sim_elf.h>
+#include <simavr/sim_irq.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+constexpr uint32_t DEFAULT_F_CPU{8000000};
+constexpr uint8_t DEFAULT_PIN{2};           // pin_onewire of the sketch (PB2), the USI engine uses PB0
+constexpr uint32_t BOOT_US{5000};           // first reset after power-on, the core and setup() are through by then
+constexpr uint32_t SHORT_RESET_US{300};     // below ONEWIRE_TIME_RESET_MIN, above every slot
+constexpr uint32_t LONG_RESET_US{6000};     // above ONEWIRE_TIME_RESET_TIMEOUT -> VERY_LONG_RESET
+constexpr uint32_t RECOVERY_MAX_US{30000};  // a hub that needs longer than this after an error counts as not recovering
+constexpr uint32_t RECOVERY_STEP_US{10};    // resolution of the bisection
+constexpr uint32_t RUN_LIMIT_US{200000};    // a run that takes longer is stuck (firmware crashed or master script wrong)
+
+// the master in cycles: a script of line changes and samples, run by one cycle timer of simavr
+struct Op
+{
+    enum Kind : uint8_t
+    {
+        DRIVE_LOW,
+        RELEASE,
+        SAMPLE,
+        END
+    };
+    enum Tag : uint8_t
+    {
+        NONE,
+        RESET_SLOT,
+        WRITE_SLOT,
+        READ_SLOT,
+        PRESENCE
+    };
+
+    Kind kind;
+    Tag tag;
+    uint32_t wait; // cycles to the next op
+};
+
+class Script
+{
+private:
+    const double cycles_per_us;
+    double scale{1.0}; // of the slot and presence times, "scale" of a seed
+
+    uint32_t cycles(const double time_us) const { return uint32_t(time_us * cycles_per_us + 0.5); }
+
+    uint32_t slot(const double time_us) const { return cycles(time_us * scale); }
+
+public:
+    std::vector<Op> ops;
+
+    explicit Script(const uint32_t f_cpu) : cycles_per_us(f_cpu / 1e6){};
+
+    void idle(const double time_us) { ops.push_back({Op::RELEASE, Op::NONE, cycles(time_us)}); }
+
+    void reset(const double low_us = MASTER_TIME_RESET_US)
+    {
+        ops.push_back({Op::DRIVE_LOW, Op::RESET_SLOT, cycles(low_us)});
+        ops.push_back({Op::RELEASE, Op::RESET_SLOT, slot(MASTER_TIME_PRESENCE_SAMPLE_US)});
+        ops.push_back({Op::SAMPLE, Op::PRESENCE, slot(MASTER_TIME_RESET_REST_US)});
+    }
+
+    void write(const uint8_t byte, const uint8_t bits = 8)
+    {
+        for (uint8_t bit = 0; bit < bits; ++bit)
+        {
+            const bool one = ((byte >> bit) & 1) != 0;
+            ops.push_back({Op::DRIVE_LOW, Op::WRITE_SLOT, slot(one ? MASTER_TIME_WRITE_ONE_US : MASTER_TIME_WRITE_ZERO_US)});
+            ops.push_back({Op::RELEASE, Op::NONE, slot(one ? MASTER_TIME_WRITE_ONE_REST_US : MASTER_TIME_WRITE_ZERO_REST_US)});
+        }
+    }
+
+    void read(const uint8_t bytes, const uint8_t bits = 8) { readBits(uint32_t(bytes) * bits); }
+
+    void readBits(const uint32_t bits)
+    {
+        for (uint32_t bit = 0; bit < bits; ++bit)
+        {
+            ops.push_back({Op::DRIVE_LOW, Op::READ_SLOT, slot(MASTER_TIME_WRITE_ONE_US)});
+            ops.push_back({Op::RELEASE, Op::NONE, slot(MASTER_TIME_READ_SAMPLE_US)});
+            ops.push_back({Op::SAMPLE, Op::READ_SLOT, slot(MASTER_TIME_READ_REST_US)});
+        }
+    }
+
+    // a seed of owfuzz, the scale ends with it
+    void replay(const std::vector<MasterOp> &seed)
+    {
+        for (const MasterOp &op : seed)
+        {
+            switch (op.kind)
+            {
+            case MasterOp::RESET:
+                reset(op.value);
+                break;
+            case MasterOp::WRITE:
+                write(uint8_t(op.value), uint8_t(op.bits));
+                break;
+            case MasterOp::READ:
+                readBits(op.value);
+                break;
+            case MasterOp::IDLE:
+                idle(op.value);
+                break;
+            case MasterOp::SCALE:
+                scale = op.value / 100.0;
+                break;
+            }
+        }
+        scale = 1.0;
+    }
+
+    // the query of the EC
+    void query(void)
+    {
+        reset();
+        for (const uint8_t value : EC_QUERY_TX)
+            write(value);
+        read(EC_QUERY_RX_BYTES);
+    }
+
+    void end(void) { ops.push_back({Op::END, Op::NONE, 0}); }
+};
+
+// what the master saw in one run
+struct Observation
+{
+    std::vector<uint64_t> presence_latency; // release of a reset to the low of the hub
+    std::vector<uint64_t> presence_width;
+    std::vector<bool> presence_sampled; // per reset
+    std::vector<uint64_t> read_response; // start of a read slot to the low of the hub
+    std::vector<uint64_t> read_hold;     // start of a read slot to the release by the hub
+    std::vector<uint8_t> rx;             // bits sampled in read slots, lsb first
+    uint8_t rx_bits{0};
+    uint32_t write_collisions{0}; // hub low while the master wrote
+    bool finished{false};
+};
+
+class FirmwareBench
+{
+private:
+    avr_t *avr{nullptr};
+    avr_irq_t *pin_irq{nullptr};
+    const uint8_t pin_mask;
+
+    const Script &script;
+    size_t op_index{0};
+    Observation &seen;
+
+    bool master_low{false};
+    uint8_t ddr{0};
+    uint8_t port{0};
+    bool hub_low{false};
+
+    Op::Tag slot{Op::NONE};
+    uint64_t slot_start{0};
+    uint64_t release{0}; // of the last reset
+    bool presence_open{false};
+    uint64_t presence_start{0};
+
+    bool lineLow(void) const { return master_low || hub_low; }
+
+    // the pin reads what the outside drives, simavr masks it with the port while the firmware has the pin as output
+    void driveExternal(void) { avr_raise_irq(pin_irq, master_low ? 0 : 1); }
+
+    void hubChanged(void)
+    {
+        const bool low = ((ddr & pin_mask) != 0) && ((port & pin_mask) == 0);
+        if (low == hub_low)
+            return;
+        hub_low = low;
+        const uint64_t now = avr->cycle;
+        if (low)
+        {
+            if (slot == Op::RESET_SLOT)
+            {
+                presence_open = true;
+                presence_start = now;
+                seen.presence_latency.push_back(now - release);
+            }
+            else if (slot == Op::READ_SLOT)
+                seen.read_response.push_back(now - slot_start);
+            else if (slot == Op::WRITE_SLOT)
+                ++seen.write_collisions;
+        }
+        else
+        {
+            if (presence_open)
+            {
+                presence_open = false;
+                seen.presence_width.push_back(now - presence_start);
+            }
+            else if (slot == Op::READ_SLOT)
+                seen.read_hold.push_back(now - slot_start);
+        }
+    }
+
+    static void onDirection(avr_irq_t *, const uint32_t value, void *const param)
+    {
+        FirmwareBench *const bench = static_cast<FirmwareBench *>(param);
+        bench->ddr = uint8_t(value);
+        bench->hubChanged();
+    }
+
+    static void onPort(avr_irq_t *, const uint32_t value, void *const param)
+    {
+        FirmwareBench *const bench = static_cast<FirmwareBench *>(param);
+        bench->port = uint8_t(value);
+        bench->hubChanged();
+    }
+
+    // runs the ops that are due, returns the cycle of the next one (0: script is through)
+    avr_cycle_count_t step(const avr_cycle_count_t when)
+    {
+        while (op_index < script.ops.size())
+        {
+            const Op &op = script.ops[op_index++];
+            switch (op.kind)
+            {
+            case Op::DRIVE_LOW:
+                master_low = true;
+                slot = op.tag;
+                slot_start = when;
+                presence_open = false;
+                break;
+            case Op::RELEASE:
+                master_low = false;
+                if (op.tag == Op::RESET_SLOT)
+                    release = when; // slot stays RESET until the next low, the presence belongs to it
+                break;
+            case Op::SAMPLE:
+                if (op.tag == Op::PRESENCE)
+                    seen.presence_sampled.push_back(lineLow());
+                else
+                {
+                    if (seen.rx_bits % 8 == 0)
+                        seen.rx.push_back(0);
+                    if (!lineLow())
+                        seen.rx.back() |= uint8_t(1 << (seen.rx_bits % 8));
+                    ++seen.rx_bits;
+                }
+                break;
+            case Op::END:
+                seen.finished = true;
+                return 0;
+            }
+            driveExternal();
+            if (op.wait != 0)
+                return when + op.wait;
+        }
+        return 0;
+    }
+
+    static avr_cycle_count_t onTimer(avr_t *, const avr_cycle_count_t when, void *const param)
+    {
+        return static_cast<FirmwareBench *>(param)->step(when);
+    }
+
+public:
+    FirmwareBench(const Script &script, Observation &seen, const uint8_t pin) : pin_mask(uint8_t(1 << pin)), script(script), seen(seen){};
+
+    ~FirmwareBench(void)
+    {
+        if (avr != nullptr)
+            avr_terminate(avr);
+    }
+
+    bool run(elf_firmware_t &firmware, const char *const mcu, const uint32_t f_cpu, const uint8_t pin)
+    {
+        avr = avr_make_mcu_by_name(mcu);
+        if ((avr == nullptr) || (avr_init(avr) != 0))
+            return false;
+        avr_load_firmware(avr, &firmware);
+        avr->frequency = f_cpu;
+        avr->log = LOG_NONE;
+
+        pin_irq = avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), pin);
+        avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_DIRECTION_ALL), onDirection, this);
+        avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ('B'), IOPORT_IRQ_REG_PORT), onPort, this);
+        driveExternal(); // pull-up of the master
+
+        avr_cycle_timer_register(avr, 1, onTimer, this);
+        const uint64_t limit = uint64_t(RUN_LIMIT_US) * (f_cpu / 1000000);
+        while (!seen.finished && (avr->cycle < limit))
+        {
+            const int state = avr_run(avr);
+            if ((state == cpu_Done) || (state == cpu_Crashed))
+                return false;
+        }
+        return seen.finished;
+    }
+};
+
+struct Setup
+{
+    elf_firmware_t firmware;
+    std::string mcu{"attiny25"};
+    uint32_t f_cpu{DEFAULT_F_CPU};
+    uint8_t pin{DEFAULT_PIN};
+};
+
+// the scripts load a fresh copy of the firmware, every run starts at power-on
+static bool runScript(Setup &setup, const Script &script, Observation &seen)
+{
+    elf_firmware_t firmware = setup.firmware;
+    FirmwareBench bench(script, seen, setup.pin);
+    return bench.run(firmware, setup.mcu.c_str(), setup.f_cpu, setup.pin);
+}
+
+// the last query of the script got its presence and the right bytes
+static bool queryGood(const Observation &seen)
+{
+    if (seen.presence_sampled.empty() || !seen.presence_sampled.back() || (seen.rx.size() < EC_QUERY_RX_BYTES))
+        return false;
+    return ecQueryCheck(&seen.rx[seen.rx.size() - EC_QUERY_RX_BYTES], memory) == EcOutcome::IDENTIFIED;
+}
+
+using Metrics = std::vector<std::pair<std::string, int64_t>>;
+
+static void addRange(Metrics &metrics, const std::string &name, const std::vector<uint64_t> &values)
+{
+    if (values.empty())
+        return;
+    metrics.push_back({name + "_min", int64_t(*std::min_element(values.begin(), values.end()))});
+    metrics.push_back({name + "_max", int64_t(*std::max_element(values.begin(), values.end()))});
+}
+
+// the error part of a scenario, the query follows after gap_us
+struct Scenario
+{
+    std::string name;
+    std::function<void(Script &script)> provoke;
+};
+
+// one per Error of the hub a master can provoke: VERY_SHORT_RESET, VERY_LONG_RESET, INCORRECT_ONEWIRE_CMD,
+// FIRST_BIT_OF_BYTE_TIMEOUT (master stops in the middle of a byte), RESET_IN_PROGRESS (reset while the hub sends)
+static const Scenario SCENARIOS[] = {
+    {"short_reset", [](Script &script) { script.reset(SHORT_RESET_US); }},
+    {"long_reset", [](Script &script) { script.reset(LONG_RESET_US); }},
+    {"wrong_command",
+     [](Script &script) {
+         script.reset();
+         script.write(0x42);
+     }},
+    {"stop_in_byte",
+     [](Script &script) {
+         script.reset();
+         script.write(0xCC);
+         script.write(0xF0, 4);
+     }},
+    {"reset_in_read",
+     [](Script &script) {
+         script.reset();
+         for (const uint8_t value : EC_QUERY_TX)
+             script.write(value);
+         script.read(1, 5);
+     }},
+};
+
+static bool recovers(Setup &setup, const Scenario &scenario, const uint32_t gap_us, Observation &seen)
+{
+    Script script(setup.f_cpu);
+    script.idle(BOOT_US);
+    scenario.provoke(script);
+    script.idle(gap_us);
+    script.query();
+    script.end();
+    return runScript(setup, script, seen) && queryGood(seen);
+}
+
+static bool measureQuery(Setup &setup, Metrics &metrics)
+{
+    Script script(setup.f_cpu);
+    script.idle(BOOT_US);
+    script.query();
+    script.end();
+    Observation seen;
+    const bool finished = runScript(setup, script, seen);
+
+    const uint64_t cycles_per_us = setup.f_cpu / 1000000;
+    const uint64_t presence_sample = MASTER_TIME_PRESENCE_SAMPLE_US * cycles_per_us;
+    const uint64_t read_sample = (MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US) * cycles_per_us;
+
+    metrics.push_back({"identified", (finished && queryGood(seen)) ? 1 : 0});
+    addRange(metrics, "presence_latency", seen.presence_latency);
+    addRange(metrics, "presence_width", seen.presence_width);
+    addRange(metrics, "read_response", seen.read_response);
+    addRange(metrics, "read_hold", seen.read_hold);
+    metrics.push_back({"write_collisions", seen.write_collisions});
+    if (!seen.presence_latency.empty())
+        metrics.push_back({"presence_margin", int64_t(presence_sample) - int64_t(seen.presence_latency.front())}); // < 0: sampled too early
+    if (!seen.read_response.empty())
+        metrics.push_back({"response_margin", int64_t(read_sample) - int64_t(*std::max_element(seen.read_response.begin(), seen.read_response.end()))});
+    if (!seen.read_hold.empty())
+        metrics.push_back({"hold_margin", int64_t(*std::min_element(seen.read_hold.begin(), seen.read_hold.end())) - int64_t(read_sample)});
+    return finished;
+}
+
+static bool measureScenario(Setup &setup, const Scenario &scenario, Metrics &metrics)
+{
+    Observation seen;
+    if (!recovers(setup, scenario, RECOVERY_MAX_US, seen))
+    {
+        metrics.push_back({"recovery_cycles", -1}); // not even after RECOVERY_MAX_US
+        return seen.finished;
+    }
+    addRange(metrics, "presence_latency", seen.presence_latency);
+
+    uint32_t low = 0, high = RECOVERY_MAX_US; // high recovers
+    Observation immediate;
+    if (recovers(setup, scenario, 0, immediate))
+        high = 0;
+    while (high - low > RECOVERY_STEP_US)
+    {
+        const uint32_t middle = (low + high) / 2;
+        Observation probe;
+        if (recovers(setup, scenario, middle, probe))
+            high = middle;
+        else
+            low = middle;
+    }
+    metrics.push_back({"recovery_cycles", int64_t(high) * int64_t(setup.f_cpu / 1000000)});
+    return true;
+}
+
+static std::map<std::string, int64_t> readCsv(const char *const path)
+{
+    std::map<std::string, int64_t> values;
+    FILE *const file = fopen(path, "r");
+    if (file == nullptr)
+        return values;
+    char line[256];
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        // scenario,metric,cycles[,previous,delta] -> a compared csv works as the next baseline too
+        char *const first = strchr(line, ',');
+        char *const second = (first != nullptr) ? strchr(first + 1, ',') : nullptr;
+        if ((second == nullptr) || (strncmp(line, "scenario,", 9) == 0))
+            continue;
+        *second = 0;
+        values[line] = strtoll(second + 1, nullptr, 10);
+    }
+    fclose(file);
+    return values;
+}
+
+int main(int argc, char *argv[])
+{
+    Setup setup;
+    const char *previous = nullptr;
+    const char *elf = nullptr;
+    std::vector<std::string> seeds;
+    bool usable = true;
+    for (int index = 1; index < argc; ++index)
+    {
+        const char *const flag = argv[index];
+        if (flag[0] != '-')
+        {
+            elf = flag;
+            continue;
+        }
+        if (index + 1 >= argc)
+        {
+            usable = false;
+            break;
+        }
+        const char *const value = argv[++index];
+        if (strcmp(flag, "-m") == 0)
+            setup.mcu = value;
+        else if (strcmp(flag, "-f") == 0)
+            setup.f_cpu = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-p") == 0)
+            setup.pin = uint8_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-c") == 0)
+            previous = value;
+        else if (strcmp(flag, "-s") == 0)
+            seeds.push_back(value);
+        else
+            usable = false;
+    }
+    if (!usable || (elf == nullptr) || (setup.pin > 7) || (setup.f_cpu < 1000000))
+    {
+        fprintf(stderr, "usage: %s [-m mcu] [-f f_cpu] [-p pin_of_port_b] [-c previous.csv] [-s seed ..] firmware.elf\n", argv[0]);
+        return 2;
+    }
+    memset(&setup.firmware, 0, sizeof(setup.firmware));
+    if (elf_read_firmware(elf, &setup.firmware) != 0)
+    {
+        fprintf(stderr, "can't load %s\n", elf);
+        return 2;
+    }
+
+    std::vector<Scenario> scenarios(std::begin(SCENARIOS), std::end(SCENARIOS));
+    for (const std::string &path : seeds)
+    {
+        std::vector<MasterOp> ops;
+        std::string error;
+        if (!readMasterScript(path, ops, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 2;
+        }
+        const size_t slash = path.rfind('/');
+        const std::string name = path.substr((slash == std::string::npos) ? 0 : slash + 1);
+        scenarios.push_back({"seed:" + name.substr(0, name.rfind(".seed")), [ops](Script &script) { script.replay(ops); }});
+    }
+
+    std::vector<std::pair<std::string, Metrics>> results;
+    results.push_back({"query", {}});
+    bool complete = measureQuery(setup, results.back().second);
+    for (const Scenario &scenario : scenarios)
+    {
+        results.push_back({scenario.name, {}});
+        complete &= measureScenario(setup, scenario, results.back().second);
+    }
+
+    const std::map<std::string, int64_t> before = (previous != nullptr) ? readCsv(previous) : std::map<std::string, int64_t>();
+    printf("scenario,metric,%s\n", (previous != nullptr) ? "cycles,previous,delta" : "cycles");
+    for (const auto &result : results)
+    {
+        for (const auto &metric : result.second)
+        {
+            const std::string key = result.first + "," + metric.first;
+            const auto old = before.find(key);
+            if (previous == nullptr)
+                printf("%s,%" PRId64 "\n", key.c_str(), metric.second);
+            else if (old == before.end())
+                printf("%s,%" PRId64 ",,\n", key.c_str(), metric.second);
+            else
+                printf("%s,%" PRId64 ",%" PRId64 ",%+" PRId64 "\n", key.c_str(), metric.second, old->second, metric.second - old->second);
+        }
+    }
+    if (!complete)
+    {
+        fprintf(stderr, "a run did not finish: firmware crashed or never released the line\n");
+        return 1;
+    }
+    return (results.front().second.front().second == 1) ? 0 : 1; // identified
+}
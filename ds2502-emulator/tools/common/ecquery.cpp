@@ -0,0 +1,23 @@
+#include "ecquery.h"
+
+#include "../../src/OneWireItem.h"
+
+#include <cstring>
+
+const uint8_t EC_QUERY_TX[EC_QUERY_TX_BYTES] = {0xCC, 0xF0, EC_QUERY_ADDRESS, 0x00};
+
+const char *const EC_OUTCOME_NAMES[EC_OUTCOME_COUNT] = {"IDENTIFIED", "NO_PRESENCE", "CRC_ERROR", "DATA_ERROR"};
+
+bool ecQueryWriteOne(const uint8_t slot)
+{
+    return (EC_QUERY_TX[slot / 8] & (1 << (slot % 8))) != 0;
+}
+
+EcOutcome ecQueryCheck(const uint8_t rx[EC_QUERY_RX_BYTES], const uint8_t image[])
+{
+    if (rx[0] != OneWireItem::crc8(&EC_QUERY_TX[1], EC_QUERY_TX_BYTES - 1)) // the device's crc covers command and address
+        return EcOutcome::CRC_ERROR;
+    if (memcmp(&rx[1], &image[EC_QUERY_ADDRESS], EC_QUERY_RX_BYTES - 1) != 0)
+        return EcOutcome::DATA_ERROR;
+    return EcOutcome::IDENTIFIED;
+}
@@ -0,0 +1,37 @@
+// the query of the EC of the laptop, the master of fleetsim, gpiobench and avrbench: reset, presence, 0xCC, 0xF0 0x08 0x00,
+// then it reads the crc of command and address and 3 bytes of the identity (wattage)
+// - the tools play the slots in their own time (virtual us, busy waits, cycles of simavr), the bytes and the check are these
+// - the slots are numbered like on the line: the write slots of EC_QUERY_TX first, then the read slots, lsb first
+
+#ifndef TOOLS_COMMON_ECQUERY_H
+#define TOOLS_COMMON_ECQUERY_H
+
+#include <cstdint>
+
+constexpr uint8_t EC_QUERY_TX_BYTES{4}; // skip rom, read memory, address 0x0008
+constexpr uint8_t EC_QUERY_RX_BYTES{4}; // crc of cmd and address, 3 bytes of the identity
+constexpr uint8_t EC_QUERY_ADDRESS{8};
+constexpr uint8_t EC_QUERY_WRITE_SLOTS{8 * EC_QUERY_TX_BYTES};
+constexpr uint8_t EC_QUERY_SLOTS{8 * (EC_QUERY_TX_BYTES + EC_QUERY_RX_BYTES)};
+
+extern const uint8_t EC_QUERY_TX[EC_QUERY_TX_BYTES];
+
+enum class EcOutcome : uint8_t
+{
+    IDENTIFIED,
+    NO_PRESENCE,
+    CRC_ERROR,
+    DATA_ERROR
+};
+
+constexpr uint8_t EC_OUTCOME_COUNT{4};
+
+extern const char *const EC_OUTCOME_NAMES[EC_OUTCOME_COUNT];
+
+// value of a write slot, slot < EC_QUERY_WRITE_SLOTS
+bool ecQueryWriteOne(uint8_t slot);
+
+// the bytes of the read slots after a presence, against the image the hub serves (memory[] of DS2502.h)
+EcOutcome ecQueryCheck(const uint8_t rx[EC_QUERY_RX_BYTES], const uint8_t image[]);
+
+#endif // TOOLS_COMMON_ECQUERY_H
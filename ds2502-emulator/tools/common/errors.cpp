@@ -0,0 +1,22 @@
+#include "errors.h"
+
+#include "../../src/OneWireHub.h"
+
+static_assert(uint8_t(Error::RESET_IN_PROGRESS) == (ERROR_COUNT - 1), "a new Error of the hub needs its name here");
+
+const char *const ERROR_NAMES[ERROR_COUNT] = {"NO_ERROR",
+                                              "READ_TIMESLOT_TIMEOUT",
+                                              "WRITE_TIMESLOT_TIMEOUT",
+                                              "WAIT_RESET_TIMEOUT",
+                                              "VERY_LONG_RESET",
+                                              "VERY_SHORT_RESET",
+                                              "PRESENCE_LOW_ON_LINE",
+                                              "READ_TIMESLOT_TIMEOUT_LOW",
+                                              "AWAIT_TIMESLOT_TIMEOUT_HIGH",
+                                              "PRESENCE_HIGH_ON_LINE",
+                                              "INCORRECT_ONEWIRE_CMD",
+                                              "INCORRECT_SLAVE_USAGE",
+                                              "TRIED_INCORRECT_WRITE",
+                                              "FIRST_TIMESLOT_TIMEOUT",
+                                              "FIRST_BIT_OF_BYTE_TIMEOUT",
+                                              "RESET_IN_PROGRESS"};
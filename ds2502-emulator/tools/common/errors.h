@@ -0,0 +1,13 @@
+// names of the Error codes of OneWireHub (src/OneWireHub.h) for the output of the tools: annotations of the fleetsim traces,
+// reports and seed files of owfuzz
+
+#ifndef TOOLS_COMMON_ERRORS_H
+#define TOOLS_COMMON_ERRORS_H
+
+#include <cstdint>
+
+constexpr uint8_t ERROR_COUNT{16}; // NO_ERROR .. RESET_IN_PROGRESS
+
+extern const char *const ERROR_NAMES[ERROR_COUNT];
+
+#endif // TOOLS_COMMON_ERRORS_H
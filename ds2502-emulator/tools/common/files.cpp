@@ -0,0 +1,26 @@
+#include "files.h"
+
+#include <cerrno>
+#include <sys/stat.h>
+
+bool makeDirectories(const std::string &path)
+{
+    size_t end = 0;
+    while (end != std::string::npos)
+    {
+        end = path.find('/', end + 1);
+        const std::string part = path.substr(0, end);
+        if ((mkdir(part.c_str(), 0777) != 0) && (errno != EEXIST))
+            return false;
+    }
+
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0)
+        return false;
+    if (!S_ISDIR(info.st_mode))
+    {
+        errno = ENOTDIR;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,11 @@
+// output directories of the tools (-o of provision and owfuzz): created on the way, like "mkdir -p"
+
+#ifndef TOOLS_COMMON_FILES_H
+#define TOOLS_COMMON_FILES_H
+
+#include <string>
+
+// true if path is a directory afterwards, errno tells why not
+bool makeDirectories(const std::string &path);
+
+#endif // TOOLS_COMMON_FILES_H
@@ -0,0 +1,132 @@
+#include "masterscript.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+static bool parseOp(char *const line, MasterOp &op, bool &empty)
+{
+    char *const comment = strchr(line, '#');
+    if (comment != nullptr)
+        *comment = 0;
+    const char *const name = strtok(line, " \t\r\n");
+    empty = (name == nullptr);
+    if (empty)
+        return true;
+    const char *const first = strtok(nullptr, " \t\r\n");
+    const char *const second = strtok(nullptr, " \t\r\n");
+    if ((first == nullptr) || (strtok(nullptr, " \t\r\n") != nullptr))
+        return false;
+
+    char *end = nullptr;
+    op.value = uint32_t(strtoul(first, &end, (strcmp(name, "write") == 0) ? 16 : 10));
+    if (*end != 0)
+        return false;
+    op.bits = 8;
+
+    if (strcmp(name, "write") == 0)
+    {
+        op.kind = MasterOp::WRITE;
+        if (second != nullptr)
+        {
+            op.bits = uint16_t(strtoul(second, &end, 10));
+            if (*end != 0)
+                return false;
+        }
+        return (op.value <= 0xFF) && (op.bits >= 1) && (op.bits <= 8);
+    }
+    if (second != nullptr)
+        return false;
+    if (strcmp(name, "read") == 0)
+    {
+        op.kind = MasterOp::READ;
+        return (op.value >= 1) && (op.value <= MASTERSCRIPT_READ_LIMIT);
+    }
+    if (strcmp(name, "scale") == 0)
+    {
+        op.kind = MasterOp::SCALE;
+        return (op.value >= MASTERSCRIPT_SCALE_MIN) && (op.value <= MASTERSCRIPT_SCALE_MAX);
+    }
+    if (strcmp(name, "reset") == 0)
+        op.kind = MasterOp::RESET;
+    else if (strcmp(name, "idle") == 0)
+        op.kind = MasterOp::IDLE;
+    else
+        return false;
+    return (op.value <= MASTERSCRIPT_US_LIMIT);
+}
+
+bool readMasterScript(const std::string &path, std::vector<MasterOp> &ops, std::string &error)
+{
+    ops.clear();
+    FILE *const file = fopen(path.c_str(), "r");
+    if (file == nullptr)
+    {
+        error = path + ": can't open";
+        return false;
+    }
+    char line[256];
+    uint32_t number = 0;
+    while (fgets(line, sizeof(line), file) != nullptr)
+    {
+        ++number;
+        MasterOp op;
+        bool empty = false;
+        if (!parseOp(line, op, empty))
+        {
+            error = path + ":" + std::to_string(number) + ": no op or value out of range";
+            fclose(file);
+            return false;
+        }
+        if (!empty)
+            ops.push_back(op);
+    }
+    fclose(file);
+    return true;
+}
+
+std::string formatMasterOp(const MasterOp &op)
+{
+    char text[32];
+    switch (op.kind)
+    {
+    case MasterOp::RESET:
+        snprintf(text, sizeof(text), "reset %u", unsigned(op.value));
+        break;
+    case MasterOp::WRITE:
+        if (op.bits == 8)
+            snprintf(text, sizeof(text), "write %02x", unsigned(op.value));
+        else
+            snprintf(text, sizeof(text), "write %02x %u", unsigned(op.value), unsigned(op.bits));
+        break;
+    case MasterOp::READ:
+        snprintf(text, sizeof(text), "read %u", unsigned(op.value));
+        break;
+    case MasterOp::IDLE:
+        snprintf(text, sizeof(text), "idle %u", unsigned(op.value));
+        break;
+    case MasterOp::SCALE:
+        snprintf(text, sizeof(text), "scale %u", unsigned(op.value));
+        break;
+    }
+    return text;
+}
+
+bool writeMasterScript(const std::string &path, const std::vector<MasterOp> &ops, const std::string &comment)
+{
+    FILE *const file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+    size_t start = 0;
+    while (start < comment.size())
+    {
+        size_t end = comment.find('\n', start);
+        if (end == std::string::npos)
+            end = comment.size();
+        fprintf(file, "# %s\n", comment.substr(start, end - start).c_str());
+        start = end + 1;
+    }
+    for (const MasterOp &op : ops)
+        fprintf(file, "%s\n", formatMasterOp(op).c_str());
+    return (fclose(file) == 0);
+}
@@ -0,0 +1,46 @@
+// what a 1-Wire master does on the line, as text: the seeds of owfuzz, replayed in simavr by avrbench (-s)
+// - one op per line, '#' starts a comment, values are decimal except the byte of "write"
+//     reset <low_us>        line low, release, presence sampled after MASTER_TIME_PRESENCE_SAMPLE_US, rest MASTER_TIME_RESET_REST_US
+//     write <hex> [bits]    write slots lsb first, 8 bits unless given (a master that stops in the middle of a byte)
+//     read <bits>           read slots, low MASTER_TIME_WRITE_ONE_US, sample after MASTER_TIME_READ_SAMPLE_US
+//     idle <us>             line released
+//     scale <percent>       slot and presence times of the following ops against AN126, reset lows and idles stay
+// - the times are the MASTER_TIME_* of OneWireHub_config.h, every tool expands them in its own unit (us, cycles)
+
+#ifndef TOOLS_COMMON_MASTERSCRIPT_H
+#define TOOLS_COMMON_MASTERSCRIPT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct MasterOp
+{
+    enum Kind : uint8_t
+    {
+        RESET,
+        WRITE,
+        READ,
+        IDLE,
+        SCALE
+    };
+
+    Kind kind;
+    uint32_t value; // low_us, byte, bits, us or percent
+    uint16_t bits;  // of a write, 1 .. 8
+};
+
+constexpr uint32_t MASTERSCRIPT_US_LIMIT{100000};  // of one reset low or idle
+constexpr uint32_t MASTERSCRIPT_READ_LIMIT{2048};  // bits of one read
+constexpr uint32_t MASTERSCRIPT_SCALE_MIN{25};     // percent
+constexpr uint32_t MASTERSCRIPT_SCALE_MAX{400};
+
+// false on a line it can't parse or a value out of its range, error names the line
+bool readMasterScript(const std::string &path, std::vector<MasterOp> &ops, std::string &error);
+
+// comment goes on top, one "# " line per '\n'
+bool writeMasterScript(const std::string &path, const std::vector<MasterOp> &ops, const std::string &comment);
+
+std::string formatMasterOp(const MasterOp &op);
+
+#endif // TOOLS_COMMON_MASTERSCRIPT_H
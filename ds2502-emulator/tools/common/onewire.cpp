@@ -0,0 +1,113 @@
+#include "onewire.h"
+
+OneWireDecoder::OneWireDecoder(OneWireListener &listener, const uint64_t samplerate)
+    : listener(listener), us_per_sample(1e6 / double(samplerate)), remaining(0){};
+
+void OneWireDecoder::enter(const OneWirePhase next, const uint8_t bit_count)
+{
+    phase = next;
+    remaining = bit_count;
+    byte = 0;
+    bits = 0;
+}
+
+void OneWireDecoder::command(const uint8_t value)
+{
+    if (phase == OneWirePhase::ROM_COMMAND)
+    {
+        if (value == 0xCC)
+            enter(OneWirePhase::FUNCTION, 8);
+        else if (value == 0x33)
+            enter(OneWirePhase::ROM_READ, 64);
+        else if (value == 0x55)
+            enter(OneWirePhase::ROM_WRITE, 64);
+        else
+            enter(OneWirePhase::UNKNOWN, 0); // search rom: triplets
+    }
+    else if ((phase == OneWirePhase::ROM_WRITE) || (phase == OneWirePhase::ROM_READ))
+        enter(OneWirePhase::FUNCTION, 8);
+    else if (phase == OneWirePhase::FUNCTION)
+    {
+        if ((value == 0xF0) || (value == 0xAA) || (value == 0xC3))
+            enter(OneWirePhase::ADDRESS, 16);
+        else
+            enter(OneWirePhase::UNKNOWN, 0); // programming
+    }
+    else if (phase == OneWirePhase::ADDRESS)
+        enter(OneWirePhase::READ, 0);
+}
+
+void OneWireDecoder::closeSlot(void)
+{
+    if (!slot_open)
+        return;
+    slot_open = false;
+
+    slot.one = (slot.low_us < BIT_ONE_MAX_US);
+    listener.slot(slot);
+    if (!slot.known)
+        return;
+
+    byte |= uint8_t(slot.one ? (1 << (bits % 8)) : 0);
+    ++bits;
+    const uint8_t value = byte;
+    if ((bits % 8) == 0)
+    {
+        listener.byte(phase, value);
+        byte = 0;
+    }
+    if ((phase == OneWirePhase::READ) || (--remaining != 0))
+        return;
+    command(value);
+}
+
+void OneWireDecoder::low(const uint64_t start, const uint64_t end)
+{
+    const double start_us = double(start) * us_per_sample;
+    const double end_us = double(end) * us_per_sample;
+    const double width_us = end_us - start_us;
+
+    if (slot_open && (start_us - slot.start_us < SLOT_JOIN_US))
+    {
+        slot.low_us = end_us - slot.start_us; // the device holds a zero after the master released the line
+        return;
+    }
+    closeSlot();
+
+    if (width_us >= LINE_DOWN_US)
+    {
+        phase = OneWirePhase::IDLE;
+        listener.lineDown(start_us, width_us);
+        return;
+    }
+    if (width_us >= RESET_LOW_US)
+    {
+        phase = OneWirePhase::PRESENCE;
+        rise_us = end_us;
+        listener.reset(start_us, width_us);
+        return;
+    }
+    if (phase == OneWirePhase::IDLE)
+        return;
+    if (phase == OneWirePhase::PRESENCE)
+    {
+        enter(OneWirePhase::ROM_COMMAND, 8);
+        if (start_us - rise_us <= PRESENCE_WAIT_MAX_US)
+        {
+            listener.presence(start_us - rise_us, width_us);
+            return;
+        }
+    }
+
+    slot_open = true;
+    slot.start_us = start_us;
+    slot.master_low_us = width_us;
+    slot.low_us = width_us;
+    slot.known = (phase != OneWirePhase::UNKNOWN);
+    slot.write = (phase != OneWirePhase::ROM_READ) && (phase != OneWirePhase::READ);
+}
+
+void OneWireDecoder::finish(void)
+{
+    closeSlot();
+}
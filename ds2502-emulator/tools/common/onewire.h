@@ -0,0 +1,85 @@
+// 1-Wire from the lows of one line in a capture (owtiming, owdecode): resets, presence pulses, slots and the bytes of a transaction
+// - every low of the line is a reset, a presence, a slot or the line going down (longer than ONEWIRE_TIME_RESET_TIMEOUT)
+// - a low that starts shortly after the start of a slot belongs to it: the device answers a read-slot after the master released the line
+// - the transaction is followed (rom command, read memory / status / data, address) to tell write-slots of the master from read-slots,
+//   search rom and the programming commands are not -> their slots are unknown until the next reset
+
+#ifndef TOOLS_COMMON_ONEWIRE_H
+#define TOOLS_COMMON_ONEWIRE_H
+
+#include <cstdint>
+
+constexpr double LINE_DOWN_US{5000};       // like ONEWIRE_TIME_RESET_TIMEOUT, longer lows are no reset
+constexpr double RESET_LOW_US{300};        // like ONEWIRE_TIME_ADAPT_RESET_MIN_LOW, no slot is that long
+constexpr double PRESENCE_WAIT_MAX_US{75}; // the presence starts this late after the reset at most (spec: 60us)
+constexpr double SLOT_JOIN_US{15};         // a low that starts within this of a slot start is the answer of the device
+constexpr double BIT_ONE_MAX_US{15};       // slot that is high again before the master samples is a one
+
+enum class OneWirePhase : uint8_t
+{
+    IDLE,        // before the first reset
+    PRESENCE,    // reset seen, the next low may be the presence
+    ROM_COMMAND, // slots written by the master
+    ROM_WRITE,   // match rom
+    ROM_READ,    // read rom
+    FUNCTION,    // function command
+    ADDRESS,     // 2 bytes of read memory / status / data
+    READ,        // reads until the next reset
+    UNKNOWN
+};
+
+struct OneWireSlot
+{
+    double start_us;
+    double master_low_us; // first low, a device that answers right away hides the end of the master in it
+    double low_us;        // to the last release, the device holds a zero after the master released the line
+    bool known;           // the transaction was followed up to here
+    bool write;           // of the master, a read-slot otherwise
+    bool one;             // high again before the master samples
+};
+
+// what the decoder saw, in the order of the line
+class OneWireListener
+{
+public:
+    virtual ~OneWireListener(void) = default;
+
+    virtual void lineDown(double start_us, double width_us){};
+    virtual void reset(double start_us, double width_us){};
+    virtual void presence(double wait_us, double width_us){};
+    virtual void slot(const OneWireSlot &slot){};
+    virtual void byte(OneWirePhase phase, uint8_t value){}; // every 8 known slots of a phase, lsb first
+};
+
+// the slots of a transaction, as far as the decoder can follow it
+class OneWireDecoder
+{
+private:
+    OneWireListener &listener;
+    const double us_per_sample;
+
+    OneWirePhase phase{OneWirePhase::IDLE};
+    double rise_us{0}; // end of the last reset
+    uint8_t byte{0};
+    uint8_t bits{0};   // of byte
+    uint8_t remaining; // bits of the current phase
+
+    bool slot_open{false};
+    OneWireSlot slot{};
+
+    void enter(OneWirePhase next, uint8_t bit_count);
+    void command(uint8_t value); // a whole phase of the master arrived, what follows it
+    void closeSlot(void);
+
+public:
+    OneWireDecoder(OneWireListener &listener, uint64_t samplerate);
+
+    // one low of the line from sample start to sample end
+    void low(uint64_t start, uint64_t end);
+
+    void finish(void); // the line stays high, the last slot is complete
+
+    OneWirePhase getPhase(void) const { return phase; };
+};
+
+#endif // TOOLS_COMMON_ONEWIRE_H
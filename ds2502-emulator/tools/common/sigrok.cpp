@@ -0,0 +1,553 @@
+#include "sigrok.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr uint32_t ZIP_LOCAL_HEADER{0x04034b50};
+constexpr uint32_t ZIP_DATA_DESCRIPTOR{0x08074b50};
+constexpr uint32_t ZIP_CENTRAL_HEADER{0x02014b50};
+constexpr uint32_t ZIP_END_OF_DIRECTORY{0x06054b50};
+constexpr uint32_t ZIP64_END_OF_DIRECTORY{0x06064b50};
+constexpr uint32_t ZIP64_END_LOCATOR{0x07064b50};
+constexpr uint16_t ZIP64_EXTRA{0x0001};
+constexpr uint16_t ZIP_VERSION{20};
+constexpr uint16_t ZIP_FLAG_DESCRIPTOR{1 << 3};
+constexpr uint16_t ZIP_METHOD_DEFLATE{8};
+constexpr size_t ZIP_OUTPUT_SIZE{64 * 1024};
+
+// little endian fields of the zip headers
+static void append16(std::vector<uint8_t> &header, const uint32_t value)
+{
+    header.push_back(uint8_t(value));
+    header.push_back(uint8_t(value >> 8));
+}
+
+static void append32(std::vector<uint8_t> &header, const uint32_t value)
+{
+    append16(header, value & 0xFFFF);
+    append16(header, value >> 16);
+}
+
+ZipWriter::ZipWriter(void) : output(ZIP_OUTPUT_SIZE)
+{
+    memset(&stream, 0, sizeof(stream));
+}
+
+ZipWriter::~ZipWriter(void)
+{
+    if (in_entry)
+        deflateEnd(&stream);
+    if (file != nullptr)
+        fclose(file);
+}
+
+bool ZipWriter::open(const std::string &path)
+{
+    file = fopen(path.c_str(), "wb");
+    offset = 0;
+    entries.clear();
+    return (file != nullptr);
+}
+
+bool ZipWriter::put(const void *const data, const size_t size)
+{
+    offset += uint32_t(size);
+    return (fwrite(data, 1, size, file) == size);
+}
+
+bool ZipWriter::begin(const std::string &name, const bool deflated)
+{
+    if ((file == nullptr) || in_entry)
+        return false;
+    if (deflated && (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK))
+        return false;
+    in_entry = deflated;
+    entries.push_back({name, offset, 0, 0, 0, deflated});
+
+    std::vector<uint8_t> header;
+    append32(header, ZIP_LOCAL_HEADER);
+    append16(header, ZIP_VERSION);
+    append16(header, ZIP_FLAG_DESCRIPTOR);
+    append16(header, deflated ? ZIP_METHOD_DEFLATE : 0);
+    append32(header, 0); // time and date
+    append32(header, 0); // crc and sizes follow in the descriptor
+    append32(header, 0);
+    append32(header, 0);
+    append16(header, uint32_t(name.size()));
+    append16(header, 0);
+    return put(header.data(), header.size()) && put(name.data(), name.size());
+}
+
+bool ZipWriter::deflateInto(const int flush)
+{
+    Entry &entry = entries.back();
+    do
+    {
+        stream.next_out = output.data();
+        stream.avail_out = uInt(output.size());
+        if (deflate(&stream, flush) == Z_STREAM_ERROR)
+            return false;
+        const size_t produced = output.size() - stream.avail_out;
+        entry.compressed_size += uint32_t(produced);
+        if (!put(output.data(), produced))
+            return false;
+    } while (stream.avail_out == 0);
+    return true;
+}
+
+bool ZipWriter::write(const void *const data, const size_t size)
+{
+    if (entries.empty())
+        return false;
+    Entry &entry = entries.back();
+    entry.crc = uint32_t(crc32(entry.crc, static_cast<const Bytef *>(data), uInt(size)));
+    entry.size += uint32_t(size);
+    if (!entry.deflated)
+    {
+        entry.compressed_size += uint32_t(size);
+        return put(data, size);
+    }
+    stream.next_in = static_cast<Bytef *>(const_cast<void *>(data));
+    stream.avail_in = uInt(size);
+    return deflateInto(Z_NO_FLUSH);
+}
+
+bool ZipWriter::end(void)
+{
+    if (entries.empty())
+        return false;
+    bool good = true;
+    if (in_entry)
+    {
+        stream.next_in = nullptr;
+        stream.avail_in = 0;
+        good = deflateInto(Z_FINISH);
+        deflateEnd(&stream);
+        in_entry = false;
+    }
+
+    const Entry &entry = entries.back();
+    std::vector<uint8_t> descriptor;
+    append32(descriptor, ZIP_DATA_DESCRIPTOR);
+    append32(descriptor, entry.crc);
+    append32(descriptor, entry.compressed_size);
+    append32(descriptor, entry.size);
+    return put(descriptor.data(), descriptor.size()) && good;
+}
+
+bool ZipWriter::close(void)
+{
+    if (file == nullptr)
+        return false;
+
+    const uint32_t directory_offset = offset;
+    bool good = !in_entry;
+    for (const Entry &entry : entries)
+    {
+        std::vector<uint8_t> header;
+        append32(header, ZIP_CENTRAL_HEADER);
+        append16(header, ZIP_VERSION);
+        append16(header, ZIP_VERSION);
+        append16(header, ZIP_FLAG_DESCRIPTOR);
+        append16(header, entry.deflated ? ZIP_METHOD_DEFLATE : 0);
+        append32(header, 0);
+        append32(header, entry.crc);
+        append32(header, entry.compressed_size);
+        append32(header, entry.size);
+        append16(header, uint32_t(entry.name.size()));
+        append32(header, 0); // extra and comment length
+        append32(header, 0); // disk, internal attributes
+        append32(header, 0); // external attributes
+        append32(header, entry.offset);
+        good &= put(header.data(), header.size()) && put(entry.name.data(), entry.name.size());
+    }
+
+    std::vector<uint8_t> end;
+    append32(end, ZIP_END_OF_DIRECTORY);
+    append32(end, 0); // disk numbers
+    append16(end, uint32_t(entries.size()));
+    append16(end, uint32_t(entries.size()));
+    append32(end, offset - directory_offset);
+    append32(end, directory_offset);
+    append16(end, 0);
+    good &= put(end.data(), end.size());
+
+    good &= (fclose(file) == 0);
+    file = nullptr;
+    return good;
+}
+
+bool SigrokWriter::open(const std::string &path, const uint64_t samplerate, const std::vector<std::string> &probes)
+{
+    if (probes.empty() || (probes.size() > 8) || !zip.open(path))
+        return false;
+
+    char rate[32];
+    if ((samplerate % 1000000) == 0)
+        snprintf(rate, sizeof(rate), "%u MHz", unsigned(samplerate / 1000000));
+    else if ((samplerate % 1000) == 0)
+        snprintf(rate, sizeof(rate), "%u kHz", unsigned(samplerate / 1000));
+    else
+        snprintf(rate, sizeof(rate), "%u Hz", unsigned(samplerate));
+
+    std::string metadata = "[global]\nsigrok version=0.5.2\n\n[device 1]\ncapturefile=logic-1\ntotal probes=" + std::to_string(probes.size()) +
+                           "\nsamplerate=" + rate + "\ntotal analog=0\n";
+    for (size_t index = 0; index < probes.size(); ++index)
+        metadata += "probe" + std::to_string(index + 1) + "=" + probes[index] + "\n";
+    metadata += "unitsize=1\n";
+
+    good = zip.begin("version", false) && zip.write("2", 1) && zip.end() && zip.begin("metadata", true) &&
+           zip.write(metadata.data(), metadata.size()) && zip.end();
+    buffer.reserve(SIGROK_BUFFER_SIZE);
+    chunk_samples = 0;
+    chunk_index = 0;
+    value = 0;
+    samples = 0;
+    return good;
+}
+
+bool SigrokWriter::flush(void)
+{
+    if (buffer.empty())
+        return true;
+    if ((chunk_samples == 0) && !zip.begin("logic-1-" + std::to_string(++chunk_index), true))
+        return false;
+    const bool written = zip.write(buffer.data(), buffer.size());
+    chunk_samples += uint32_t(buffer.size());
+    buffer.clear();
+    if (chunk_samples >= SIGROK_CHUNK_SIZE)
+    {
+        chunk_samples = 0;
+        return zip.end() && written;
+    }
+    return written;
+}
+
+void SigrokWriter::advance(const uint64_t sample, const uint8_t next_value)
+{
+    while (good && (samples < sample))
+    {
+        // a run is cut at the end of the buffer, so every chunk ends on a full buffer
+        const uint64_t room = SIGROK_BUFFER_SIZE - buffer.size();
+        const uint64_t run = std::min<uint64_t>(sample - samples, room);
+        buffer.insert(buffer.end(), size_t(run), value);
+        samples += run;
+        if (buffer.size() == SIGROK_BUFFER_SIZE)
+            good = flush();
+    }
+    value = next_value;
+}
+
+bool SigrokWriter::close(void)
+{
+    good = good && flush() && ((chunk_samples == 0) || zip.end());
+    return zip.close() && good;
+}
+
+// little endian fields of the zip headers
+static uint32_t field16(const uint8_t *const data)
+{
+    return uint32_t(data[0]) | (uint32_t(data[1]) << 8);
+}
+
+static uint32_t field32(const uint8_t *const data)
+{
+    return field16(data) | (field16(data + 2) << 16);
+}
+
+static uint64_t field64(const uint8_t *const data)
+{
+    return uint64_t(field32(data)) | (uint64_t(field32(data + 4)) << 32);
+}
+
+ZipReader::~ZipReader(void)
+{
+    close();
+}
+
+void ZipReader::close(void)
+{
+    if (map != nullptr)
+        munmap(const_cast<uint8_t *>(map), size_t(map_size));
+    map = nullptr;
+    map_size = 0;
+    entries.clear();
+    index.clear();
+}
+
+const ZipReader::Entry *ZipReader::find(const std::string &name) const
+{
+    const auto found = index.find(name);
+    return (found == index.end()) ? nullptr : &entries[found->second];
+}
+
+bool ZipReader::open(const std::string &path)
+{
+    close();
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0)
+        return false;
+    struct stat status;
+    if ((fstat(descriptor, &status) == 0) && (status.st_size >= 22))
+    {
+        void *const mapped = mmap(nullptr, size_t(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (mapped != MAP_FAILED)
+        {
+            map = static_cast<const uint8_t *>(mapped);
+            map_size = uint64_t(status.st_size);
+            madvise(mapped, size_t(map_size), MADV_SEQUENTIAL);
+        }
+    }
+    ::close(descriptor);
+    if (map == nullptr)
+        return false;
+
+    // end of the central directory: last record of the file, followed by a comment of up to 64k
+    const uint64_t tail_start = map_size - std::min<uint64_t>(map_size, 22 + 0xFFFF);
+    uint64_t position = map_size - 22;
+    while ((position > tail_start) && (field32(map + position) != ZIP_END_OF_DIRECTORY))
+        --position;
+    if (field32(map + position) != ZIP_END_OF_DIRECTORY)
+        return false;
+    const uint8_t *const end = map + position;
+    uint64_t count = field16(end + 10);
+    uint64_t directory_size = field32(end + 12);
+    uint64_t directory_offset = field32(end + 16);
+
+    // zip64: the locator right before it points to the end of the zip64 directory with the full counts
+    if ((position >= 20) && (field32(map + position - 20) == ZIP64_END_LOCATOR))
+    {
+        const uint64_t end64 = field64(map + position - 20 + 8);
+        if ((end64 + 56 > position) || (field32(map + end64) != ZIP64_END_OF_DIRECTORY))
+            return false;
+        count = field64(map + end64 + 32);
+        directory_size = field64(map + end64 + 40);
+        directory_offset = field64(map + end64 + 48);
+    }
+    if ((directory_offset > map_size) || (directory_size > map_size - directory_offset))
+        return false;
+
+    const uint8_t *const directory = map + directory_offset;
+    entries.reserve(size_t(std::min<uint64_t>(count, directory_size / 46)));
+    uint64_t offset = 0;
+    for (uint64_t number = 0; number < count; ++number)
+    {
+        if ((offset + 46 > directory_size) || (field32(directory + offset) != ZIP_CENTRAL_HEADER))
+            return false;
+        const uint8_t *const header = directory + offset;
+        const size_t name_size = field16(header + 28);
+        const size_t extra_size = field16(header + 30);
+        const uint64_t skip = 46 + name_size + extra_size + field16(header + 32);
+        if (offset + skip > directory_size)
+            return false;
+        Entry entry{std::string(reinterpret_cast<const char *>(header + 46), name_size), field32(header + 42), field32(header + 16),
+                    field32(header + 24), field32(header + 20), uint16_t(field16(header + 10))};
+
+        // the fields that don't fit are 0xFFFFFFFF and follow in the zip64 extra field, in this order
+        const uint8_t *extra = header + 46 + name_size;
+        const uint8_t *const extra_end = extra + extra_size;
+        while (extra + 4 <= extra_end)
+        {
+            const uint32_t id = field16(extra);
+            const uint8_t *const data_end = std::min(extra + 4 + field16(extra + 2), extra_end);
+            const uint8_t *data = extra + 4;
+            if (id == ZIP64_EXTRA)
+            {
+                for (uint64_t *const value : {&entry.size, &entry.compressed_size, &entry.offset})
+                {
+                    if (*value != 0xFFFFFFFF)
+                        continue;
+                    if (data + 8 > data_end)
+                        return false;
+                    *value = field64(data);
+                    data += 8;
+                }
+            }
+            extra = data_end;
+        }
+
+        index.emplace(entry.name, entries.size());
+        entries.push_back(std::move(entry));
+        offset += skip;
+    }
+    return true;
+}
+
+uint64_t ZipReader::size(const std::string &name) const
+{
+    const Entry *const entry = find(name);
+    return (entry == nullptr) ? 0 : entry->size;
+}
+
+bool ZipReader::read(const std::string &name, std::vector<uint8_t> &piece, const std::function<void(const uint8_t *, size_t)> &consume) const
+{
+    const Entry *const entry = find(name);
+    if ((entry == nullptr) || ((entry->method != 0) && (entry->method != ZIP_METHOD_DEFLATE)) || piece.empty() ||
+        (piece.size() > 0xFFFFFFFFu))
+        return false;
+
+    // the local header may carry another extra field than the central one
+    if ((entry->offset + 30 > map_size) || (field32(map + entry->offset) != ZIP_LOCAL_HEADER))
+        return false;
+    const uint64_t start = entry->offset + 30 + field16(map + entry->offset + 26) + field16(map + entry->offset + 28);
+    if ((start > map_size) || (entry->compressed_size > map_size - start))
+        return false;
+    const uint8_t *const compressed = map + start;
+
+    uLong crc = crc32(0, nullptr, 0);
+    uint64_t out_left = entry->size;
+    const auto deliver = [&](const size_t size) {
+        crc = crc32(crc, piece.data(), uInt(size));
+        consume(piece.data(), size);
+        out_left -= size;
+    };
+
+    if (entry->method == 0)
+    {
+        if (entry->compressed_size != entry->size)
+            return false;
+        while (out_left != 0)
+        {
+            const size_t size = size_t(std::min<uint64_t>(out_left, piece.size()));
+            memcpy(piece.data(), compressed + (entry->size - out_left), size);
+            deliver(size);
+        }
+        return (uint32_t(crc) == entry->crc);
+    }
+
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+        return false;
+    // avail_in is 32 bit. once all is out, one more byte of room lets it read the end of the stream
+    uint64_t in_left = entry->compressed_size;
+    stream.next_in = const_cast<uint8_t *>(compressed);
+    int status = Z_OK;
+    while (status == Z_OK)
+    {
+        if (stream.avail_in == 0)
+        {
+            stream.avail_in = uInt(std::min<uint64_t>(in_left, 1u << 30));
+            in_left -= stream.avail_in;
+        }
+        const uInt room = uInt(std::min<uint64_t>(std::max<uint64_t>(out_left, 1), piece.size()));
+        stream.next_out = piece.data();
+        stream.avail_out = room;
+        status = inflate(&stream, Z_NO_FLUSH);
+        const size_t size = room - stream.avail_out;
+        if (size > out_left)
+            status = Z_DATA_ERROR;
+        else if (size != 0)
+            deliver(size);
+    }
+    inflateEnd(&stream);
+    return (status == Z_STREAM_END) && (out_left == 0) && (uint32_t(crc) == entry->crc);
+}
+
+bool ZipReader::read(const std::string &name, std::vector<uint8_t> &data) const
+{
+    // the whole entry is one piece
+    const uint64_t entry_size = size(name);
+    data.resize(size_t(std::max<uint64_t>(entry_size, 1)));
+    const bool good = read(name, data, [](const uint8_t *, size_t) {});
+    data.resize(size_t(entry_size));
+    return good;
+}
+
+bool SigrokReader::open(const std::string &path)
+{
+    std::vector<uint8_t> metadata;
+    if (!zip.open(path) || !zip.read("metadata", metadata))
+        return false;
+
+    // ini of libsigrok, only the keys of the logic probes matter
+    probes.clear();
+    samplerate = 0;
+    unitsize = 1;
+    bool in_device = false;
+    const std::string text(metadata.begin(), metadata.end());
+    size_t start = 0;
+    while (start < text.size())
+    {
+        size_t stop = text.find('\n', start);
+        if (stop == std::string::npos)
+            stop = text.size();
+        const std::string line = text.substr(start, stop - start);
+        start = stop + 1;
+
+        if (!line.empty() && (line[0] == '['))
+        {
+            if (in_device)
+                break; // first device only
+            in_device = (line == "[device 1]");
+            continue;
+        }
+        const size_t equal = line.find('=');
+        if (!in_device || (equal == std::string::npos))
+            continue;
+        const std::string key = line.substr(0, equal);
+        const std::string value = line.substr(equal + 1);
+
+        if (key == "samplerate")
+        {
+            char *unit = nullptr;
+            const double number = strtod(value.c_str(), &unit);
+            while (*unit == ' ')
+                ++unit;
+            const double scale = (*unit == 'G') ? 1e9 : (*unit == 'M') ? 1e6 : (*unit == 'k') ? 1e3 : 1.0;
+            samplerate = uint64_t(number * scale + 0.5);
+        }
+        else if (key == "unitsize")
+            unitsize = uint8_t(strtoul(value.c_str(), nullptr, 10));
+        else if ((key.compare(0, 5, "probe") == 0) && (key.size() > 5))
+        {
+            const size_t index = strtoul(key.c_str() + 5, nullptr, 10);
+            if ((index == 0) || (index > 64))
+                continue;
+            if (probes.size() < index)
+                probes.resize(index);
+            probes[index - 1] = value;
+        }
+    }
+
+    chunk_count = 0;
+    while (zip.has("logic-1-" + std::to_string(chunk_count + 1)))
+        ++chunk_count;
+    return (samplerate != 0) && (unitsize != 0) && (probes.size() <= 8u * unitsize) && (chunk_count != 0);
+}
+
+int SigrokReader::findProbe(const std::string &name) const
+{
+    for (size_t index = 0; index < probes.size(); ++index)
+    {
+        if (probes[index] == name)
+            return int(index);
+    }
+    return -1;
+}
+
+uint64_t SigrokReader::getChunkSamples(const uint32_t index) const
+{
+    return (index < chunk_count) ? zip.size("logic-1-" + std::to_string(index + 1)) / unitsize : 0;
+}
+
+bool SigrokReader::readChunk(const uint32_t index, std::vector<uint8_t> &samples) const
+{
+    return (index < chunk_count) && zip.read("logic-1-" + std::to_string(index + 1), samples) && ((samples.size() % unitsize) == 0);
+}
+
+bool SigrokReader::readChunk(const uint32_t index, std::vector<uint8_t> &buffer,
+                             const std::function<void(const uint8_t *, size_t)> &consume) const
+{
+    if ((index >= chunk_count) || ((zip.size("logic-1-" + std::to_string(index + 1)) % unitsize) != 0))
+        return false;
+    buffer.resize(size_t(SIGROK_BUFFER_SIZE) * unitsize); // every piece but the last is full -> whole samples
+    const size_t size = unitsize;
+    return zip.read("logic-1-" + std::to_string(index + 1), buffer,
+                    [&consume, size](const uint8_t *const data, const size_t bytes) { consume(data, bytes / size); });
+}
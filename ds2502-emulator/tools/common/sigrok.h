@@ -0,0 +1,142 @@
+// sigrok session files (.sr) of the tools: a zip with "version", "metadata" and the samples in chunks "logic-1-1", "logic-1-2" ..
+// - one byte per sample (unitsize=1), bit n is probe n+1, like the captures in pulse-view/
+// - written as a stream: entries are deflated on the fly with a data descriptor, memory stays at one buffer
+// - read chunk by chunk: only the central directory and the inflated chunks in use are held in memory, the file is mapped
+
+#ifndef TOOLS_COMMON_SIGROK_H
+#define TOOLS_COMMON_SIGROK_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zlib.h>
+
+constexpr uint32_t SIGROK_CHUNK_SIZE{4 * 1024 * 1024}; // samples per logic-1-n, like libsigrok
+constexpr uint32_t SIGROK_BUFFER_SIZE{64 * 1024};      // samples deflated / streamed out of a chunk at once
+
+// zip archive written front to back, entries can't be seeked -> sizes and crc follow each entry in a data descriptor
+class ZipWriter
+{
+private:
+    struct Entry
+    {
+        std::string name;
+        uint32_t offset;
+        uint32_t crc;
+        uint32_t size;
+        uint32_t compressed_size;
+        bool deflated;
+    };
+
+    FILE *file{nullptr};
+    std::vector<Entry> entries;
+    z_stream stream;
+    bool in_entry{false};
+    uint32_t offset{0};
+    std::vector<uint8_t> output;
+
+    bool put(const void *data, size_t size);
+    bool deflateInto(int flush);
+
+public:
+    ZipWriter(void);
+    ~ZipWriter(void);
+
+    bool open(const std::string &path);
+    bool begin(const std::string &name, bool deflated);
+    bool write(const void *data, size_t size);
+    bool end(void);
+    bool close(void); // writes the central directory, false if anything went wrong on the way
+};
+
+class SigrokWriter
+{
+private:
+    ZipWriter zip;
+    std::vector<uint8_t> buffer;
+    uint32_t chunk_samples{0};
+    uint32_t chunk_index{0};
+    uint8_t value{0};
+    uint64_t samples{0};
+    bool good{false};
+
+    bool flush(void);
+
+public:
+    // probes are named in order, at most 8
+    bool open(const std::string &path, uint64_t samplerate, const std::vector<std::string> &probes);
+
+    // the probes keep value until sample, then change to next_value
+    void advance(uint64_t sample, uint8_t next_value);
+
+    uint64_t getSamples(void) const { return samples; };
+
+    bool close(void);
+};
+
+// zip archive read through its central directory, an entry is inflated as a whole
+// - the file is mapped: read() inflates straight out of the mapping and can run on several threads at once
+// - zip64 for archives beyond 4GB or 65535 entries (long captures)
+class ZipReader
+{
+private:
+    struct Entry
+    {
+        std::string name;
+        uint64_t offset; // of the local header
+        uint32_t crc;
+        uint64_t size;
+        uint64_t compressed_size;
+        uint16_t method;
+    };
+
+    const uint8_t *map{nullptr};
+    uint64_t map_size{0};
+    std::vector<Entry> entries;
+    std::unordered_map<std::string, size_t> index; // name -> entry
+
+    const Entry *find(const std::string &name) const;
+    void close(void);
+
+public:
+    ~ZipReader(void);
+
+    bool open(const std::string &path);
+    bool has(const std::string &name) const { return (find(name) != nullptr); };
+    uint64_t size(const std::string &name) const; // uncompressed, 0 if there is no such entry
+    bool read(const std::string &name, std::vector<uint8_t> &data) const; // false on a broken entry or a wrong crc
+
+    // streamed: inflated piece.size() bytes at a time, consume gets every piece while it is still in the cache.
+    // a wrong crc is only known at the end, after all pieces went to consume
+    bool read(const std::string &name, std::vector<uint8_t> &piece, const std::function<void(const uint8_t *data, size_t size)> &consume) const;
+};
+
+class SigrokReader
+{
+private:
+    ZipReader zip;
+    uint64_t samplerate{0};
+    uint8_t unitsize{1};
+    std::vector<std::string> probes;
+    uint32_t chunk_count{0};
+
+public:
+    bool open(const std::string &path); // "logic-1-*" chunks of the first device only
+
+    uint64_t getSamplerate(void) const { return samplerate; };
+    uint8_t getUnitSize(void) const { return unitsize; }; // bytes per sample
+    const std::vector<std::string> &getProbes(void) const { return probes; };
+    int findProbe(const std::string &name) const; // bit of the probe in a sample, -1 if there is none
+
+    uint32_t getChunkCount(void) const { return chunk_count; };
+    uint64_t getChunkSamples(uint32_t index) const; // without inflating it
+    bool readChunk(uint32_t index, std::vector<uint8_t> &samples) const; // index 0 is "logic-1-1", any thread
+
+    // streamed through buffer, SIGROK_BUFFER_SIZE samples at a time
+    bool readChunk(uint32_t index, std::vector<uint8_t> &buffer, const std::function<void(const uint8_t *samples, size_t count)> &consume) const;
+};
+
+#endif // TOOLS_COMMON_SIGROK_H
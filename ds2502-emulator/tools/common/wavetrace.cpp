@@ -0,0 +1,115 @@
+#include "wavetrace.h"
+
+#include <algorithm>
+#include <cmath>
+
+constexpr uint8_t WAVETRACE_CHANNEL_LIMIT{7}; // one probe of the sample byte is the annotation
+
+// short identifiers of the vcd: '!' for channel 0 and so on, the annotation gets the next two
+static char vcdId(const uint8_t index)
+{
+    return char('!' + index);
+}
+
+bool WaveTrace::open(const std::string &path_base, const uint64_t samplerate, const std::vector<std::string> &channels)
+{
+    if (channels.empty() || (channels.size() > WAVETRACE_CHANNEL_LIMIT) || (samplerate == 0))
+        return false;
+    this->path_base = path_base;
+    this->samplerate = samplerate;
+    this->channels = channels;
+    edges.clear();
+    texts.clear();
+    levels = 0;
+    last_time_ns = 0;
+    recording = true;
+    return true;
+}
+
+uint64_t WaveTrace::clampTime(const double time_us) const
+{
+    return std::max<uint64_t>(last_time_ns, uint64_t(llround(time_us * 1000.0)));
+}
+
+void WaveTrace::change(const double time_us, const uint8_t channel, const bool level)
+{
+    if (!recording || (channel >= channels.size()) || (((levels >> channel) & 1) == uint8_t(level)))
+        return;
+    last_time_ns = clampTime(time_us);
+    levels ^= uint8_t(1 << channel);
+    edges.push_back({last_time_ns, channel, levels, 0});
+}
+
+void WaveTrace::annotate(const double time_us, const char *const text)
+{
+    if (!recording)
+        return;
+    const uint8_t channel = uint8_t(channels.size());
+    last_time_ns = clampTime(time_us);
+    levels ^= uint8_t(1 << channel);
+    edges.push_back({last_time_ns, channel, levels, uint32_t(texts.size())});
+    texts.push_back(text);
+}
+
+bool WaveTrace::write(const uint64_t end_ns) const
+{
+    const uint8_t channel_count = uint8_t(channels.size());
+    std::vector<std::string> probes(channels);
+    probes.push_back("annotation");
+    SigrokWriter sigrok;
+    if (!sigrok.open(path_base + ".sr", samplerate, probes))
+        return false;
+
+    FILE *const vcd = fopen((path_base + ".vcd").c_str(), "w");
+    if (vcd == nullptr)
+    {
+        sigrok.close();
+        return false;
+    }
+    fprintf(vcd, "$timescale 1ns $end\n$scope module onewire $end\n");
+    for (uint8_t index = 0; index < channel_count; ++index)
+        fprintf(vcd, "$var wire 1 %c %s $end\n", vcdId(index), channels[index].c_str());
+    fprintf(vcd, "$var wire 1 %c annotation $end\n", vcdId(channel_count));
+    fprintf(vcd, "$var string 1 %c annotation_text $end\n", vcdId(channel_count + 1));
+    fprintf(vcd, "$upscope $end\n$enddefinitions $end\n#0\n$dumpvars\n");
+    for (uint8_t index = 0; index <= channel_count; ++index)
+        fprintf(vcd, "0%c\n", vcdId(index));
+    fprintf(vcd, "s- %c\n$end\n", vcdId(channel_count + 1)); // "-": no annotation yet
+
+    // a time stamp only where the time moves on, the samples between two edges keep the levels before them
+    uint64_t stamped_ns = 0;
+    for (const Edge &edge : edges)
+    {
+        if (edge.time_ns != stamped_ns)
+            fprintf(vcd, "#%llu\n", static_cast<unsigned long long>(edge.time_ns));
+        stamped_ns = edge.time_ns;
+        const char level = ((edge.levels >> edge.channel) & 1) ? '1' : '0';
+        if (edge.channel == channel_count)
+            fprintf(vcd, "%c%c\ns%s %c\n", level, vcdId(channel_count), texts[edge.text].c_str(), vcdId(channel_count + 1));
+        else
+            fprintf(vcd, "%c%c\n", level, vcdId(edge.channel));
+        sigrok.advance(edge.time_ns * samplerate / 1000000000ULL, edge.levels);
+    }
+    if (end_ns != stamped_ns)
+        fprintf(vcd, "#%llu\n", static_cast<unsigned long long>(end_ns));
+    sigrok.advance(end_ns * samplerate / 1000000000ULL, levels);
+
+    const bool sigrok_good = sigrok.close();
+    const bool vcd_good = (fclose(vcd) == 0);
+    return sigrok_good && vcd_good;
+}
+
+bool WaveTrace::close(const double time_us)
+{
+    if (!recording)
+        return false;
+    recording = false;
+    return write(clampTime(time_us));
+}
+
+void WaveTrace::discard(void)
+{
+    recording = false;
+    edges.clear();
+    texts.clear();
+}
@@ -0,0 +1,51 @@
+// waveform of a simulation run, written to a VCD (gtkwave, pulseview import) and a sigrok session (pulseview) side by side
+// - channels change at increasing times only. a run only records its edges, close() expands them into both files ->
+//   a run that gets discarded (e.g. an identified unit of fleetsim) costs no file and no sample
+// - annotations (e.g. an Error of the hub) are a string variable in the VCD, the sigrok file has no text: its "annotation"
+//   probe toggles at every annotation instead
+
+#ifndef TOOLS_COMMON_WAVETRACE_H
+#define TOOLS_COMMON_WAVETRACE_H
+
+#include "sigrok.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+class WaveTrace
+{
+private:
+    struct Edge
+    {
+        uint64_t time_ns;
+        uint8_t channel; // channel_count -> annotation
+        uint8_t levels;  // after the edge
+        uint32_t text;   // of an annotation, index into texts
+    };
+
+    std::string path_base;
+    uint64_t samplerate{0};
+    std::vector<std::string> channels;
+    std::vector<Edge> edges;
+    std::vector<std::string> texts;
+    uint8_t levels{0}; // bit n is channel n, the annotation probe follows the channels
+    uint64_t last_time_ns{0};
+    bool recording{false};
+
+    uint64_t clampTime(double time_us) const;
+    bool write(uint64_t end_ns) const;
+
+public:
+    // starts a run of path_base.vcd and path_base.sr, all channels start low. nothing is written before close()
+    bool open(const std::string &path_base, uint64_t samplerate, const std::vector<std::string> &channels);
+
+    void change(double time_us, uint8_t channel, bool level);
+    void annotate(double time_us, const char *text);
+
+    bool close(double time_us); // writes both files, they end at time_us
+    void discard(void);         // drops the run, no file is written
+};
+
+#endif // TOOLS_COMMON_WAVETRACE_H
@@ -0,0 +1,566 @@
+// boot-storm of a fleet in virtual time: every unit is a OneWireHub + DS2502 (built with ONEWIREHUB_HOST_SIM) on its own simulated bus
+// - the hub loops like the attiny25 @ 8 MHz, every read of the line costs one loop, stretched by the oscillator error of the unit
+// - the master plays the EC of the laptop (common/ecquery.h): reset, presence, 0xCC, 0xF0 0x08 0x00, then it reads the crc and 3 bytes (wattage), AN126 timing
+// - per unit: oscillator error of the hub, clock error and per-slot jitter of the master, spikes on the line, boot time of the hub, first query
+// - a failed query (no presence, crc or data wrong) is repeated after the retry time, up to the attempts
+// - with hot-plug detection (-p) an idle master queries right after it sees a presence pulse (POWERUP_PRESENCE_ENABLE of the hub)
+// - units are seeded by their index and share nothing -> results do not depend on the number of threads
+// - with a trace directory (-w) every unit that isn't identified leaves its waveform there as unit-<index>.vcd and .sr,
+//   -W keeps the identified units as well
+//
+// usage: fleetsim [-n units] [-j threads] [-s seed] [-o osc_%] [-m master_%] [-t jitter_us] [-g spikes_per_ms]
+//                 [-b boot_ms_min:max] [-q query_ms_min:max] [-r retry_ms] [-a attempts] [-p] [-S] [-w trace_dir] [-W]
+//   -S runs the fleet with 1, 2, 4 .. threads and prints the speedup per thread count
+
+#include "../src/DS2502.h"
+#include "../src/OneWireHub.h"
+#include "../src/OneWireHubStatic.h"
+#include "common/ecquery.h"
+#include "common/errors.h"
+#include "common/wavetrace.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+static_assert(!WATCHDOG_ENABLE, "the simulator can't restart a hub, disable WATCHDOG_ENABLE");
+static_assert(!USI_ENGINE_ENABLE && !MULTIHUB_ENABLE, "the simulator runs the wait-loop engine of OneWireHub");
+
+constexpr uint32_t CHUNK_UNITS{64};        // units a worker takes at once
+constexpr double HOTPLUG_REACTION_US{100}; // presence pulse seen -> reset of the master
+constexpr uint64_t TRACE_SAMPLERATE{4000000}; // like the captures in pulse-view/
+
+enum TraceChannel : uint8_t
+{
+    TRACE_LINE,
+    TRACE_MASTER, // high while the master pulls the line low
+    TRACE_HUB,
+    TRACE_SPIKE
+};
+
+struct Options
+{
+    uint32_t units{10000};
+    uint32_t threads{0}; // 0 -> all cores
+    uint32_t seed{1};
+    double osc_pct{10.0};    // internal rc of the attiny, factory calibration
+    double master_pct{2.0};  // clock of the EC
+    double jitter_us{2.0};   // per slot, low-time of the master
+    double spikes_per_ms{0}; // short lows from the dc-dc
+    double boot_ms_min{64.0};
+    double boot_ms_max{70.0}; // default fuses: 64ms start-up + init
+    double query_ms_min{0.0};
+    double query_ms_max{100.0};
+    double retry_ms{100.0};
+    uint32_t attempts{5};
+    bool hotplug{false};
+    bool scaling{false};
+    std::string trace_dir; // empty -> no traces
+    bool trace_all{false};
+};
+
+struct UnitResult
+{
+    EcOutcome outcome;
+    uint8_t attempts;
+    uint8_t attempts_up; // queries that started with the hub up and polling
+    float boot_ms;       // power-on to the first poll of the hub
+    float latency_ms;    // power-on to the last slot of the successful query
+};
+
+// one unit: lazy master and line, advanced to the virtual time of the hub whenever it looks at the line
+class SimBus
+{
+private:
+    enum class Step : uint8_t
+    {
+        ATTEMPT,
+        RESET_RELEASE,
+        PRESENCE_SAMPLE,
+        SLOT_START,
+        SLOT_RELEASE,
+        SLOT_SAMPLE,
+        SLOT_END,
+        DONE
+    };
+
+    const Options &options;
+    std::mt19937 random;
+    std::mt19937 spike_random; // own stream: a trace draws spikes ahead of time and must not change the rest of the unit
+
+    double now;     // us since power-on, time of the hub
+    double loop_us; // one wait-loop of the hub
+    double master_scale;
+
+    Step next_step;
+    double next_time;
+    double attempt_start;
+    double slot_end;
+    bool master_low;
+    bool hub_low;
+    double spike_start;
+    double spike_end;
+
+    WaveTrace *trace;
+    std::deque<std::pair<double, bool>> spike_edges; // drawn but not yet in the trace
+    bool spike_traced;
+
+    uint8_t slot;
+    uint8_t rx[EC_QUERY_RX_BYTES];
+
+    UnitResult result;
+
+    double uniform(const double low, const double high)
+    {
+        return std::uniform_real_distribution<double>(low, high)(random);
+    }
+
+    bool lineLow(const double time)
+    {
+        while (time >= spike_end)
+        {
+            spike_start = spike_end + std::exponential_distribution<double>(options.spikes_per_ms / 1000.0)(spike_random);
+            spike_end = spike_start + std::uniform_real_distribution<double>(0.3, 1.5)(spike_random);
+            if (trace != nullptr)
+            {
+                spike_edges.emplace_back(spike_start, true);
+                spike_edges.emplace_back(spike_end, false);
+            }
+        }
+        return master_low || hub_low || (time >= spike_start);
+    }
+
+    void traceLevels(const double time)
+    {
+        trace->change(time, TRACE_MASTER, master_low);
+        trace->change(time, TRACE_HUB, hub_low);
+        trace->change(time, TRACE_SPIKE, spike_traced);
+        trace->change(time, TRACE_LINE, !(master_low || hub_low || spike_traced));
+    }
+
+    // master or hub changed at time: spikes before it go first, drawn up to time so nothing lands in the past later
+    void record(const double time)
+    {
+        if (trace == nullptr)
+            return;
+        lineLow(time);
+        while (!spike_edges.empty() && (spike_edges.front().first <= time))
+        {
+            spike_traced = spike_edges.front().second;
+            traceLevels(spike_edges.front().first);
+            spike_edges.pop_front();
+        }
+        traceLevels(time);
+    }
+
+    void endAttempt(const EcOutcome outcome)
+    {
+        if (trace != nullptr)
+            trace->annotate(next_time, EC_OUTCOME_NAMES[uint8_t(outcome)]);
+        result.outcome = outcome;
+        if ((outcome == EcOutcome::IDENTIFIED) || (result.attempts == options.attempts))
+        {
+            result.latency_ms = float(next_time / 1000.0);
+            next_step = Step::DONE;
+            return;
+        }
+        next_step = Step::ATTEMPT;
+        next_time = attempt_start + options.retry_ms * 1000.0;
+    }
+
+    void step(void)
+    {
+        const double time = next_time;
+        switch (next_step)
+        {
+        case Step::ATTEMPT:
+            ++result.attempts;
+            if (time >= result.boot_ms * 1000.0)
+                ++result.attempts_up;
+            attempt_start = time;
+            master_low = true;
+            record(time);
+            next_step = Step::RESET_RELEASE;
+            next_time = time + MASTER_TIME_RESET_US * master_scale;
+            break;
+
+        case Step::RESET_RELEASE:
+            master_low = false;
+            record(time);
+            next_step = Step::PRESENCE_SAMPLE;
+            next_time = time + MASTER_TIME_PRESENCE_SAMPLE_US * master_scale;
+            break;
+
+        case Step::PRESENCE_SAMPLE:
+            if (!lineLow(time))
+            {
+                endAttempt(EcOutcome::NO_PRESENCE);
+                break;
+            }
+            slot = 0;
+            memset(rx, 0, EC_QUERY_RX_BYTES);
+            next_step = Step::SLOT_START;
+            next_time = time + MASTER_TIME_RESET_REST_US * master_scale;
+            break;
+
+        case Step::SLOT_START:
+        {
+            const bool write_zero = (slot < EC_QUERY_WRITE_SLOTS) && !ecQueryWriteOne(slot);
+            const double low_us = write_zero ? MASTER_TIME_WRITE_ZERO_US : MASTER_TIME_WRITE_ONE_US;
+            const double rest_us = write_zero ? MASTER_TIME_WRITE_ZERO_REST_US : MASTER_TIME_WRITE_ONE_REST_US;
+            const double low = std::max(1.0, low_us * master_scale + uniform(-options.jitter_us, options.jitter_us));
+            master_low = true;
+            record(time);
+            slot_end = time + (low_us + rest_us) * master_scale;
+            next_step = Step::SLOT_RELEASE;
+            next_time = time + low;
+            break;
+        }
+
+        case Step::SLOT_RELEASE:
+            master_low = false;
+            record(time);
+            next_step = (slot < EC_QUERY_WRITE_SLOTS) ? Step::SLOT_END : Step::SLOT_SAMPLE;
+            next_time = (slot < EC_QUERY_WRITE_SLOTS) ? std::max(time, slot_end) : time + MASTER_TIME_READ_SAMPLE_US * master_scale;
+            break;
+
+        case Step::SLOT_SAMPLE:
+        {
+            const uint8_t bit = slot - EC_QUERY_WRITE_SLOTS;
+            if (!lineLow(time))
+                rx[bit / 8] |= uint8_t(1 << (bit % 8));
+            next_step = Step::SLOT_END;
+            next_time = std::max(time, slot_end);
+            break;
+        }
+
+        case Step::SLOT_END:
+            if (++slot < EC_QUERY_SLOTS)
+            {
+                next_step = Step::SLOT_START;
+                break;
+            }
+            endAttempt(ecQueryCheck(rx, memory));
+            break;
+
+        case Step::DONE:
+            break;
+        }
+    }
+
+    void advance(void)
+    {
+        while ((next_step != Step::DONE) && (next_time <= now))
+            step();
+    }
+
+public:
+    SimBus(const Options &options, const uint32_t unit, WaveTrace *const trace)
+        : options(options), trace(trace), spike_traced(false)
+    {
+        std::seed_seq seed{options.seed, unit};
+        random.seed(seed);
+        std::seed_seq spike_seed{options.seed, unit, 1u};
+        spike_random.seed(spike_seed);
+
+        loop_us = VALUE_IPL / (microsecondsToClockCycles(1) * (1.0 + uniform(-options.osc_pct, options.osc_pct) / 100.0));
+        master_scale = 1.0 + uniform(-options.master_pct, options.master_pct) / 100.0;
+        now = uniform(options.boot_ms_min, options.boot_ms_max) * 1000.0; // the hub starts polling here
+        result = {EcOutcome::NO_PRESENCE, 0, 0, float(now / 1000.0), 0.0f};
+
+        next_step = Step::ATTEMPT;
+        next_time = uniform(options.query_ms_min, options.query_ms_max) * 1000.0;
+        master_low = false;
+        hub_low = false;
+        spike_start = INFINITY;
+        spike_end = (options.spikes_per_ms > 0) ? 0.0 : INFINITY;
+        if (trace != nullptr)
+            traceLevels(0.0); // idle line is high
+    }
+
+    bool read(void)
+    {
+        now += loop_us;
+        advance();
+        return !lineLow(now);
+    }
+
+    void drive(const bool pull_low)
+    {
+        advance();
+        if (options.hotplug && hub_low && !pull_low && (next_step == Step::ATTEMPT) && (now + HOTPLUG_REACTION_US < next_time))
+            next_time = now + HOTPLUG_REACTION_US; // master is idle, the low came from a device -> query it now
+        hub_low = pull_low;
+        record(now);
+    }
+
+    // the hub returned from poll(), its error goes into the trace
+    void annotateError(const Error error)
+    {
+        if ((trace != nullptr) && (error != Error::NO_ERROR) && (uint8_t(error) < ERROR_COUNT))
+            trace->annotate(now, ERROR_NAMES[uint8_t(error)]);
+    }
+
+    bool finished(void) const { return (next_step == Step::DONE); }
+
+    double getNow(void) const { return now; }
+
+    const UnitResult &getResult(void) const { return result; }
+};
+
+static thread_local SimBus *sim_bus;
+
+bool simBusRead(void) { return sim_bus->read(); }
+
+void simBusDrive(const bool pull_low) { sim_bus->drive(pull_low); }
+
+static UnitResult simulateUnit(const Options &options, const uint32_t unit)
+{
+    WaveTrace trace;
+    bool tracing = false;
+    if (!options.trace_dir.empty())
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/unit-%06u", unsigned(unit));
+        tracing = trace.open(options.trace_dir + name, TRACE_SAMPLERATE, {"line", "master", "hub", "spike"});
+        if (!tracing)
+            fprintf(stderr, "can't write the trace %s%s\n", options.trace_dir.c_str(), name);
+    }
+
+    SimBus bus(options, unit, tracing ? &trace : nullptr);
+    sim_bus = &bus;
+
+    DS2502 device(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A);
+#if STATIC_DISPATCH_ENABLE
+    OneWireHubStatic<DS2502> hub(0, device); // like the firmware
+    hub.begin();
+#else
+    OneWireHub hub(0);
+    hub.attach(device);
+#endif
+
+    while (!bus.finished())
+    {
+        hub.poll(); // returns after every failed transaction and when the line stays idle
+        bus.annotateError(hub.getError());
+    }
+
+    sim_bus = nullptr;
+    if (tracing)
+    {
+        if ((bus.getResult().outcome == EcOutcome::IDENTIFIED) && !options.trace_all)
+            trace.discard();
+        else if (!trace.close(bus.getNow()))
+            fprintf(stderr, "can't write the trace of unit %u to %s\n", unsigned(unit), options.trace_dir.c_str());
+    }
+    return bus.getResult();
+}
+
+static double runFleet(const Options &options, const uint32_t threads, std::vector<UnitResult> &results)
+{
+    results.assign(options.units, UnitResult{});
+    std::atomic<uint32_t> next_unit{0};
+
+    const auto worker = [&]() {
+        while (true)
+        {
+            const uint32_t first = next_unit.fetch_add(CHUNK_UNITS);
+            if (first >= options.units)
+                return;
+            const uint32_t last = std::min(first + CHUNK_UNITS, options.units);
+            for (uint32_t unit = first; unit < last; ++unit)
+                results[unit] = simulateUnit(options, unit);
+        }
+    };
+
+    const auto time_start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (uint32_t index = 1; index < threads; ++index)
+        pool.emplace_back(worker);
+    worker();
+    for (std::thread &thread : pool)
+        thread.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+}
+
+static float percentile(const std::vector<float> &sorted, const double fraction)
+{
+    const size_t index = size_t(std::ceil(fraction * sorted.size()));
+    return sorted[(index == 0) ? 0 : index - 1];
+}
+
+static void printReport(const std::vector<UnitResult> &results, const uint32_t threads, const double seconds)
+{
+    uint32_t outcomes[4] = {0, 0, 0, 0};
+    uint32_t first_attempt = 0;
+    std::vector<float> latencies, latencies_up;
+    latencies.reserve(results.size());
+    latencies_up.reserve(results.size());
+    for (const UnitResult &result : results)
+    {
+        ++outcomes[uint8_t(result.outcome)];
+        if (result.outcome != EcOutcome::IDENTIFIED)
+            continue;
+        latencies.push_back(result.latency_ms);
+        latencies_up.push_back(result.latency_ms - result.boot_ms);
+        if (result.attempts_up == 1)
+            ++first_attempt;
+    }
+
+    const double units = double(results.size());
+    printf("units %u, threads %u, %.2f s (%.0f units/s)\n", unsigned(results.size()), unsigned(threads), seconds, units / seconds);
+    printf("identified %u (%.2f %%), at the first query after the hub is up %u (%.2f %%)\n", unsigned(outcomes[0]), 100.0 * outcomes[0] / units,
+           unsigned(first_attempt), 100.0 * first_attempt / units);
+    printf("failed: no presence %u, crc error %u, data error %u\n", unsigned(outcomes[1]), unsigned(outcomes[2]), unsigned(outcomes[3]));
+    if (latencies.empty())
+        return;
+    std::sort(latencies.begin(), latencies.end());
+    std::sort(latencies_up.begin(), latencies_up.end());
+    printf("latency ms from power-on: p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", percentile(latencies, 0.50), percentile(latencies, 0.90),
+           percentile(latencies, 0.99), latencies.back());
+    printf("latency ms from hub up:   p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", percentile(latencies_up, 0.50), percentile(latencies_up, 0.90),
+           percentile(latencies_up, 0.99), latencies_up.back());
+}
+
+static bool parseRange(const char *text, double &low, double &high)
+{
+    char *end = nullptr;
+    low = strtod(text, &end);
+    if (*end != ':')
+        return false;
+    high = strtod(end + 1, &end);
+    return (*end == 0) && (low >= 0) && (high >= low);
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int index = 1; index < argc; ++index)
+    {
+        const char *const flag = argv[index];
+        if (strcmp(flag, "-S") == 0)
+        {
+            options.scaling = true;
+            continue;
+        }
+        if (strcmp(flag, "-p") == 0)
+        {
+            options.hotplug = true;
+            continue;
+        }
+        if (strcmp(flag, "-W") == 0)
+        {
+            options.trace_all = true;
+            continue;
+        }
+        if (index + 1 >= argc)
+            return false;
+        const char *const value = argv[++index];
+
+        if (strcmp(flag, "-n") == 0)
+            options.units = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-j") == 0)
+            options.threads = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-s") == 0)
+            options.seed = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-o") == 0)
+            options.osc_pct = strtod(value, nullptr);
+        else if (strcmp(flag, "-m") == 0)
+            options.master_pct = strtod(value, nullptr);
+        else if (strcmp(flag, "-t") == 0)
+            options.jitter_us = strtod(value, nullptr);
+        else if (strcmp(flag, "-g") == 0)
+            options.spikes_per_ms = strtod(value, nullptr);
+        else if (strcmp(flag, "-b") == 0)
+        {
+            if (!parseRange(value, options.boot_ms_min, options.boot_ms_max))
+                return false;
+        }
+        else if (strcmp(flag, "-q") == 0)
+        {
+            if (!parseRange(value, options.query_ms_min, options.query_ms_max))
+                return false;
+        }
+        else if (strcmp(flag, "-r") == 0)
+            options.retry_ms = strtod(value, nullptr);
+        else if (strcmp(flag, "-a") == 0)
+            options.attempts = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-w") == 0)
+            options.trace_dir = value;
+        else
+            return false;
+    }
+    return (options.units != 0) && (options.attempts != 0) && (options.attempts < 256) && (options.osc_pct >= 0) && (options.osc_pct < 50) &&
+           (options.master_pct >= 0) && (options.master_pct < 50) && (options.jitter_us >= 0) && (options.spikes_per_ms >= 0) &&
+           (options.retry_ms > 0) && (!options.trace_all || !options.trace_dir.empty());
+}
+
+static bool sameResults(const std::vector<UnitResult> &results_A, const std::vector<UnitResult> &results_B)
+{
+    for (size_t index = 0; index < results_A.size(); ++index)
+    {
+        if ((results_A[index].outcome != results_B[index].outcome) || (results_A[index].attempts != results_B[index].attempts) ||
+            (results_A[index].attempts_up != results_B[index].attempts_up) ||
+            (results_A[index].latency_ms != results_B[index].latency_ms))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [-n units] [-j threads] [-s seed] [-o osc_%%] [-m master_%%] [-t jitter_us] [-g spikes_per_ms]\n"
+                        "       %*s [-b boot_ms_min:max] [-q query_ms_min:max] [-r retry_ms] [-a attempts] [-p] [-S] [-w trace_dir] [-W]\n",
+                argv[0], int(strlen(argv[0])), "");
+        return 2;
+    }
+
+    const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t threads = (options.threads == 0) ? cores : options.threads;
+    std::vector<UnitResult> results;
+
+    if (!options.scaling)
+    {
+        const double seconds = runFleet(options, threads, results);
+        printReport(results, threads, seconds);
+        return 0;
+    }
+
+    // same fleet for every thread count, the results have to match unit by unit
+    std::vector<uint32_t> counts;
+    for (uint32_t count = 1; count < threads; count *= 2)
+        counts.push_back(count);
+    counts.push_back(threads);
+
+    std::vector<UnitResult> reference;
+    double seconds_single = 0;
+    printf("threads,seconds,units_per_s,speedup\n");
+    for (const uint32_t count : counts)
+    {
+        const double seconds = runFleet(options, count, results);
+        if (count == 1)
+        {
+            seconds_single = seconds;
+            reference = results;
+        }
+        else if (!sameResults(results, reference))
+        {
+            fprintf(stderr, "results with %u threads differ from the single thread\n", unsigned(count));
+            return 1;
+        }
+        printf("%u,%.3f,%.0f,%.2f\n", unsigned(count), seconds, options.units / seconds, seconds_single / seconds);
+    }
+    printReport(reference, 1, seconds_single);
+    return 0;
+}
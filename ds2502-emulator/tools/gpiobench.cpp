@@ -0,0 +1,369 @@
+// slot response of the unmodified hub on a kernel gpio line: OneWireHub + DS2502 (built with ONEWIREHUB_LINUX_GPIO) poll a line of
+// gpio-sim through the character device, the master in this process plays the EC on the other side of the same line
+// - master drives the line with the pull of gpio-sim (sysfs "pull": pull-down = master low) and samples it there too ("value"),
+//   a line the hub holds as output low reads low, like the wired-and of the real bus
+// - master: the query of the EC (common/ecquery.h), reset, presence, 0xCC, 0xF0 0x08 0x00, then the crc and 3 bytes, AN126 timing with busy waits
+// - response: falling edge of the master to the first low the master sees of the hub (presence: from the release of the reset)
+//   a hub that answers while the master is still low shows up as the release time of the master, sysfs is slow too
+// - the hub reads the line once per wait-loop of the attiny25 (platform.h), a slower ioctl stretches its timing -> "late reads"
+// needs 2 cpus, hub and master both busy wait. SCHED_FIFO and locked memory if permitted (root)
+//
+// gpio-sim with one line, as root:
+//   modprobe gpio-sim && mkdir -p /sys/kernel/config/gpio-sim/onewire/bank0
+//   echo 1 > /sys/kernel/config/gpio-sim/onewire/bank0/num_lines && echo 1 > /sys/kernel/config/gpio-sim/onewire/live
+//   cat /sys/kernel/config/gpio-sim/onewire/bank0/chip_name -> chip for -c
+//
+// usage: gpiobench -c gpiochipN [-l line] [-n queries] [-i interval_ms] [-d distributions.csv]
+//   -d  every measured value as "measurement,us", the raw distributions behind the percentiles
+
+#include "../src/DS2502.h"
+#include "../src/OneWireHub.h"
+#include "../src/OneWireHubStatic.h"
+#include "common/ecquery.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+static_assert(!WATCHDOG_ENABLE, "the bench can't restart a hub, disable WATCHDOG_ENABLE");
+static_assert(!USI_ENGINE_ENABLE && !MULTIHUB_ENABLE, "the bench runs the wait-loop engine of OneWireHub");
+
+constexpr double PRESENCE_WINDOW_US{240}; // the master looks this long for a presence after the release
+constexpr double SLOT_LISTEN_US{60};      // the master watches a read slot this long for the low of the hub, to see late answers too
+constexpr double RESPONSE_BUDGET_US{MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US};
+
+struct Options
+{
+    std::string chip;
+    uint32_t line{0};
+    uint32_t queries{1000};
+    double interval_ms{10.0};
+    std::string distributions; // csv, empty -> none
+};
+
+static double nowUs(void)
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return double(now.tv_sec) * 1000000.0 + double(now.tv_nsec) / 1000.0;
+}
+
+static double waitUntil(const double time_us)
+{
+    double now = nowUs();
+    while (now < time_us)
+        now = nowUs();
+    return now;
+}
+
+// sysfs side of the gpio-sim line
+class SimLine
+{
+private:
+    int pull_fd{-1};
+    int value_fd{-1};
+
+public:
+    bool open(const Options &options)
+    {
+        const std::string path = "/sys/bus/gpio/devices/" + options.chip + "/sim_gpio" + std::to_string(options.line) + "/";
+        pull_fd = ::open((path + "pull").c_str(), O_WRONLY | O_CLOEXEC);
+        value_fd = ::open((path + "value").c_str(), O_RDONLY | O_CLOEXEC);
+        return (pull_fd >= 0) && (value_fd >= 0);
+    }
+
+    void drive(const bool low)
+    {
+        static const char pull_down[] = "pull-down", pull_up[] = "pull-up";
+        if (low)
+            (void)pwrite(pull_fd, pull_down, sizeof(pull_down) - 1, 0);
+        else
+            (void)pwrite(pull_fd, pull_up, sizeof(pull_up) - 1, 0);
+    }
+
+    bool high(void)
+    {
+        char value = '1';
+        (void)pread(value_fd, &value, 1, 0);
+        return (value != '0');
+    }
+};
+
+struct Measurements
+{
+    std::vector<double> presence_us;
+    std::vector<double> response_us;
+    std::vector<double> master_low_us; // low of the write-one and read slots, should be ~6us
+    uint32_t outcomes[EC_OUTCOME_COUNT]{};
+};
+
+class Master
+{
+private:
+    SimLine &line;
+    Measurements &measurements;
+
+    bool reset(void)
+    {
+        const double start = nowUs();
+        line.drive(true);
+        waitUntil(start + MASTER_TIME_RESET_US);
+        line.drive(false);
+        const double release = nowUs();
+
+        bool present = false;
+        double now = release;
+        while (now < release + PRESENCE_WINDOW_US)
+        {
+            if (!line.high())
+            {
+                present = true;
+                measurements.presence_us.push_back(nowUs() - release);
+                break;
+            }
+            now = nowUs();
+        }
+        while (present && !line.high() && (nowUs() < release + MASTER_TIME_RESET_US))
+            ;
+        waitUntil(release + MASTER_TIME_RESET_US);
+        return present;
+    }
+
+    void writeBit(const bool one)
+    {
+        const double start = nowUs();
+        line.drive(true);
+        waitUntil(start + (one ? MASTER_TIME_WRITE_ONE_US : MASTER_TIME_WRITE_ZERO_US));
+        line.drive(false);
+        if (one)
+            measurements.master_low_us.push_back(nowUs() - start);
+        waitUntil(start + (one ? MASTER_TIME_WRITE_ONE_US + MASTER_TIME_WRITE_ONE_REST_US : MASTER_TIME_WRITE_ZERO_US + MASTER_TIME_WRITE_ZERO_REST_US));
+    }
+
+    bool readBit(void)
+    {
+        const double start = nowUs();
+        line.drive(true);
+        waitUntil(start + MASTER_TIME_WRITE_ONE_US);
+        line.drive(false);
+        measurements.master_low_us.push_back(nowUs() - start);
+
+        const double sample = start + MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US;
+        bool seen_low = false, value = true, sampled = false;
+        double now = nowUs();
+        while (now < start + SLOT_LISTEN_US)
+        {
+            const bool high = line.high();
+            now = nowUs();
+            if (!high && !seen_low)
+            {
+                seen_low = true;
+                measurements.response_us.push_back(now - start);
+            }
+            if (!sampled && (now >= sample))
+            {
+                sampled = true;
+                value = high;
+            }
+            if (sampled && high)
+                break; // hub let go or never pulled
+        }
+        while (!line.high() && (nowUs() < start + 2 * SLOT_LISTEN_US))
+            ;
+        waitUntil(start + MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US + MASTER_TIME_READ_REST_US);
+        return value;
+    }
+
+public:
+    Master(SimLine &line, Measurements &measurements) : line(line), measurements(measurements){};
+
+    EcOutcome query(void)
+    {
+        uint8_t rx[EC_QUERY_RX_BYTES]{};
+
+        if (!reset())
+            return EcOutcome::NO_PRESENCE;
+        for (uint8_t slot = 0; slot < EC_QUERY_WRITE_SLOTS; ++slot)
+            writeBit(ecQueryWriteOne(slot));
+        for (uint8_t &value : rx)
+            for (uint8_t bit = 0; bit < 8; ++bit)
+                if (readBit())
+                    value |= uint8_t(1 << bit);
+        return ecQueryCheck(rx, memory);
+    }
+};
+
+static std::atomic<bool> hub_running{true};
+
+static void runHub(void)
+{
+    DS2502 device(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A);
+#if STATIC_DISPATCH_ENABLE
+    OneWireHubStatic<DS2502> hub(0, device);
+    hub.begin();
+#else
+    OneWireHub hub(0);
+    hub.attach(device);
+#endif
+
+    while (hub_running.load(std::memory_order_relaxed))
+        hub.poll(); // returns after every failed transaction and when the line stays idle
+}
+
+// real-time priority and a cpu of its own, silently skipped if not permitted
+static void makeRealtime(const int cpu)
+{
+    sched_param param{};
+    param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+    pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (cpu < 0)
+        return;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+}
+
+static double percentile(std::vector<double> &values, const double fraction)
+{
+    if (values.empty())
+        return 0;
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1, size_t(fraction * double(values.size())))];
+}
+
+static void printDistribution(const char *const name, std::vector<double> &values)
+{
+    if (values.empty())
+    {
+        printf("%-24s none\n", name);
+        return;
+    }
+    printf("%-24s p50 %6.1f, p90 %6.1f, p99 %6.1f, max %6.1f us (%zu)\n", name, percentile(values, 0.5), percentile(values, 0.9), percentile(values, 0.99), values.back(), values.size());
+}
+
+static bool writeDistributions(const std::string &path, const Measurements &measurements)
+{
+    FILE *const file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+    fprintf(file, "measurement,us\n");
+    for (const double value : measurements.presence_us)
+        fprintf(file, "presence,%.3f\n", value);
+    for (const double value : measurements.response_us)
+        fprintf(file, "response,%.3f\n", value);
+    for (const double value : measurements.master_low_us)
+        fprintf(file, "master_low,%.3f\n", value);
+    return (fclose(file) == 0);
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options)
+{
+    int option;
+    while ((option = getopt(argc, argv, "c:l:n:i:d:")) != -1)
+    {
+        switch (option)
+        {
+        case 'c':
+            options.chip = optarg;
+            break;
+        case 'l':
+            options.line = uint32_t(strtoul(optarg, nullptr, 10));
+            break;
+        case 'n':
+            options.queries = uint32_t(strtoul(optarg, nullptr, 10));
+            break;
+        case 'i':
+            options.interval_ms = strtod(optarg, nullptr);
+            break;
+        case 'd':
+            options.distributions = optarg;
+            break;
+        default:
+            return false;
+        }
+    }
+    return !options.chip.empty() && (options.queries > 0) && (options.interval_ms >= 0);
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s -c gpiochipN [-l line] [-n queries] [-i interval_ms] [-d distributions.csv]\n", argv[0]);
+        return 2;
+    }
+
+    SimLine line;
+    if (!line.open(options))
+    {
+        fprintf(stderr, "%s line %u: no sysfs of gpio-sim (%s), see the head of gpiobench.cpp\n", options.chip.c_str(), unsigned(options.line), strerror(errno));
+        return 1;
+    }
+    line.drive(false);
+    const std::string device = "/dev/" + options.chip;
+    if (!gpioLineOpen(device.c_str(), options.line))
+    {
+        fprintf(stderr, "%s line %u: %s\n", device.c_str(), unsigned(options.line), strerror(errno));
+        return 1;
+    }
+
+    const bool two_cpus = (std::thread::hardware_concurrency() >= 2);
+    if (!two_cpus)
+        fprintf(stderr, "only one cpu: hub and master busy wait on the same one, expect failures\n");
+    mlockall(MCL_CURRENT | MCL_FUTURE);
+
+    std::thread hub_thread([two_cpus]() {
+        makeRealtime(two_cpus ? 1 : -1);
+        runHub();
+    });
+    makeRealtime(two_cpus ? 0 : -1);
+    waitUntil(nowUs() + 100000); // hub is up and polling
+
+    Measurements measurements;
+    Master master(line, measurements);
+    const double time_start = nowUs();
+    for (uint32_t query = 0; query < options.queries; ++query)
+    {
+        ++measurements.outcomes[uint8_t(master.query())];
+        waitUntil(nowUs() + options.interval_ms * 1000.0);
+    }
+    const double time_run = (nowUs() - time_start) / 1000000.0;
+
+    hub_running = false;
+    hub_thread.join();
+
+    printf("queries %u on %s line %u, %.2f s\n", unsigned(options.queries), options.chip.c_str(), unsigned(options.line), time_run);
+    printf("identified %u (%.2f %%)\n", unsigned(measurements.outcomes[0]), 100.0 * measurements.outcomes[0] / options.queries);
+    printf("failed: no presence %u, crc error %u, data error %u\n", unsigned(measurements.outcomes[1]), unsigned(measurements.outcomes[2]), unsigned(measurements.outcomes[3]));
+    printDistribution("presence after release", measurements.presence_us);
+    printDistribution("response to slot start", measurements.response_us);
+    printDistribution("master low (6 us)", measurements.master_low_us);
+
+    const GpioLineStats stats = gpioLineStats();
+    if (stats.reads != 0)
+        printf("hub reads %" PRIu64 ", ioctl avg %.2f us, max %.1f us, late %" PRIu64 " (pace %.3f us per loop)\n", stats.reads, stats.read_ns / 1000.0 / stats.reads,
+               stats.read_ns_max / 1000.0, stats.late_reads, GPIO_LOOP_NS / 1000.0);
+    if (stats.drives != 0)
+        printf("hub drives %" PRIu64 ", ioctl avg %.2f us, max %.1f us\n", stats.drives, stats.drive_ns / 1000.0 / stats.drives, stats.drive_ns_max / 1000.0);
+
+    if (!options.distributions.empty() && !writeDistributions(options.distributions, measurements))
+        fprintf(stderr, "%s: %s\n", options.distributions.c_str(), strerror(errno));
+
+    const double response_p99 = percentile(measurements.response_us, 0.99);
+    printf("response p99 %.1f us of %.1f us budget (master samples at A + E): %s\n", response_p99, RESPONSE_BUDGET_US, (response_p99 <= RESPONSE_BUDGET_US) ? "ok" : "too slow");
+    return (measurements.outcomes[0] == options.queries) ? 0 : 1;
+}
@@ -0,0 +1,366 @@
+// the read commands of the memory devices against a model of their datasheets, without the bus
+// - a fake hub replaces send() and recv() of OneWireHub: the master's bytes come from a buffer, the answer goes into one,
+//   the master stops reading after a given number of bytes (send() returns true like on a reset)
+// - every command (READ MEMORY 0xF0, READ STATUS 0xAA, READ DATA / GENERATE CRC 0xC3 and one the parts don't know),
+//   every target address, with and without page redirection, the master stopping at the start, in the middle and at the end
+// - the model reads memory and status through the page map of the datasheet, crc8 / crc16 bit by bit
+// - prints the first difference of every part, exit code 1 if there is one
+//
+// usage: memcheck [-v]
+//   -v  prints the number of transactions per part
+
+#include "../src/DS2431.h"
+#include "../src/DS2501.h"
+#include "../src/DS2502.h"
+#include "../src/DS2505.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+constexpr size_t NO_LIMIT{0xFFFF};
+constexpr uint8_t COMMAND_UNKNOWN{0x11};
+
+// the bus of the fake hub, one transaction at a time
+static std::vector<uint8_t> bus_rx; // from the master: command and target address
+static size_t bus_rx_position;
+static std::vector<uint8_t> bus_tx; // answer of the device
+static size_t bus_tx_limit;         // bytes the master reads before it resets
+
+bool OneWireHub::recv(uint8_t address[], const uint8_t data_length)
+{
+    for (uint8_t index = 0; index < data_length; ++index)
+    {
+        if (bus_rx_position >= bus_rx.size())
+            return true;
+        address[index] = bus_rx[bus_rx_position++];
+    }
+    return false;
+}
+
+bool OneWireHub::recv(uint8_t address[], const uint8_t data_length, uint16_t &crc16)
+{
+    if (recv(address, data_length))
+        return true;
+    for (uint8_t index = 0; index < data_length; ++index)
+        crc16 = OneWireItem::crc16(address[index], crc16);
+    return false;
+}
+
+bool OneWireHub::send(const uint8_t address[], const uint8_t data_length)
+{
+    for (uint8_t index = 0; index < data_length; ++index)
+    {
+        if (bus_tx.size() >= bus_tx_limit)
+            return true;
+        bus_tx.push_back(address[index]);
+    }
+    return false;
+}
+
+bool OneWireHub::send(const uint8_t address[], const uint8_t data_length, uint16_t &crc16)
+{
+    for (uint8_t index = 0; index < data_length; ++index)
+    {
+        if (send(&address[index], 1))
+            return true;
+        crc16 = OneWireItem::crc16(address[index], crc16);
+    }
+    return false;
+}
+
+enum class Crc : uint8_t
+{
+    NONE,
+    CRC8,
+    CRC16 // inverted, lsb first
+};
+
+// a part like its datasheet describes it
+struct Part
+{
+    const char *name;
+    uint8_t page_count;
+    std::vector<std::pair<uint16_t, uint16_t>> status_ranges; // [first, end) of the status addresses with a byte behind them
+    uint16_t status_end;                                      // of the status address space
+    uint16_t redirect;                                        // status address of the redirection byte of page 0
+    Crc crc;
+    bool read_status;     // 0xAA
+    bool read_page_crc;   // 0xC3
+    bool status_in_memory; // READ MEMORY continues into the registers
+};
+
+static uint8_t crc8(uint8_t crc, uint8_t data)
+{
+    for (uint8_t bit = 0; bit < 8; ++bit, data >>= 1)
+        crc = ((crc ^ data) & 0x01) ? uint8_t((crc >> 1) ^ 0x8C) : uint8_t(crc >> 1);
+    return crc;
+}
+
+static uint16_t crc16(uint16_t crc, uint8_t data)
+{
+    for (uint8_t bit = 0; bit < 8; ++bit, data >>= 1)
+        crc = ((crc ^ data) & 0x01) ? uint16_t((crc >> 1) ^ 0xA001) : uint16_t(crc >> 1);
+    return crc;
+}
+
+class Model
+{
+    const Part &part;
+    const std::vector<uint8_t> &image;
+    std::vector<uint8_t> status; // by status address
+
+    uint16_t memSize() const { return uint16_t(part.page_count * 32); }
+
+    bool hasStatus(const uint16_t address) const
+    {
+        for (const auto &range : part.status_ranges)
+        {
+            if ((address >= range.first) && (address < range.second))
+                return true;
+        }
+        return false;
+    }
+
+    // a redirection byte holds the ones complement of the page that is read instead, 0xFF: none
+    uint8_t sourcePage(const uint8_t page) const
+    {
+        if (part.redirect == MEMORY_STATUS_NONE)
+            return page;
+        const uint8_t destin = uint8_t(~status[part.redirect + page]);
+        return ((destin == 0) || (destin >= part.page_count)) ? page : destin;
+    }
+
+    uint8_t memory(const uint16_t address) const
+    {
+        const uint16_t source = uint16_t(sourcePage(uint8_t(address >> 5)) * 32 + (address & 31));
+        return (source < image.size()) ? image[source] : uint8_t(0xFF);
+    }
+
+    uint8_t statusByte(const uint16_t address) const { return hasStatus(address) ? status[address] : uint8_t(0xFF); }
+
+    void appendCrc(std::vector<uint8_t> &answer, const std::vector<uint8_t> &data) const
+    {
+        if (part.crc == Crc::CRC8)
+        {
+            uint8_t crc = 0;
+            for (const auto byte : data)
+                crc = crc8(crc, byte);
+            answer.push_back(crc);
+        }
+        else if (part.crc == Crc::CRC16)
+        {
+            uint16_t crc = 0;
+            for (const auto byte : data)
+                crc = crc16(crc, byte);
+            answer.push_back(uint8_t(~crc));
+            answer.push_back(uint8_t(~crc >> 8));
+        }
+    }
+
+    void appendData(std::vector<uint8_t> &answer, const std::vector<uint8_t> &data) const
+    {
+        answer.insert(answer.end(), data.begin(), data.end());
+        appendCrc(answer, data);
+    }
+
+public:
+    Model(const Part &part, const std::vector<uint8_t> &image) : part(part), image(image), status(part.status_end, 0xFF){};
+
+    void setStatus(const uint16_t address, const uint8_t value) { status[address] = value; }
+
+    // everything the device sends after command and target address, if the master keeps reading
+    std::vector<uint8_t> answer(const uint8_t command, const uint8_t address_low, const uint8_t address_high) const
+    {
+        std::vector<uint8_t> answer;
+        const uint16_t address_end = (memSize() > part.status_end) ? memSize() : part.status_end;
+        if (address_high > ((address_end - 1) >> 8))
+            return answer;
+        const uint16_t address = uint16_t(address_low | (address_high << 8));
+        const std::vector<uint8_t> header{command, address_low, address_high};
+        std::vector<uint8_t> data;
+
+        switch (command)
+        {
+        case 0xF0:
+            appendCrc(answer, header);
+            for (uint16_t index = address; index < memSize(); ++index)
+                data.push_back(memory(index));
+            if (part.status_in_memory)
+            {
+                for (uint16_t index = (address > memSize()) ? address : memSize(); index < part.status_end; ++index)
+                    data.push_back(statusByte(index));
+            }
+            appendData(answer, data);
+            break;
+
+        case 0xAA:
+            if (!part.read_status)
+                break;
+            appendCrc(answer, header);
+            for (uint16_t index = address; index < part.status_end; ++index)
+                data.push_back(statusByte(index));
+            appendData(answer, data);
+            break;
+
+        case 0xC3:
+            if (!part.read_page_crc)
+                break;
+            appendCrc(answer, header);
+            for (uint16_t index = address; index < memSize(); ++index)
+            {
+                data.push_back(memory(index));
+                if ((index & 31) == 31)
+                {
+                    appendData(answer, data);
+                    data.clear();
+                }
+            }
+            break;
+        }
+        return answer;
+    }
+};
+
+static std::string hexBytes(const std::vector<uint8_t> &bytes)
+{
+    std::string text;
+    char byte_text[4];
+    for (const auto byte : bytes)
+    {
+        snprintf(byte_text, sizeof(byte_text), " %02x", byte);
+        text += byte_text;
+    }
+    return text;
+}
+
+// one scenario of a part: device and model with the same image and status, every command, address and limit
+template <typename Device>
+static bool checkScenario(Device &device, const Model &model, const char *const part_name, const char *const scenario, uint32_t &transactions)
+{
+    alignas(8) static uint8_t hub_storage[sizeof(OneWireHub)]; // never constructed, the fake send() and recv() don't touch it
+    OneWireHub *const hub = reinterpret_cast<OneWireHub *>(hub_storage);
+    const uint16_t address_end = (Device::ADDRESS_END > 0xFF) ? uint16_t(Device::ADDRESS_END) : uint16_t(0x100);
+
+    for (const uint8_t command : {uint8_t(0xF0), uint8_t(0xAA), uint8_t(0xC3), COMMAND_UNKNOWN})
+    {
+        for (uint32_t address = 0; address <= address_end; ++address) // one upper byte past the part
+        {
+            const uint8_t address_low = uint8_t(address), address_high = uint8_t(address >> 8);
+            const std::vector<uint8_t> expected = model.answer(command, address_low, address_high);
+            const size_t length = expected.size();
+            for (const size_t limit : {size_t(0), size_t(1), size_t(2), length / 2, (length > 0) ? length - 1 : 0, length, NO_LIMIT})
+            {
+                for (const size_t received : {size_t(1), size_t(3)}) // the master resets during the target address or not
+                {
+                    bus_rx = {command, address_low, address_high};
+                    bus_rx.resize(received);
+                    bus_rx_position = 0;
+                    bus_tx.clear();
+                    bus_tx_limit = limit;
+                    device.duty(hub);
+                    ++transactions;
+
+                    const std::vector<uint8_t> prefix(expected.begin(), expected.begin() + ((received < 3) ? 0 : (limit < length) ? limit : length));
+                    if (bus_tx != prefix)
+                    {
+                        printf("%s, %s: command %02x, address %04x, %zu bytes received, limit %zu\n  expected%s\n  sent    %s\n", part_name, scenario,
+                               command, address, received, limit, hexBytes(prefix).c_str(), hexBytes(bus_tx).c_str());
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// the image is shorter than the memory, the rest reads as unprogrammed
+static std::vector<uint8_t> testImage(const uint16_t mem_size)
+{
+    std::vector<uint8_t> image(mem_size - 5);
+    for (size_t index = 0; index < image.size(); ++index)
+        image[index] = uint8_t(index * 7 + 3);
+    return image;
+}
+
+// redirections of the datasheet: none, page 0 to the last page, the middle page to page 1 with protected and used pages
+template <typename Device>
+static bool checkPart(const Part &part, uint32_t &transactions)
+{
+    const std::vector<uint8_t> image = testImage(Device::MEM_SIZE);
+    Device device(Device::family_code, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, image.data(), typename Device::address_t(image.size()));
+    Model model(part, image);
+    device.clearStatus();
+    for (const auto &range : part.status_ranges)
+    {
+        for (uint16_t address = range.first; address < range.second; ++address)
+            model.setStatus(address, device.readStatus(address));
+    }
+
+    if (!checkScenario(device, model, part.name, "cleared status", transactions))
+        return false;
+
+    if (part.redirect == MEMORY_STATUS_NONE)
+    {
+        // registers of the DS2431: page protection, copy protection
+        for (const uint16_t address : {uint16_t(0x80), uint16_t(0x83), uint16_t(0x84)})
+            model.setStatus(address, device.writeStatus(address, 0x55));
+        return checkScenario(device, model, part.name, "registers written", transactions);
+    }
+
+    // the status bytes as the device holds them, the model only resolves the redirection
+    const auto redirect = [&](const uint8_t page_source, const uint8_t page_destin) {
+        device.setPageRedirection(page_source, page_destin);
+        model.setStatus(uint16_t(part.redirect + page_source), device.readStatus(uint16_t(part.redirect + page_source)));
+    };
+
+    const uint8_t last_page = uint8_t(part.page_count - 1);
+    redirect(0, last_page);
+    if (!checkScenario(device, model, part.name, "page 0 redirected", transactions))
+        return false;
+
+    redirect(uint8_t(part.page_count / 2), 1);
+    model.setStatus(0, device.writeStatus(0, 0xF5));
+    return checkScenario(device, model, part.name, "pages redirected to each other", transactions);
+}
+
+int main(const int argc, char *const argv[])
+{
+    bool verbose = false;
+    for (int index = 1; index < argc; ++index)
+    {
+        if (strcmp(argv[index], "-v") == 0)
+        {
+            verbose = true;
+        }
+        else
+        {
+            fprintf(stderr, "usage: memcheck [-v]\n");
+            return 2;
+        }
+    }
+
+    // DS2502 datasheet: 8 status bytes, redirection of page n at status address 1 + n. DS2505: protection 0x000,
+    // used pages 0x040, redirection 0x100. DS2431: the 8 registers follow the memory at 0x80
+    const Part DS2501_PART{"DS2501", 2, {{0x000, 0x008}}, 0x008, 0x001, Crc::CRC8, true, true, false};
+    const Part DS2502_PART{"DS2502", 4, {{0x000, 0x008}}, 0x008, 0x001, Crc::CRC8, true, true, false};
+    const Part DS2505_PART{"DS2505", 64, {{0x000, 0x008}, {0x020, 0x028}, {0x040, 0x048}, {0x100, 0x140}}, 0x140, 0x100, Crc::CRC16, true, false, false};
+    const Part DS2431_PART{"DS2431", 4, {{0x080, 0x088}}, 0x088, MEMORY_STATUS_NONE, Crc::NONE, false, false, true};
+
+    uint32_t transactions[4]{};
+    const bool passed[4]{checkPart<DS2501>(DS2501_PART, transactions[0]), checkPart<DS2502>(DS2502_PART, transactions[1]),
+                         checkPart<DS2505>(DS2505_PART, transactions[2]), checkPart<DS2431>(DS2431_PART, transactions[3])};
+    const char *const names[4]{DS2501_PART.name, DS2502_PART.name, DS2505_PART.name, DS2431_PART.name};
+
+    bool failed = false;
+    for (uint8_t index = 0; index < 4; ++index)
+    {
+        if (verbose || !passed[index])
+            printf("%s: %s after %u transactions\n", names[index], passed[index] ? "ok" : "FAILED", transactions[index]);
+        failed |= !passed[index];
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,464 @@
+// decodes long field captures (sigrok .sr) of a DS2502 on the line into a log of its transactions
+// - the chunks are streamed straight out of the mapped session by a pool of threads (-j), every thread inflates a piece of
+//   SIGROK_BUFFER_SIZE samples and keeps only the level changes of the probe in it -> memory stays at the changes of the chunks in
+//   flight, the changes go in capture order through OneWireDecoder (common/onewire.h)
+// - a worker claims a chunk at most CHUNK_WINDOW_PER_THREAD chunks per thread ahead of the one being decoded
+// - the crcs of DS2502 read as the device sends them: READ ROM, the command crc of READ MEMORY / STATUS / DATA, the crc at the end of
+//   the memory or status and after every page of READ DATA -> only the crcs the master read to the end are checked
+// - log (csv): time_s,presence,rom_command,rom,function,address,data,crc. data are the bytes read after the address, crcs included,
+//   crc is ok, error or - (none read)
+//
+// usage: owdecode [-p probe] [-j threads] [-o log.csv] capture.sr
+//   a summary (samples, throughput, transactions, crc errors) goes to stderr, the log to stdout without -o
+
+#include "../src/DS2502.h"
+#include "../src/OneWireItem.h"
+#include "common/onewire.h"
+#include "common/sigrok.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr uint32_t CHUNK_WINDOW_PER_THREAD{2}; // chunks in flight per thread, each holds its changes until it is decoded
+
+constexpr uint16_t MEMORY_END{DS2502::MEM_SIZE};
+constexpr uint16_t MEMORY_PAGE_SIZE{DS2502::PAGE_SIZE};
+constexpr uint16_t STATUS_END{DS2502Layout::STATUS_END};
+
+struct Options
+{
+    std::string probe_name; // empty -> first probe
+    uint32_t threads{0};    // 0 -> all cores
+    std::string log_path;   // empty -> stdout
+    std::string capture;
+};
+
+// level changes of the probe in one chunk
+struct ChunkEdges
+{
+    bool done{false};
+    bool good{false};
+    bool first_level{true};        // of the first sample of the chunk
+    std::vector<uint64_t> changes; // samples of the capture where the level flips, starting from first_level
+};
+
+// the memcpy templates of platform.h keep gcc from inlining memcpy -> the builtin, one load
+static uint64_t loadWord(const uint8_t *const data)
+{
+    uint64_t word;
+    __builtin_memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+// the samples of one probe -> its level changes from level_io on. with unitsize 1 a run of one level is skipped 32 samples at once
+static void findChanges(const uint8_t *const data, const size_t count, const size_t unitsize, const size_t byte_index, const uint8_t mask,
+                        const uint64_t first_sample, bool &level_io, std::vector<uint64_t> &changes)
+{
+    bool level = level_io;
+    size_t sample = 0;
+    if (unitsize == 1)
+    {
+        const uint64_t mask_wide = uint64_t(mask) * 0x0101010101010101ull;
+        while (sample + 8 <= count)
+        {
+            const uint64_t same = level ? mask_wide : 0;
+            if ((sample + 32 <= count) && ((((loadWord(data + sample) ^ same) | (loadWord(data + sample + 8) ^ same) |
+                                             (loadWord(data + sample + 16) ^ same) | (loadWord(data + sample + 24) ^ same)) &
+                                            mask_wide) == 0))
+            {
+                sample += 32;
+                continue;
+            }
+            // the first byte in a word of 8 samples that differs from the level is the next change
+            const uint64_t differ = (loadWord(data + sample) ^ same) & mask_wide;
+            if (differ == 0)
+            {
+                sample += 8;
+                continue;
+            }
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            sample += size_t(__builtin_ctzll(differ) / 8);
+#else
+            sample += size_t(__builtin_clzll(differ) / 8);
+#endif
+            level = !level;
+            changes.push_back(first_sample + sample);
+            ++sample;
+        }
+    }
+    for (; sample < count; ++sample)
+    {
+        if (((data[sample * unitsize + byte_index] & mask) != 0) != level)
+        {
+            level = !level;
+            changes.push_back(first_sample + sample);
+        }
+    }
+    level_io = level;
+}
+
+struct Summary
+{
+    uint64_t transactions{0};
+    uint64_t no_presence{0}; // resets without a presence pulse
+    uint64_t crcs{0};
+    uint64_t crc_errors{0};
+    uint64_t line_downs{0};
+};
+
+// assembles the bytes of a transaction (reset to reset) and writes its line
+class LogListener : public OneWireListener
+{
+private:
+    FILE *const log;
+    Summary &summary;
+
+    bool open{false};
+    double start_us{0};
+    bool has_presence{false};
+    bool has_rom_command{false};
+    uint8_t rom_command{0};
+    std::vector<uint8_t> rom;
+    bool has_function{false};
+    uint8_t function{0};
+    std::vector<uint8_t> address;
+    std::vector<uint8_t> data;
+
+    // crc8 of the bytes read from offset up to length, compared with the byte after them. false if the master stopped before
+    bool checkCrc(const size_t offset, const size_t length, bool &good) const
+    {
+        if (offset + length >= data.size())
+            return false;
+        good = (OneWireItem::crc8(&data[offset], uint8_t(length)) == data[offset + length]);
+        return true;
+    }
+
+    // -1 none read, 0 error, 1 ok
+    int verify(void) const
+    {
+        int result = -1;
+        const auto count = [&result](const bool good) { result = ((result != 0) && good) ? 1 : 0; };
+
+        if ((rom.size() == 8) && ((rom_command == 0x33) || (rom_command == 0x55)))
+            count(OneWireItem::crc8(rom.data(), 7) == rom[7]);
+
+        if (!has_function || (address.size() != 2) || data.empty())
+            return result;
+        if ((function != 0xF0) && (function != 0xAA) && (function != 0xC3))
+            return result;
+        const uint8_t command[3]{function, address[0], address[1]};
+        count(OneWireItem::crc8(command, 3) == data[0]);
+
+        // the data crc starts again after the command crc, READ DATA once per page
+        uint16_t position = uint16_t(address[0] | (address[1] << 8));
+        const uint16_t end = (function == 0xAA) ? STATUS_END : MEMORY_END;
+        size_t offset = 1;
+        bool good = false;
+        if (position >= end)
+            return result;
+        if (function != 0xC3)
+        {
+            if (checkCrc(offset, end - position, good))
+                count(good);
+            return result;
+        }
+        while (position < end)
+        {
+            const uint16_t page_end = uint16_t((position | (MEMORY_PAGE_SIZE - 1)) + 1);
+            if (!checkCrc(offset, page_end - position, good))
+                break;
+            count(good);
+            offset += page_end - position + 1u;
+            position = page_end;
+        }
+        return result;
+    }
+
+    void close(void)
+    {
+        if (!open)
+            return;
+        open = false;
+        ++summary.transactions;
+        if (!has_presence)
+            ++summary.no_presence;
+
+        const int crc = verify();
+        if (crc >= 0)
+            ++summary.crcs;
+        if (crc == 0)
+            ++summary.crc_errors;
+
+        fprintf(log, "%.6f,%d,", start_us / 1e6, has_presence ? 1 : 0);
+        if (has_rom_command)
+            fprintf(log, "%02x", unsigned(rom_command));
+        fputc(',', log);
+        for (const uint8_t value : rom)
+            fprintf(log, "%02x", unsigned(value));
+        fputc(',', log);
+        if (has_function)
+            fprintf(log, "%02x", unsigned(function));
+        fputc(',', log);
+        if (address.size() == 2)
+            fprintf(log, "%04x", unsigned(address[0] | (address[1] << 8)));
+        fputc(',', log);
+        for (const uint8_t value : data)
+            fprintf(log, "%02x", unsigned(value));
+        fprintf(log, ",%s\n", (crc < 0) ? "-" : (crc == 0) ? "error" : "ok");
+    }
+
+public:
+    LogListener(FILE *const log, Summary &summary) : log(log), summary(summary){};
+
+    void lineDown(const double, const double) override
+    {
+        close();
+        ++summary.line_downs;
+    }
+
+    void reset(const double start, const double) override
+    {
+        close();
+        open = true;
+        start_us = start;
+        has_presence = false;
+        has_rom_command = false;
+        rom.clear();
+        has_function = false;
+        address.clear();
+        data.clear();
+    }
+
+    void presence(const double, const double) override { has_presence = true; }
+
+    void byte(const OneWirePhase phase, const uint8_t value) override
+    {
+        switch (phase)
+        {
+        case OneWirePhase::ROM_COMMAND:
+            has_rom_command = true;
+            rom_command = value;
+            break;
+        case OneWirePhase::ROM_WRITE:
+        case OneWirePhase::ROM_READ:
+            rom.push_back(value);
+            break;
+        case OneWirePhase::FUNCTION:
+            has_function = true;
+            function = value;
+            break;
+        case OneWirePhase::ADDRESS:
+            address.push_back(value);
+            break;
+        case OneWirePhase::READ:
+            data.push_back(value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void finish(void) { close(); }
+};
+
+static bool parseOptions(const int argc, char *argv[], Options &options)
+{
+    for (int index = 1; index < argc; ++index)
+    {
+        const char *const flag = argv[index];
+        if (flag[0] != '-')
+        {
+            if (!options.capture.empty())
+                return false;
+            options.capture = flag;
+            continue;
+        }
+        if (index + 1 >= argc)
+            return false;
+        const char *const value = argv[++index];
+
+        if (strcmp(flag, "-p") == 0)
+            options.probe_name = value;
+        else if (strcmp(flag, "-j") == 0)
+            options.threads = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-o") == 0)
+            options.log_path = value;
+        else
+            return false;
+    }
+    return !options.capture.empty();
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [-p probe] [-j threads] [-o log.csv] capture.sr\n", argv[0]);
+        return 2;
+    }
+
+    SigrokReader reader;
+    if (!reader.open(options.capture))
+    {
+        fprintf(stderr, "%s: no sigrok session\n", options.capture.c_str());
+        return 2;
+    }
+    const int probe = options.probe_name.empty() ? 0 : reader.findProbe(options.probe_name);
+    if (probe < 0)
+    {
+        fprintf(stderr, "%s: no probe %s\n", options.capture.c_str(), options.probe_name.c_str());
+        return 2;
+    }
+    FILE *const log = options.log_path.empty() ? stdout : fopen(options.log_path.c_str(), "w");
+    if (log == nullptr)
+    {
+        fprintf(stderr, "can't write %s\n", options.log_path.c_str());
+        return 2;
+    }
+
+    // first sample of every chunk from the central directory, nothing is inflated for it
+    const uint32_t chunk_count = reader.getChunkCount();
+    std::vector<uint64_t> chunk_start(chunk_count + 1, 0);
+    for (uint32_t chunk = 0; chunk < chunk_count; ++chunk)
+        chunk_start[chunk + 1] = chunk_start[chunk] + reader.getChunkSamples(chunk);
+
+    const uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t threads = std::min((options.threads == 0) ? cores : options.threads, chunk_count);
+    const uint32_t window = threads * CHUNK_WINDOW_PER_THREAD;
+    const size_t unitsize = reader.getUnitSize();
+    const size_t byte_index = size_t(probe) / 8;
+    const uint8_t mask = uint8_t(1u << (probe % 8));
+
+    std::mutex mutex;
+    std::condition_variable claimable; // the decoder moved on
+    std::condition_variable finished;  // a chunk is done
+    std::deque<ChunkEdges> pending;    // chunks from decoded on, front is the next to decode
+    uint32_t decoded = 0;
+    uint32_t next_chunk = 0;
+    bool stop = false;
+
+    const auto worker = [&]() {
+        std::vector<uint8_t> buffer;
+        ChunkEdges edges;
+        while (true)
+        {
+            uint32_t chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                claimable.wait(lock, [&]() { return stop || (next_chunk >= chunk_count) || (next_chunk < decoded + window); });
+                if (stop || (next_chunk >= chunk_count))
+                    return;
+                chunk = next_chunk++;
+            }
+
+            // every piece is scanned right after it was inflated, while it is still in the cache
+            edges.changes.clear();
+            uint64_t sample = chunk_start[chunk];
+            bool level = true;
+            edges.good = reader.readChunk(chunk, buffer, [&](const uint8_t *const samples, const size_t count) {
+                if (sample == chunk_start[chunk])
+                {
+                    level = ((samples[byte_index] & mask) != 0);
+                    edges.first_level = level;
+                }
+                findChanges(samples, count, unitsize, byte_index, mask, sample, level, edges.changes);
+                sample += count;
+            });
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                ChunkEdges &slot = pending[chunk - decoded];
+                slot.changes.swap(edges.changes);
+                slot.first_level = edges.first_level;
+                slot.good = edges.good;
+                slot.done = true;
+            }
+            finished.notify_all();
+        }
+    };
+
+    Summary summary;
+    LogListener listener(log, summary);
+    OneWireDecoder decoder(listener, reader.getSamplerate());
+    fprintf(log, "time_s,presence,rom_command,rom,function,address,data,crc\n");
+
+    const auto time_start = std::chrono::steady_clock::now();
+    pending.resize(std::min(window, chunk_count));
+    std::vector<std::thread> pool;
+    for (uint32_t index = 0; index < threads; ++index)
+        pool.emplace_back(worker);
+
+    // the line may already be low when the capture starts and still be low at its end, both lows are cut -> not decoded
+    bool level = true;
+    bool cut = true;
+    uint64_t fall = 0;
+    bool good = true;
+    uint32_t chunks_decoded = 0;
+    std::vector<uint64_t> changes;
+    for (uint32_t chunk = 0; chunk < chunk_count; ++chunk)
+    {
+        bool first_level;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            finished.wait(lock, [&]() { return pending.front().done; });
+            good = pending.front().good;
+            changes.swap(pending.front().changes);
+            first_level = pending.front().first_level;
+            pending.pop_front();
+            ++decoded;
+            if (decoded + pending.size() < chunk_count)
+                pending.emplace_back();
+            stop = !good;
+        }
+        claimable.notify_all();
+        if (!good)
+        {
+            fprintf(stderr, "%s: chunk %u is broken\n", options.capture.c_str(), unsigned(chunk + 1));
+            break;
+        }
+
+        if (chunk == 0)
+            level = first_level;
+        else if (first_level != level)
+            changes.insert(changes.begin(), chunk_start[chunk]);
+        for (const uint64_t sample : changes)
+        {
+            level = !level;
+            if (!level)
+            {
+                fall = sample;
+                cut = false;
+            }
+            else if (!cut)
+                decoder.low(fall, sample);
+        }
+        ++chunks_decoded;
+    }
+    for (std::thread &thread : pool)
+        thread.join();
+    decoder.finish();
+    listener.finish();
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+
+    const bool written = (log == stdout) ? (fflush(log) == 0) : (fclose(log) == 0);
+    if (!written)
+        fprintf(stderr, "can't write %s\n", options.log_path.c_str());
+
+    const uint64_t samples = chunk_start[chunks_decoded];
+    fprintf(stderr, "%s: %llu samples (%.1f s of the line), %u chunks, %u threads, %.3f s -> %.1f M samples/s\n", options.capture.c_str(),
+            (unsigned long long)samples, double(samples) / double(reader.getSamplerate()), unsigned(chunks_decoded), unsigned(threads), seconds,
+            double(samples) / seconds / 1e6);
+    fprintf(stderr, "  %llu transactions, %llu without presence, %llu with crcs, %llu crc errors, line down %llu times\n",
+            (unsigned long long)summary.transactions, (unsigned long long)summary.no_presence, (unsigned long long)summary.crcs,
+            (unsigned long long)summary.crc_errors, (unsigned long long)summary.line_downs);
+    return (good && written) ? ((summary.crc_errors == 0) ? 0 : 1) : 2;
+}
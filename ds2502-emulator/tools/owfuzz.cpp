@@ -0,0 +1,744 @@
+// latency-guided fuzzer of the protocol state machine: OneWireHub + DS2502 of the simulator (ONEWIREHUB_HOST_SIM) against master
+// scripts (common/masterscript.h) that it mutates: command bytes, addresses, bit counts, reset lows and placement, slot timing
+// - the firmware objects are built with -fsanitize-coverage=trace-pc, every basic block calls back into this tool: edges of the
+//   run for the coverage, and the blocks the hub runs between two looks at the line. work costs no virtual time in the simulator,
+//   so this blind gap is counted in blocks, avrbench replays the seeds for the cycles
+// - per run: longest gap and the op of the master it fell into, every Error poll() returned with its error path (virtual time
+//   from the last edge of the master to the return of poll(), the idle WAIT_RESET_TIMEOUT aside) and a hub that never returns
+// - a mutant that reaches new edges (or hit counts, bucketed like afl) joins the corpus. the longest gap, the longest path per
+//   Error and a stuck hub are kept, minimised at the end (ops dropped, idles and resets shortened while the value holds) and
+//   written to the output directory (created if needed) as gap.seed, error-<name>.seed and stuck.seed
+// - one thread, deterministic: same seed, inputs and build -> same corpus and seeds. -n 0 only replays the inputs
+//
+// usage: owfuzz [-n runs] [-s seed] [-i seed_dir] [-o seed_dir] [-v]
+
+#include "../src/DS2502.h"
+#include "../src/OneWireHub.h"
+#include "../src/OneWireHubStatic.h"
+#include "common/errors.h"
+#include "common/files.h"
+#include "common/masterscript.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+static_assert(!WATCHDOG_ENABLE, "the simulator can't restart a hub, disable WATCHDOG_ENABLE");
+static_assert(!USI_ENGINE_ENABLE && !MULTIHUB_ENABLE, "the simulator runs the wait-loop engine of OneWireHub");
+
+constexpr uint8_t EDGE_MAP_BITS{16};
+constexpr uint32_t EDGE_MAP_SIZE{1u << EDGE_MAP_BITS};
+constexpr double SCRIPT_START_US{100};       // the hub polls from 0
+constexpr double SCRIPT_US_LIMIT{200000};    // mutants that run longer are dropped
+constexpr double STUCK_US{50000};            // after the end of the script, the line is idle -> poll() has to return long before
+constexpr double LOOP_US{double(VALUE_IPL) / microsecondsToClockCycles(1)}; // a path only counts as longer by more than this,
+                                                                           // the phase of the wait-loop against the master is no new path
+constexpr size_t OPS_LIMIT{64};
+constexpr uint32_t PROGRESS_RUNS{10000};
+
+// rom and device commands of the DS2502 and the ones next to them, the rest of the byte values comes from random
+static const uint8_t COMMANDS[] = {0x33, 0x55, 0xCC, 0xF0, 0xEC, 0x3C, 0x69, 0xA5, 0xAA, 0xC3, 0x0F, 0x5A, 0x00, 0x08, 0x7F, 0x80, 0xFF};
+
+struct Options
+{
+    uint32_t runs{50000};
+    uint32_t seed{1};
+    std::string input_dir;
+    std::string output_dir;
+    bool verbose{false};
+};
+
+using Ops = std::vector<MasterOp>;
+
+struct RunResult
+{
+    uint64_t gap_blocks;
+    uint16_t gap_op;                  // op of the master during the gap
+    double error_us[ERROR_COUNT];     // < 0: not returned
+    bool stuck;
+    bool new_coverage;
+};
+
+///////////////////////////////////////////// coverage /////////////////////////////////////////////
+
+static uint8_t edge_hits[EDGE_MAP_SIZE];
+static uint8_t edge_seen[EDGE_MAP_SIZE]; // hit-count buckets reached by any run
+static uint32_t edge_previous;
+static uint64_t block_count;
+
+// called by every basic block of the firmware objects. the pc is taken relative to this function, a pie lands anywhere
+extern "C" void __sanitizer_cov_trace_pc(void)
+{
+    const uintptr_t pc = uintptr_t(__builtin_return_address(0)) - uintptr_t(&__sanitizer_cov_trace_pc);
+    const uint32_t location = uint32_t((pc ^ (pc >> 17)) * 0x9E3779B1u) >> (32 - EDGE_MAP_BITS);
+    uint8_t &hits = edge_hits[location ^ edge_previous];
+    if (hits != 0xFF)
+        ++hits;
+    edge_previous = location >> 1; // a -> b and b -> a are different edges
+    ++block_count;
+}
+
+static uint8_t hitBucket(const uint8_t hits)
+{
+    if (hits < 4)
+        return uint8_t(1 << (hits - 1)); // 1, 2, 3
+    if (hits < 8)
+        return 0x08;
+    if (hits < 16)
+        return 0x10;
+    if (hits < 32)
+        return 0x20;
+    return (hits < 128) ? uint8_t(0x40) : uint8_t(0x80);
+}
+
+static bool mergeCoverage(void)
+{
+    bool fresh = false;
+    for (uint32_t index = 0; index < EDGE_MAP_SIZE; ++index)
+    {
+        if (edge_hits[index] == 0)
+            continue;
+        const uint8_t bucket = hitBucket(edge_hits[index]);
+        if ((edge_seen[index] & bucket) == 0)
+        {
+            edge_seen[index] |= bucket;
+            fresh = true;
+        }
+    }
+    return fresh;
+}
+
+static uint32_t edgeCount(void)
+{
+    return uint32_t(std::count_if(edge_seen, edge_seen + EDGE_MAP_SIZE, [](const uint8_t seen) { return seen != 0; }));
+}
+
+///////////////////////////////////////////// master /////////////////////////////////////////////
+
+struct Edge
+{
+    double time;
+    bool low;
+    uint16_t op;
+};
+
+// the script as line changes of the master in us, false if it is too long for a run
+static bool expand(const Ops &ops, std::vector<Edge> &edges, double &end_us)
+{
+    edges.clear();
+    double time = SCRIPT_START_US;
+    double scale = 1.0;
+    for (uint16_t index = 0; index < ops.size(); ++index)
+    {
+        const MasterOp &op = ops[index];
+        switch (op.kind)
+        {
+        case MasterOp::RESET:
+            edges.push_back({time, true, index});
+            edges.push_back({time + op.value, false, index});
+            time += op.value + (MASTER_TIME_PRESENCE_SAMPLE_US + MASTER_TIME_RESET_REST_US) * scale;
+            break;
+        case MasterOp::WRITE:
+            for (uint8_t bit = 0; bit < op.bits; ++bit)
+            {
+                const bool one = ((op.value >> bit) & 1) != 0;
+                const double low = (one ? MASTER_TIME_WRITE_ONE_US : MASTER_TIME_WRITE_ZERO_US) * scale;
+                edges.push_back({time, true, index});
+                edges.push_back({time + low, false, index});
+                time += low + (one ? MASTER_TIME_WRITE_ONE_REST_US : MASTER_TIME_WRITE_ZERO_REST_US) * scale;
+            }
+            break;
+        case MasterOp::READ:
+            for (uint32_t bit = 0; bit < op.value; ++bit)
+            {
+                edges.push_back({time, true, index});
+                edges.push_back({time + MASTER_TIME_WRITE_ONE_US * scale, false, index});
+                time += (MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US + MASTER_TIME_READ_REST_US) * scale;
+            }
+            break;
+        case MasterOp::IDLE:
+            time += op.value;
+            break;
+        case MasterOp::SCALE:
+            scale = op.value / 100.0;
+            break;
+        }
+        if (time > SCRIPT_US_LIMIT)
+            return false;
+    }
+    end_us = time;
+    return true;
+}
+
+struct HubStuck
+{
+};
+
+// line of one run: the master follows its edges, advanced to the virtual time of the hub whenever it looks at the line
+class FuzzBus
+{
+private:
+    const std::vector<Edge> &edges;
+    const double end_us;
+    size_t next{0};
+    double now{0};
+    bool master_low{false};
+    bool hub_low{false};
+    double last_edge_us{0};
+    uint16_t op{0};
+
+    uint64_t block_mark{0};
+    uint64_t gap_blocks{0};
+    uint16_t gap_op{0};
+
+    void advance(void)
+    {
+        while ((next < edges.size()) && (edges[next].time <= now))
+        {
+            master_low = edges[next].low;
+            last_edge_us = edges[next].time;
+            op = edges[next].op;
+            ++next;
+        }
+        if (now > end_us + STUCK_US)
+            throw HubStuck();
+    }
+
+    // the hub looks at the line or drives it, the blocks since the last time it did were a gap
+    void access(void)
+    {
+        const uint64_t gap = block_count - block_mark;
+        block_mark = block_count;
+        if (gap > gap_blocks)
+        {
+            gap_blocks = gap;
+            gap_op = op;
+        }
+    }
+
+public:
+    FuzzBus(const std::vector<Edge> &edges, const double end_us)
+        : edges(edges), end_us(end_us), block_mark(block_count){};
+
+    bool read(void)
+    {
+        access();
+        now += LOOP_US;
+        advance();
+        return !(master_low || hub_low);
+    }
+
+    void drive(const bool pull_low)
+    {
+        access();
+        advance();
+        hub_low = pull_low;
+    }
+
+    bool finished(void) const { return (now >= end_us); }
+
+    double errorPath(void) const { return now - last_edge_us; }
+
+    uint64_t gapBlocks(void) const { return gap_blocks; }
+
+    uint16_t gapOp(void) const { return gap_op; }
+};
+
+static FuzzBus *fuzz_bus;
+
+bool simBusRead(void) { return fuzz_bus->read(); }
+
+void simBusDrive(const bool pull_low) { fuzz_bus->drive(pull_low); }
+
+// false if the script does not fit in a run
+static bool execute(const Ops &ops, RunResult &result)
+{
+    std::vector<Edge> edges;
+    double end_us = 0;
+    if (ops.empty() || (ops.size() > OPS_LIMIT) || !expand(ops, edges, end_us))
+        return false;
+
+    memset(edge_hits, 0, sizeof(edge_hits));
+    edge_previous = 0;
+    result.stuck = false;
+    std::fill(result.error_us, result.error_us + ERROR_COUNT, -1.0);
+
+    FuzzBus bus(edges, end_us);
+    fuzz_bus = &bus;
+    {
+        DS2502 device(0x28, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A);
+#if STATIC_DISPATCH_ENABLE
+        OneWireHubStatic<DS2502> hub(0, device); // like the firmware
+        hub.begin();
+#else
+        OneWireHub hub(0);
+        hub.attach(device);
+#endif
+        try
+        {
+            do
+            {
+                hub.poll(); // returns after every failed transaction and when the line stays idle
+                const uint8_t error = uint8_t(hub.getError());
+                if ((error != uint8_t(Error::NO_ERROR)) && (error < ERROR_COUNT))
+                    result.error_us[error] = std::max(result.error_us[error], bus.errorPath());
+            } while (!bus.finished());
+        }
+        catch (const HubStuck &)
+        {
+            result.stuck = true;
+        }
+    }
+    fuzz_bus = nullptr;
+
+    // errors and a stuck hub count as edges of their own
+    for (uint8_t error = 1; error < ERROR_COUNT; ++error)
+    {
+        if (result.error_us[error] >= 0)
+            edge_hits[EDGE_MAP_SIZE - error] = 1;
+    }
+    if (result.stuck)
+        edge_hits[EDGE_MAP_SIZE - ERROR_COUNT] = 1;
+
+    result.gap_blocks = bus.gapBlocks();
+    result.gap_op = bus.gapOp();
+    result.new_coverage = mergeCoverage();
+    return true;
+}
+
+///////////////////////////////////////////// inputs /////////////////////////////////////////////
+
+static MasterOp opReset(const uint32_t low_us = MASTER_TIME_RESET_US) { return {MasterOp::RESET, low_us, 8}; }
+static MasterOp opWrite(const uint8_t byte, const uint16_t bits = 8) { return {MasterOp::WRITE, byte, bits}; }
+static MasterOp opRead(const uint32_t bits) { return {MasterOp::READ, bits, 8}; }
+
+// the query of the EC, the commands of the DS2502 and the error scenarios of avrbench
+static std::vector<Ops> builtinInputs(void)
+{
+    return {
+        {opReset(), opWrite(0xCC), opWrite(0xF0), opWrite(0x08), opWrite(0x00), opRead(32)},
+        {opReset(), opWrite(0xCC), opWrite(0xF0), opWrite(0x00), opWrite(0x00), opRead(8 * (1 + 128 + 1))},
+        {opReset(), opWrite(0xCC), opWrite(0xAA), opWrite(0x00), opWrite(0x00), opRead(8 * (1 + 8 + 1))},
+        {opReset(), opWrite(0xCC), opWrite(0xC3), opWrite(0x00), opWrite(0x00), opRead(8 * (1 + 1))},
+        {opReset(), opWrite(0x33), opRead(64)},
+        {opReset(300), opReset()},
+        {opReset(6000), opReset()},
+        {opReset(), opWrite(0x42)},
+        {opReset(), opWrite(0xCC), opWrite(0xF0, 4)},
+        {opReset(), opWrite(0xCC), opWrite(0xF0), opWrite(0x08), opWrite(0x00), opRead(5), opReset()},
+    };
+}
+
+static bool loadInputs(const std::string &dir, std::vector<Ops> &inputs)
+{
+    DIR *const handle = opendir(dir.c_str());
+    if (handle == nullptr)
+        return false;
+    std::vector<std::string> names;
+    while (const dirent *const entry = readdir(handle))
+    {
+        const std::string name = entry->d_name;
+        if ((name.size() > 5) && (name.compare(name.size() - 5, 5, ".seed") == 0))
+            names.push_back(name);
+    }
+    closedir(handle);
+    std::sort(names.begin(), names.end()); // readdir has no order, the runs would depend on the file system
+    for (const std::string &name : names)
+    {
+        Ops ops;
+        std::string error;
+        if (!readMasterScript(dir + "/" + name, ops, error))
+        {
+            fprintf(stderr, "%s\n", error.c_str());
+            continue;
+        }
+        inputs.push_back(ops);
+    }
+    return true;
+}
+
+///////////////////////////////////////////// mutation /////////////////////////////////////////////
+
+class Mutator
+{
+private:
+    std::mt19937 &random;
+
+    uint32_t below(const uint32_t limit) { return (limit == 0) ? 0 : uint32_t(random() % limit); }
+
+    bool chance(const uint32_t percent) { return below(100) < percent; }
+
+    uint8_t byte(void) { return chance(60) ? COMMANDS[below(sizeof(COMMANDS))] : uint8_t(random()); }
+
+    uint32_t resetLow(void)
+    {
+        switch (below(4))
+        {
+        case 0:
+            return MASTER_TIME_RESET_US;
+        case 1:
+            return 1 + below(700); // short resets, lows the hub may take for a slot
+        case 2:
+            return 400 + below(200);
+        default:
+            return 1 + below(8000); // very long resets
+        }
+    }
+
+    MasterOp randomOp(void)
+    {
+        switch (below(6))
+        {
+        case 0:
+            return opReset(resetLow());
+        case 1:
+        case 2:
+            return opWrite(byte(), chance(80) ? 8 : uint16_t(1 + below(8)));
+        case 3:
+            return opRead(chance(70) ? 8 * (1 + below(8)) : 1 + below(64));
+        case 4:
+            return {MasterOp::IDLE, chance(70) ? below(200) : below(8000), 8};
+        default:
+            return {MasterOp::SCALE, 50 + below(151), 8};
+        }
+    }
+
+    // index of a random op of the kind, ops.size() if there is none
+    size_t pick(const Ops &ops, const MasterOp::Kind kind)
+    {
+        std::vector<size_t> found;
+        for (size_t index = 0; index < ops.size(); ++index)
+        {
+            if (ops[index].kind == kind)
+                found.push_back(index);
+        }
+        return found.empty() ? ops.size() : found[below(uint32_t(found.size()))];
+    }
+
+public:
+    explicit Mutator(std::mt19937 &random) : random(random){};
+
+    void mutate(Ops &ops, const std::vector<Ops> &corpus)
+    {
+        const uint32_t count = 1 + below(4);
+        for (uint32_t round = 0; round < count; ++round)
+        {
+            size_t index = 0;
+            switch (below(11))
+            {
+            case 0: // flip a bit of a command or address
+                if ((index = pick(ops, MasterOp::WRITE)) < ops.size())
+                    ops[index].value ^= 1u << below(8);
+                break;
+            case 1:
+                if ((index = pick(ops, MasterOp::WRITE)) < ops.size())
+                    ops[index].value = byte();
+                break;
+            case 2: // master stops in the middle of a byte
+                if ((index = pick(ops, MasterOp::WRITE)) < ops.size())
+                    ops[index].bits = uint16_t(1 + below(8));
+                break;
+            case 3:
+                if ((index = pick(ops, MasterOp::READ)) < ops.size())
+                {
+                    uint32_t &bits = ops[index].value;
+                    bits = chance(50) ? 1 + below(2 * bits + 8) : (chance(50) ? bits * 2 : bits / 2);
+                    bits = std::min(std::max(bits, 1u), MASTERSCRIPT_READ_LIMIT);
+                }
+                break;
+            case 4:
+                ops.insert(ops.begin() + below(uint32_t(ops.size() + 1)), randomOp());
+                break;
+            case 5:
+                if (ops.size() > 1)
+                    ops.erase(ops.begin() + below(uint32_t(ops.size())));
+                break;
+            case 6:
+                index = below(uint32_t(ops.size()));
+                ops.insert(ops.begin() + index, ops[index]);
+                break;
+            case 7: // reset lows and where the resets are
+                if (chance(50) && ((index = pick(ops, MasterOp::RESET)) < ops.size()))
+                    ops[index].value = resetLow();
+                else
+                    ops.insert(ops.begin() + below(uint32_t(ops.size() + 1)), opReset(resetLow()));
+                break;
+            case 8: // slot timing of the master
+                if (chance(50) && ((index = pick(ops, MasterOp::SCALE)) < ops.size()))
+                    ops[index].value = 50 + below(151);
+                else
+                    ops.insert(ops.begin() + below(uint32_t(ops.size() + 1)), MasterOp{MasterOp::SCALE, 50 + below(151), 8});
+                break;
+            case 9:
+                if ((index = pick(ops, MasterOp::IDLE)) < ops.size())
+                    ops[index].value = chance(70) ? below(200) : below(8000);
+                else
+                    ops.insert(ops.begin() + below(uint32_t(ops.size() + 1)), MasterOp{MasterOp::IDLE, below(8000), 8});
+                break;
+            default: // head of this one, tail of another
+            {
+                const Ops &other = corpus[below(uint32_t(corpus.size()))];
+                const size_t head = below(uint32_t(ops.size() + 1));
+                const size_t tail = below(uint32_t(other.size()));
+                ops.resize(head);
+                ops.insert(ops.end(), other.begin() + tail, other.end());
+                break;
+            }
+            }
+        }
+        if (ops.size() > OPS_LIMIT)
+            ops.resize(OPS_LIMIT);
+    }
+};
+
+///////////////////////////////////////////// worst cases /////////////////////////////////////////////
+
+struct Worst
+{
+    Ops ops;
+    double value; // blocks or us, < 0: not found
+
+    Worst(void) : value(-1.0){};
+    Worst(const Ops &ops, const double value) : ops(ops), value(value){};
+};
+
+struct Worsts
+{
+    Worst gap;
+    Worst error[ERROR_COUNT];
+    Worst stuck;
+};
+
+// returns true if anything got worse
+static bool updateWorsts(Worsts &worsts, const Ops &ops, const RunResult &result, const bool verbose)
+{
+    bool worse = false;
+    if (double(result.gap_blocks) > worsts.gap.value)
+    {
+        worsts.gap = Worst(ops, double(result.gap_blocks));
+        if (verbose)
+            fprintf(stderr, "gap %u blocks at %s\n", unsigned(result.gap_blocks), formatMasterOp(ops[result.gap_op]).c_str());
+        worse = true;
+    }
+    for (uint8_t error = 1; error < ERROR_COUNT; ++error)
+    {
+        if ((error == uint8_t(Error::WAIT_RESET_TIMEOUT)) || (result.error_us[error] <= worsts.error[error].value + LOOP_US))
+            continue;
+        worsts.error[error] = Worst(ops, result.error_us[error]);
+        if (verbose)
+            fprintf(stderr, "%s after %.1f us\n", ERROR_NAMES[error], result.error_us[error]);
+        worse = true;
+    }
+    if (result.stuck && (worsts.stuck.value < 0))
+    {
+        worsts.stuck = Worst(ops, 1.0);
+        if (verbose)
+            fprintf(stderr, "hub stuck\n");
+        worse = true;
+    }
+    return worse;
+}
+
+// drops ops and shortens idles and reset lows as long as holds() stays true
+static Ops minimise(Ops ops, const std::function<bool(const RunResult &)> &holds)
+{
+    RunResult result;
+    const auto keeps = [&](const Ops &candidate) { return execute(candidate, result) && holds(result); };
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t index = ops.size(); index-- > 0;)
+        {
+            Ops candidate(ops);
+            candidate.erase(candidate.begin() + index);
+            if (!candidate.empty() && keeps(candidate))
+            {
+                ops.swap(candidate);
+                changed = true;
+            }
+        }
+        for (size_t index = 0; index < ops.size(); ++index)
+        {
+            MasterOp &op = ops[index];
+            if ((op.kind == MasterOp::RESET) && (op.value > MASTER_TIME_RESET_US))
+            {
+                Ops candidate(ops);
+                candidate[index].value = MASTER_TIME_RESET_US;
+                if (keeps(candidate))
+                {
+                    ops.swap(candidate);
+                    changed = true;
+                }
+            }
+            else if ((op.kind == MasterOp::IDLE) && (op.value > 0))
+            {
+                Ops candidate(ops);
+                candidate[index].value = op.value / 2;
+                if (keeps(candidate))
+                {
+                    ops.swap(candidate);
+                    changed = true;
+                }
+            }
+        }
+    }
+    return ops;
+}
+
+static std::string lowerCase(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](const char letter) { return char(tolower(letter)); });
+    return text;
+}
+
+static void saveSeed(const Options &options, const std::string &name, const Ops &ops, const std::string &comment)
+{
+    if (options.output_dir.empty())
+        return;
+    const std::string path = options.output_dir + "/" + name + ".seed";
+    if (!writeMasterScript(path, ops, comment))
+        fprintf(stderr, "can't write %s\n", path.c_str());
+}
+
+static void reportWorsts(const Options &options, const Worsts &worsts)
+{
+    char comment[160];
+    RunResult result;
+
+    if (worsts.gap.value >= 0)
+    {
+        const double target = worsts.gap.value;
+        const Ops ops = minimise(worsts.gap.ops, [target](const RunResult &run) { return double(run.gap_blocks) >= target; });
+        execute(ops, result);
+        printf("longest gap: %u blocks between two looks at the line, at %s, %u ops\n", unsigned(result.gap_blocks),
+               formatMasterOp(ops[result.gap_op]).c_str(), unsigned(ops.size()));
+        snprintf(comment, sizeof(comment), "owfuzz -s %u: longest gap, %u blocks between two looks at the line, at op %u (%s)", unsigned(options.seed),
+                 unsigned(result.gap_blocks), unsigned(result.gap_op), formatMasterOp(ops[result.gap_op]).c_str());
+        saveSeed(options, "gap", ops, comment);
+    }
+
+    printf("error paths, us from the last edge of the master to the return of poll():\n");
+    for (uint8_t error = 1; error < ERROR_COUNT; ++error)
+    {
+        const Worst &worst = worsts.error[error];
+        if ((error == uint8_t(Error::WAIT_RESET_TIMEOUT)) || (worst.value < 0))
+            continue;
+        const double target = worst.value;
+        const Ops ops = minimise(worst.ops, [target, error](const RunResult &run) { return run.error_us[error] >= target - LOOP_US; });
+        execute(ops, result);
+        printf("  %-28s %8.1f us, %u ops\n", ERROR_NAMES[error], result.error_us[error], unsigned(ops.size()));
+        snprintf(comment, sizeof(comment), "owfuzz -s %u: %s, %.1f us from the last edge of the master to the return of poll()", unsigned(options.seed),
+                 ERROR_NAMES[error], result.error_us[error]);
+        saveSeed(options, "error-" + lowerCase(ERROR_NAMES[error]), ops, comment);
+    }
+
+    if (worsts.stuck.value < 0)
+    {
+        printf("stuck: none\n");
+        return;
+    }
+    const Ops ops = minimise(worsts.stuck.ops, [](const RunResult &run) { return run.stuck; });
+    printf("stuck: poll() did not return %.0f ms after the script, %u ops\n", STUCK_US / 1000.0, unsigned(ops.size()));
+    snprintf(comment, sizeof(comment), "owfuzz -s %u: poll() does not return after the script", unsigned(options.seed));
+    saveSeed(options, "stuck", ops, comment);
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options)
+{
+    for (int index = 1; index < argc; ++index)
+    {
+        const char *const flag = argv[index];
+        if (strcmp(flag, "-v") == 0)
+        {
+            options.verbose = true;
+            continue;
+        }
+        if (index + 1 >= argc)
+            return false;
+        const char *const value = argv[++index];
+
+        if (strcmp(flag, "-n") == 0)
+            options.runs = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-s") == 0)
+            options.seed = uint32_t(strtoul(value, nullptr, 10));
+        else if (strcmp(flag, "-i") == 0)
+            options.input_dir = value;
+        else if (strcmp(flag, "-o") == 0)
+            options.output_dir = value;
+        else
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "usage: %s [-n runs] [-s seed] [-i seed_dir] [-o seed_dir] [-v]\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<Ops> inputs = builtinInputs();
+    if (!options.input_dir.empty() && !loadInputs(options.input_dir, inputs))
+    {
+        fprintf(stderr, "can't read %s\n", options.input_dir.c_str());
+        return 2;
+    }
+    if (!options.output_dir.empty() && !makeDirectories(options.output_dir))
+    {
+        fprintf(stderr, "%s: %s\n", options.output_dir.c_str(), strerror(errno));
+        return 2;
+    }
+
+    const auto time_start = std::chrono::steady_clock::now();
+    std::vector<Ops> corpus;
+    Worsts worsts;
+    RunResult result;
+    for (const Ops &ops : inputs)
+    {
+        if (!execute(ops, result))
+            continue;
+        corpus.push_back(ops); // every input stays, they are the regression seeds of earlier runs
+        updateWorsts(worsts, ops, result, options.verbose);
+    }
+    if (corpus.empty())
+    {
+        fprintf(stderr, "no input fits in a run\n");
+        return 2;
+    }
+
+    std::mt19937 random(options.seed);
+    Mutator mutator(random);
+    uint32_t executed = 0;
+    for (uint32_t run = 0; run < options.runs; ++run)
+    {
+        Ops ops = corpus[random() % corpus.size()];
+        mutator.mutate(ops, corpus);
+        if (!execute(ops, result))
+            continue;
+        ++executed;
+        if (result.new_coverage)
+            corpus.push_back(ops);
+        updateWorsts(worsts, ops, result, options.verbose);
+        if (options.verbose && ((run + 1) % PROGRESS_RUNS == 0))
+            fprintf(stderr, "%u runs, corpus %u, edges %u\n", unsigned(run + 1), unsigned(corpus.size()), unsigned(edgeCount()));
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+
+    printf("runs %u (%u mutants), %.2f s, corpus %u, edges %u\n", unsigned(inputs.size() + executed), unsigned(executed), seconds,
+           unsigned(corpus.size()), unsigned(edgeCount()));
+    reportWorsts(options, worsts);
+    return (worsts.stuck.value < 0) ? 0 : 1;
+}
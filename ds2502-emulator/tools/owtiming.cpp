@@ -0,0 +1,440 @@
+// measures the 1-Wire timing of a master in sigrok captures (pulse-view/) and derives the normal speed windows of the hub from it
+// - the lows of the line go through OneWireDecoder (common/onewire.h): resets, presence pulses, write- and read-slots
+// - master: widths of resets, write-ones and write-zeros, periods of the slots (its sample point of a read can't be seen on the line)
+// - device: wait and width of the presence, hold of a read-zero -> only taken from reference captures (-r) of a genuine adapter
+//
+// usage: owtiming [-p probe] [-m margin_%] [-o header] capture.. [-r reference_capture]..
+//   -o writes OneWireHub_measured.h for MEASURED_TIMING_ENABLE, windows of the master get the margin on both sides (oscillator of the
+//      hub, spread of the masters), the device values are the medians of the reference. windows without samples keep the current value
+
+#include "../src/OneWireHub.h"
+#include "common/onewire.h"
+#include "common/sigrok.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+constexpr double SLOT_PERIOD_MAX_US{1000};   // longer pauses between slots are not counted as period
+constexpr double MARGIN_PCT_DEFAULT{15};     // rc oscillator of the hub (+-10%) and the spread between masters
+constexpr uint16_t SAMPLE_GAP_US{3};         // like ONEWIRE_TIME_SAMPLE_GAP, READ_MAX has to leave room for the majority vote
+constexpr char HEADER_GUARD[]{"ONEWIREHUB_MEASURED_H"};
+
+struct Distribution
+{
+    std::vector<double> values;
+
+    void add(const double value) { values.push_back(value); }
+
+    bool empty(void) const { return values.empty(); }
+
+    double percentile(const double fraction) const
+    {
+        std::vector<double> sorted(values);
+        std::sort(sorted.begin(), sorted.end());
+        const size_t index = size_t(std::ceil(fraction * sorted.size()));
+        return sorted[(index == 0) ? 0 : index - 1];
+    }
+
+    double min(void) const { return *std::min_element(values.begin(), values.end()); }
+
+    double max(void) const { return *std::max_element(values.begin(), values.end()); }
+
+    void merge(const Distribution &other) { values.insert(values.end(), other.values.begin(), other.values.end()); }
+};
+
+struct Timing
+{
+    // master
+    Distribution reset;
+    Distribution write_one;
+    Distribution write_zero;
+    Distribution read_low; // low of the master that starts a read-slot
+    Distribution write_period;
+    Distribution read_period;
+    // device
+    Distribution presence_wait;
+    Distribution presence;
+    Distribution read_zero; // start of the slot to the release by the device
+
+    uint32_t transactions{0};
+    uint32_t unknown_slots{0}; // after a command the decoder doesn't know
+    uint32_t collisions{0};    // write-slots with a second low: the device drove the line while the master wrote
+
+    void merge(const Timing &other, const bool master, const bool device)
+    {
+        if (master)
+        {
+            reset.merge(other.reset);
+            write_one.merge(other.write_one);
+            write_zero.merge(other.write_zero);
+            read_low.merge(other.read_low);
+            write_period.merge(other.write_period);
+            read_period.merge(other.read_period);
+            transactions += other.transactions;
+            unknown_slots += other.unknown_slots;
+            collisions += other.collisions;
+        }
+        if (device)
+        {
+            presence_wait.merge(other.presence_wait);
+            presence.merge(other.presence);
+            read_zero.merge(other.read_zero);
+        }
+    }
+};
+
+// the distributions of a capture from what the decoder saw
+class TimingListener : public OneWireListener
+{
+private:
+    Timing &timing;
+    double last_slot_start{-1};
+    bool last_slot_known{false};
+    bool last_slot_write{false};
+
+public:
+    explicit TimingListener(Timing &timing) : timing(timing){};
+
+    void lineDown(const double, const double) override { last_slot_start = -1; }
+
+    void reset(const double, const double width_us) override
+    {
+        timing.reset.add(width_us);
+        last_slot_start = -1;
+    }
+
+    void presence(const double wait_us, const double width_us) override
+    {
+        timing.presence_wait.add(wait_us);
+        timing.presence.add(width_us);
+        ++timing.transactions;
+    }
+
+    void slot(const OneWireSlot &slot) override
+    {
+        if (last_slot_start >= 0)
+        {
+            const double period = slot.start_us - last_slot_start;
+            if ((period < SLOT_PERIOD_MAX_US) && last_slot_known)
+                (last_slot_write ? timing.write_period : timing.read_period).add(period);
+        }
+        last_slot_start = slot.start_us;
+        last_slot_known = slot.known;
+        last_slot_write = slot.write;
+
+        if (!slot.known)
+        {
+            ++timing.unknown_slots;
+            return;
+        }
+        if (slot.write)
+        {
+            if (slot.master_low_us < slot.low_us)
+                ++timing.collisions;
+            else
+                (slot.one ? timing.write_one : timing.write_zero).add(slot.master_low_us);
+        }
+        else
+        {
+            if (slot.one || (slot.master_low_us < slot.low_us))
+                timing.read_low.add(slot.master_low_us); // a zero of the device that started right away hides the low of the master
+            if (!slot.one)
+                timing.read_zero.add(slot.low_us);
+        }
+    }
+};
+
+static bool measureCapture(const std::string &path, const std::string &probe_name, Timing &timing)
+{
+    SigrokReader reader;
+    if (!reader.open(path))
+    {
+        fprintf(stderr, "%s: no sigrok session\n", path.c_str());
+        return false;
+    }
+    const int probe = probe_name.empty() ? 0 : reader.findProbe(probe_name);
+    if (probe < 0)
+    {
+        fprintf(stderr, "%s: no probe %s\n", path.c_str(), probe_name.c_str());
+        return false;
+    }
+    const size_t unitsize = reader.getUnitSize();
+    const size_t byte_index = size_t(probe) / 8;
+    const uint8_t mask = uint8_t(1u << (probe % 8));
+
+    // the line may already be low when the capture starts and still be low at its end, both lows are cut -> not measured
+    TimingListener listener(timing);
+    OneWireDecoder decoder(listener, reader.getSamplerate());
+    std::vector<uint8_t> samples;
+    uint64_t sample = 0;
+    uint64_t fall = 0;
+    bool level = true;
+    bool cut = true;
+    for (uint32_t chunk = 0; chunk < reader.getChunkCount(); ++chunk)
+    {
+        if (!reader.readChunk(chunk, samples))
+        {
+            fprintf(stderr, "%s: chunk %u is broken\n", path.c_str(), unsigned(chunk + 1));
+            return false;
+        }
+        for (size_t offset = byte_index; offset < samples.size(); offset += unitsize, ++sample)
+        {
+            const bool next = ((samples[offset] & mask) != 0);
+            if ((sample == 0) && !next)
+                level = false;
+            if (next == level)
+                continue;
+            level = next;
+            if (!level)
+            {
+                fall = sample;
+                cut = false;
+            }
+            else if (!cut)
+                decoder.low(fall, sample);
+        }
+    }
+    decoder.finish();
+    return true;
+}
+
+static void printDistribution(const char *const name, const Distribution &distribution)
+{
+    if (distribution.empty())
+    {
+        printf("  %-16s -\n", name);
+        return;
+    }
+    printf("  %-16s %6u %8.2f %8.2f %8.2f %8.2f %8.2f\n", name, unsigned(distribution.values.size()), distribution.min(),
+           distribution.percentile(0.01), distribution.percentile(0.50), distribution.percentile(0.99), distribution.max());
+}
+
+static void printTiming(const char *const title, const Timing &timing)
+{
+    printf("%s: %u transactions, %u slots not followed, %u collisions\n", title, unsigned(timing.transactions), unsigned(timing.unknown_slots),
+           unsigned(timing.collisions));
+    printf("  %-16s %6s %8s %8s %8s %8s %8s\n", "us", "n", "min", "p1", "p50", "p99", "max");
+    printDistribution("reset", timing.reset);
+    printDistribution("write-one", timing.write_one);
+    printDistribution("write-zero", timing.write_zero);
+    printDistribution("read-slot low", timing.read_low);
+    printDistribution("write period", timing.write_period);
+    printDistribution("read period", timing.read_period);
+    printDistribution("presence wait", timing.presence_wait);
+    printDistribution("presence", timing.presence);
+    printDistribution("read-zero hold", timing.read_zero);
+}
+
+struct Window
+{
+    const char *name;
+    uint16_t value_us;
+    std::string comment;
+};
+
+static uint16_t roundUs(const double value_us)
+{
+    return uint16_t(std::min(65535.0, std::max(1.0, std::round(value_us))));
+}
+
+static std::string describe(const char *const format, const double value)
+{
+    char text[96];
+    snprintf(text, sizeof(text), format, value);
+    return text;
+}
+
+// windows of the hub, without samples the current ones of OneWireHub_config.h stay
+static std::vector<Window> deriveWindows(const Timing &timing, const double margin)
+{
+    Window reset_min{"HUB_TIME_RESET_MIN_US", HUB_TIME_RESET_MIN_US, "not measured"};
+    Window reset_max{"HUB_TIME_RESET_MAX_US", HUB_TIME_RESET_MAX_US, "not measured"};
+    Window presence_timeout{"HUB_TIME_PRESENCE_TIMEOUT_US", HUB_TIME_PRESENCE_TIMEOUT_US, "no reference"};
+    Window presence_min{"HUB_TIME_PRESENCE_MIN_US", HUB_TIME_PRESENCE_MIN_US, "no reference"};
+    Window slot_max{"HUB_TIME_SLOT_MAX_US", HUB_TIME_SLOT_MAX_US, "not measured"};
+    Window read_min{"HUB_TIME_READ_MIN_US", HUB_TIME_READ_MIN_US, "not measured"};
+    Window read_max{"HUB_TIME_READ_MAX_US", HUB_TIME_READ_MAX_US, "not measured"};
+    Window write_zero{"HUB_TIME_WRITE_ZERO_US", HUB_TIME_WRITE_ZERO_US, "no reference"};
+
+    if (!timing.reset.empty())
+    {
+        reset_min.value_us = uint16_t(std::floor(timing.reset.min() * (1.0 - margin)));
+        reset_min.comment = describe("shortest reset %.1fus - margin", timing.reset.min());
+        reset_max.value_us = uint16_t(std::ceil(timing.reset.max() * (1.0 + margin)));
+        reset_max.comment = describe("longest reset %.1fus + margin", timing.reset.max());
+    }
+    if (!timing.write_one.empty() && !timing.write_zero.empty())
+    {
+        // like ADAPTIVE_TIMING_ENABLE: middle between the longest write-one and the shortest write-zero
+        const double one_max = timing.write_one.max() * (1.0 + margin);
+        const double zero_min = timing.write_zero.min() * (1.0 - margin);
+        read_min.value_us = roundUs((one_max + zero_min) / 2.0);
+        read_min.comment = describe("middle of write-one %.1fus + margin", timing.write_one.max()) +
+                           describe(" and write-zero %.1fus - margin", timing.write_zero.min());
+        if (one_max >= zero_min)
+            read_min.comment += " -> OVERLAP";
+    }
+    if (!timing.write_zero.empty())
+    {
+        read_max.value_us = uint16_t(std::ceil(timing.write_zero.max() * (1.0 + margin)));
+        read_max.comment = describe("longest write-zero %.1fus + margin", timing.write_zero.max());
+        slot_max.value_us = uint16_t(read_max.value_us + read_max.value_us / 4);
+        slot_max.comment = "READ_MAX + 1/4, like ADAPTIVE_TIMING_ENABLE";
+    }
+    if (!timing.presence_wait.empty())
+    {
+        presence_timeout.value_us = roundUs(timing.presence_wait.percentile(0.50));
+        presence_timeout.comment = "median wait of the reference device";
+        presence_min.value_us = roundUs(timing.presence.percentile(0.50));
+        presence_min.comment = "median presence of the reference device";
+    }
+    if (!timing.read_zero.empty())
+    {
+        write_zero.value_us = roundUs(timing.read_zero.percentile(0.50));
+        write_zero.comment = "median read-zero hold of the reference device";
+    }
+    return {reset_min, reset_max, presence_timeout, presence_min, slot_max, read_min, read_max, write_zero};
+}
+
+// the static_asserts of OneWireHub::OneWireHub() and checkReset() ahead of the compiler, in loops like there
+static bool checkWindows(const std::vector<Window> &windows)
+{
+    const timeOW_t reset_min = timeUsToLoops(windows[0].value_us);
+    const timeOW_t reset_max = timeUsToLoops(windows[1].value_us);
+    const timeOW_t presence_min = timeUsToLoops(windows[3].value_us);
+    const timeOW_t slot_max = timeUsToLoops(windows[4].value_us);
+    const timeOW_t read_min = timeUsToLoops(windows[5].value_us);
+    const timeOW_t read_max = timeUsToLoops(windows[6].value_us);
+    const timeOW_t write_zero = timeUsToLoops(windows[7].value_us);
+
+    const struct
+    {
+        bool good;
+        const char *rule;
+    } rules[] = {
+        {reset_min > (slot_max + read_max), "RESET_MIN > SLOT_MAX + READ_MAX"},
+        {(reset_min - slot_max) > slot_max, "RESET_MIN - SLOT_MAX > SLOT_MAX"},
+        {reset_max > reset_min, "RESET_MAX > RESET_MIN"},
+        {read_max > write_zero, "READ_MAX > WRITE_ZERO"},
+        {read_max > (read_min + timeUsToLoops(SAMPLE_GAP_US)), "READ_MAX > READ_MIN + SAMPLE_GAP"},
+        {ONEWIRE_TIME_PRESENCE_MAX[0] > presence_min, "PRESENCE_MAX > PRESENCE_MIN"},
+        {ONEWIRE_TIME_ADAPT_READ_MIN_HIGH < read_max, "ADAPT_READ_MIN_HIGH < READ_MAX"},
+        {ONEWIRE_TIME_ADAPT_RESET_MIN_LOW > (slot_max + read_max), "ADAPT_RESET_MIN_LOW > SLOT_MAX + READ_MAX"},
+        {windows[5].comment.find("OVERLAP") == std::string::npos, "write-one and write-zero of the master apart"},
+    };
+    bool good = true;
+    for (const auto &rule : rules)
+    {
+        if (!rule.good)
+            fprintf(stderr, "timing rule broken: %s\n", rule.rule);
+        good &= rule.good;
+    }
+    return good;
+}
+
+static bool writeHeader(const std::string &path, const std::vector<Window> &windows, const std::vector<std::string> &captures,
+                        const std::vector<std::string> &references, const double margin_pct)
+{
+    FILE *const file = fopen(path.c_str(), "w");
+    if (file == nullptr)
+        return false;
+
+    std::string master_list, reference_list;
+    for (const std::string &capture : captures)
+        master_list += " " + capture.substr(capture.find_last_of('/') + 1);
+    for (const std::string &reference : references)
+        reference_list += " " + reference.substr(reference.find_last_of('/') + 1);
+
+    fprintf(file, "// normal speed windows of the hub, generated by tools/owtiming for MEASURED_TIMING_ENABLE -> don't edit, measure again\n");
+    fprintf(file, "// master:%s, margin %.0f %%\n", master_list.c_str(), margin_pct);
+    fprintf(file, "// reference device:%s\n\n", reference_list.empty() ? " none" : reference_list.c_str());
+    fprintf(file, "#ifndef %s\n#define %s\n\n", HEADER_GUARD, HEADER_GUARD);
+
+    std::vector<std::string> lines;
+    size_t width = 0;
+    for (const Window &window : windows)
+    {
+        lines.push_back("constexpr uint16_t " + std::string(window.name) + "{" + std::to_string(window.value_us) + "};");
+        width = std::max(width, lines.back().size());
+    }
+    for (size_t index = 0; index < windows.size(); ++index)
+        fprintf(file, "%-*s // %s\n", int(width), lines[index].c_str(), windows[index].comment.c_str());
+
+    fprintf(file, "\n#endif // %s\n", HEADER_GUARD);
+    return (fclose(file) == 0);
+}
+
+int main(int argc, char *argv[])
+{
+    std::string probe_name, header_path;
+    double margin_pct = MARGIN_PCT_DEFAULT;
+    std::vector<std::string> captures, references;
+
+    bool usable = true;
+    for (int index = 1; index < argc; ++index)
+    {
+        const char *const flag = argv[index];
+        if (flag[0] != '-')
+        {
+            captures.push_back(flag);
+            continue;
+        }
+        if (index + 1 >= argc)
+        {
+            usable = false;
+            break;
+        }
+        const char *const value = argv[++index];
+        if (strcmp(flag, "-p") == 0)
+            probe_name = value;
+        else if (strcmp(flag, "-m") == 0)
+            margin_pct = strtod(value, nullptr);
+        else if (strcmp(flag, "-o") == 0)
+            header_path = value;
+        else if (strcmp(flag, "-r") == 0)
+            references.push_back(value);
+        else
+            usable = false;
+    }
+    if (!usable || (captures.empty() && references.empty()) || (margin_pct < 0) || (margin_pct >= 50))
+    {
+        fprintf(stderr, "usage: %s [-p probe] [-m margin_%%] [-o header] capture.. [-r reference_capture]..\n", argv[0]);
+        return 2;
+    }
+
+    // the master is measured in every capture, the device only in the references. a file given both ways counts once
+    Timing combined;
+    for (size_t index = 0; index < captures.size() + references.size(); ++index)
+    {
+        const bool reference = (index >= captures.size());
+        const std::string &path = reference ? references[index - captures.size()] : captures[index];
+        const bool also_reference = std::find(references.begin(), references.end(), path) != references.end();
+        if (!reference && also_reference)
+            continue;
+        Timing timing;
+        if (!measureCapture(path, probe_name, timing))
+            return 2;
+        printTiming(path.c_str(), timing);
+        combined.merge(timing, true, reference);
+    }
+    printTiming("master of all captures, device of the references", combined);
+
+    const std::vector<Window> windows = deriveWindows(combined, margin_pct / 100.0);
+    printf("windows of the hub, margin %.0f %%\n", margin_pct);
+    for (const Window &window : windows)
+        printf("  %-28s %5u  %s\n", window.name, unsigned(window.value_us), window.comment.c_str());
+
+    if (!checkWindows(windows))
+        return 1;
+    if (!header_path.empty() && !writeHeader(header_path, windows, captures, references, margin_pct))
+    {
+        fprintf(stderr, "can't write %s\n", header_path.c_str());
+        return 2;
+    }
+    return 0;
+}
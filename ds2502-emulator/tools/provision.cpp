@@ -0,0 +1,402 @@
+// builds per-unit EEPROM images (Intel HEX) for the flashing line from a unit manifest
+// - identity: "DELL00AC" + watts + decivolts + deciamps (3 digits each) + PPID (23 chars), CRC16/ARC of OneWireItem appended little endian
+// - written as the record of ChargerProxy (PROXY_EEPROM_*): length, crc8, rom, status (0xFF without one) and the identity,
+//   a PROXY_ENABLE firmware serves it without learning an adapter. the rest of the 128 bytes stays 0xFF
+// - a line with count > 1 expands to count units, the sequence field of the PPID counts up (base 36) per unit
+//
+// manifest, one line per unit or run, '#' starts a comment:
+//   unit,watts,volts,amps,ppid[,count[,status]]
+//   optiplower-65w,65,19.5,3.34,CN05U0927161552F31B8A03,500
+//   optiplower-90w,90,19.5,4.62,CN0C80234866161R23H8A03,1,FEFFFFFFFFFFFF00
+//
+// usage: provision [-o output_dir] manifest.csv -> one <unit>.hex per unit, "file,identity" per unit on stdout
+
+#include "../src/OneWireItem.h"
+#include "common/files.h"
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+constexpr uint8_t EEPROM_SIZE{128};  // ATtiny25
+constexpr uint8_t IMAGE_SIZE{128};   // memory of the DS2502
+constexpr uint8_t STATUS_SIZE{8};    // status memory of the DS2502
+constexpr uint8_t IDENTITY_SIZE{40}; // without the crc
+constexpr uint8_t PPID_SIZE{23};     // country 2, part 6, supplier 5, date 3, sequence 4, revision 3
+constexpr uint8_t PPID_SEQUENCE{16}; // first char of the sequence
+constexpr uint8_t PPID_SEQUENCE_SIZE{4};
+constexpr uint8_t HEX_RECORD_SIZE{16}; // bytes per data record, like eeprom-data.hex
+constexpr uint8_t IMAGE_LIMIT{BOOT_BENCH_EEPROM_ADDR - PROXY_EEPROM_IMAGE}; // like ChargerProxy
+constexpr uint8_t ROM[8]{0x09, 0x0D, 0x01, 0x08, 0x0B, 0x02, 0x0A, 0x00}; // serial of the sketch, crc8 gets filled in
+
+static_assert(IDENTITY_SIZE + 2 <= IMAGE_LIMIT, "identity does not fit the record of the proxy");
+
+struct Unit
+{
+    std::string name;
+    uint16_t watts;
+    uint16_t decivolts;
+    uint16_t deciamps;
+    std::string ppid;
+    uint32_t count;
+    bool has_status;
+    uint32_t line_number;
+    uint8_t status[STATUS_SIZE];
+};
+
+static std::string trim(const std::string &text)
+{
+    const size_t first = text.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos)
+        return "";
+    return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+static std::vector<std::string> splitFields(const std::string &line)
+{
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true)
+    {
+        const size_t end = line.find(',', start);
+        fields.push_back(trim(line.substr(start, end - start)));
+        if (end == std::string::npos)
+            return fields;
+        start = end + 1;
+    }
+}
+
+static bool parseNumber(const std::string &text, const double scale, uint16_t &value)
+{
+    char *end = nullptr;
+    errno = 0;
+    const double number = strtod(text.c_str(), &end);
+    if (text.empty() || (*end != 0) || (errno != 0))
+        return false;
+    const long scaled = lround(number * scale);
+    if ((scaled < 0) || (scaled > 999))
+        return false; // has to fit 3 digits
+    value = uint16_t(scaled);
+    return true;
+}
+
+static int8_t hexNibble(const char character)
+{
+    if ((character >= '0') && (character <= '9'))
+        return int8_t(character - '0');
+    if ((character >= 'A') && (character <= 'F'))
+        return int8_t(character - 'A' + 10);
+    if ((character >= 'a') && (character <= 'f'))
+        return int8_t(character - 'a' + 10);
+    return -1;
+}
+
+static bool parseUnit(const std::string &line, Unit &unit, std::string &error)
+{
+    const std::vector<std::string> fields = splitFields(line);
+    if ((fields.size() < 5) || (fields.size() > 7))
+    {
+        error = "expected unit,watts,volts,amps,ppid[,count[,status]]";
+        return false;
+    }
+
+    unit.name = fields[0];
+    if (unit.name.empty() || (unit.name.find_first_of("/\\") != std::string::npos))
+    {
+        error = "unit has to be a plain file name";
+        return false;
+    }
+    if (!parseNumber(fields[1], 1.0, unit.watts) || !parseNumber(fields[2], 10.0, unit.decivolts) || !parseNumber(fields[3], 10.0, unit.deciamps))
+    {
+        error = "watts, volts and amps have to fit 3 digits (watts, 1/10 V, 1/10 A)";
+        return false;
+    }
+
+    unit.ppid = fields[4];
+    if (unit.ppid.size() != PPID_SIZE)
+    {
+        error = "ppid has to be 23 characters";
+        return false;
+    }
+    for (const char character : unit.ppid)
+    {
+        if (!(((character >= '0') && (character <= '9')) || ((character >= 'A') && (character <= 'Z'))))
+        {
+            error = "ppid may only contain 0-9 and A-Z";
+            return false;
+        }
+    }
+
+    unit.count = 1;
+    if ((fields.size() > 5) && !fields[5].empty())
+    {
+        char *end = nullptr;
+        const unsigned long count = strtoul(fields[5].c_str(), &end, 10);
+        if ((*end != 0) || (count == 0) || (count > 1000000))
+        {
+            error = "count has to be 1 to 1000000";
+            return false;
+        }
+        unit.count = uint32_t(count);
+    }
+
+    unit.has_status = (fields.size() > 6) && !fields[6].empty();
+    if (unit.has_status)
+    {
+        if (fields[6].size() != 2 * STATUS_SIZE)
+        {
+            error = "status has to be 8 bytes in hex";
+            return false;
+        }
+        for (uint8_t index = 0; index < STATUS_SIZE; ++index)
+        {
+            const int8_t high = hexNibble(fields[6][2 * index]);
+            const int8_t low = hexNibble(fields[6][2 * index + 1]);
+            if ((high < 0) || (low < 0))
+            {
+                error = "status has to be 8 bytes in hex";
+                return false;
+            }
+            unit.status[index] = uint8_t((high << 4) | low);
+        }
+    }
+    return true;
+}
+
+static uint32_t sequenceValue(const std::string &ppid)
+{
+    uint32_t value = 0;
+    for (uint8_t position = PPID_SEQUENCE; position < PPID_SEQUENCE + PPID_SEQUENCE_SIZE; ++position)
+    {
+        const char digit = ppid[position];
+        value = 36 * value + uint32_t((digit <= '9') ? (digit - '0') : (digit - 'A' + 10));
+    }
+    return value;
+}
+
+// sequence field of the ppid + 1 in base 36, returns false on an overflow of the field
+static bool nextSequence(std::string &ppid)
+{
+    for (uint8_t position = PPID_SEQUENCE + PPID_SEQUENCE_SIZE; position > PPID_SEQUENCE; --position)
+    {
+        char &digit = ppid[position - 1];
+        if (digit == '9')
+        {
+            digit = 'A';
+            return true;
+        }
+        if (digit != 'Z')
+        {
+            ++digit;
+            return true;
+        }
+        digit = '0';
+    }
+    return false;
+}
+
+static void buildImage(const Unit &unit, const std::string &ppid, uint8_t image[IMAGE_SIZE])
+{
+    char identity[IDENTITY_SIZE + 1];
+    snprintf(identity, sizeof(identity), "DELL00AC%03u%03u%03u%s", unsigned(unit.watts), unsigned(unit.decivolts), unsigned(unit.deciamps), ppid.c_str());
+
+    memset(image, 0xFF, IMAGE_SIZE);
+    memcpy(image, identity, IDENTITY_SIZE);
+    const uint16_t crc = OneWireItem::crc16(image, IDENTITY_SIZE);
+    image[IDENTITY_SIZE] = uint8_t(crc);
+    image[IDENTITY_SIZE + 1] = uint8_t(crc >> 8);
+}
+
+static void appendRecord(std::string &output, const uint16_t address, const uint8_t type, const uint8_t data[], const uint8_t data_length)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    uint8_t checksum = uint8_t(data_length + (address >> 8) + address + type);
+    const uint8_t header[4] = {data_length, uint8_t(address >> 8), uint8_t(address), type};
+
+    output += ':';
+    for (const uint8_t value : header)
+    {
+        output += digits[value >> 4];
+        output += digits[value & 0x0F];
+    }
+    for (uint8_t index = 0; index < data_length; ++index)
+    {
+        output += digits[data[index] >> 4];
+        output += digits[data[index] & 0x0F];
+        checksum = uint8_t(checksum + data[index]);
+    }
+    checksum = uint8_t(-checksum);
+    output += digits[checksum >> 4];
+    output += digits[checksum & 0x0F];
+    output += '\n';
+}
+
+// same record as ChargerProxy::learn(), the crc8 runs over length, rom, status and the programmed bytes of the image
+static void buildEeprom(const uint8_t image[IMAGE_SIZE], const uint8_t *status, uint8_t eeprom[EEPROM_SIZE])
+{
+    uint8_t length = IMAGE_SIZE;
+    while ((length > 0) && (image[length - 1] == 0xFF))
+        --length;
+
+    memset(eeprom, 0xFF, EEPROM_SIZE);
+    eeprom[PROXY_EEPROM_LENGTH] = length;
+    memcpy(&eeprom[PROXY_EEPROM_ROM], ROM, 8);
+    eeprom[PROXY_EEPROM_ROM + 7] = OneWireItem::crc8(ROM, 7);
+    if (status != nullptr)
+        memcpy(&eeprom[PROXY_EEPROM_STATUS], status, STATUS_SIZE);
+    memcpy(&eeprom[PROXY_EEPROM_IMAGE], image, length);
+
+    uint8_t crc = OneWireItem::crc8(&length, 1);
+    crc = OneWireItem::crc8(&eeprom[PROXY_EEPROM_ROM], 8 + STATUS_SIZE, crc);
+    eeprom[PROXY_EEPROM_CRC] = OneWireItem::crc8(&eeprom[PROXY_EEPROM_IMAGE], length, crc);
+}
+
+static std::string buildHex(const uint8_t eeprom[EEPROM_SIZE])
+{
+    std::string output;
+    output.reserve(400);
+    for (uint16_t address = 0; address < EEPROM_SIZE; address += HEX_RECORD_SIZE)
+        appendRecord(output, address, 0x00, &eeprom[address], HEX_RECORD_SIZE);
+    appendRecord(output, 0, 0x01, nullptr, 0);
+    return output;
+}
+
+static std::string unitName(const Unit &unit, const std::string &ppid)
+{
+    return (unit.count == 1) ? unit.name : unit.name + "-" + ppid.substr(PPID_SEQUENCE, PPID_SEQUENCE_SIZE);
+}
+
+static bool writeFile(const std::string &path, const std::string &content)
+{
+    FILE *const file = fopen(path.c_str(), "wb");
+    if (file == nullptr)
+        return false;
+    const bool written = (fwrite(content.data(), 1, content.size(), file) == content.size());
+    return (fclose(file) == 0) && written;
+}
+
+int main(int argc, char *argv[])
+{
+    std::string output_dir = ".";
+    const char *manifest_path = nullptr;
+
+    for (int index = 1; index < argc; ++index)
+    {
+        if ((strcmp(argv[index], "-o") == 0) && (index + 1 < argc))
+            output_dir = argv[++index];
+        else if (manifest_path == nullptr)
+            manifest_path = argv[index];
+        else
+            manifest_path = "";
+    }
+    if ((manifest_path == nullptr) || (*manifest_path == 0))
+    {
+        fprintf(stderr, "usage: %s [-o output_dir] manifest.csv\n", argv[0]);
+        return 2;
+    }
+
+    FILE *const manifest = fopen(manifest_path, "r");
+    if (manifest == nullptr)
+    {
+        fprintf(stderr, "%s: %s\n", manifest_path, strerror(errno));
+        return 1;
+    }
+
+    // everything is checked before the first file is written, a broken manifest leaves no half batch behind
+    std::vector<Unit> units;
+    char buffer[512];
+    uint32_t line_number = 0;
+    bool valid = true;
+    while (fgets(buffer, sizeof(buffer), manifest) != nullptr)
+    {
+        ++line_number;
+        std::string line(buffer);
+        const size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+        if (trim(line).empty())
+            continue;
+
+        Unit unit;
+        std::string error;
+        if (!parseUnit(line, unit, error))
+        {
+            fprintf(stderr, "%s:%u: %s\n", manifest_path, unsigned(line_number), error.c_str());
+            valid = false;
+            continue;
+        }
+        unit.line_number = line_number;
+        units.push_back(unit);
+    }
+    fclose(manifest);
+
+    // sequence fields that run over and file names that two units would share
+    std::set<std::string> names;
+    for (const Unit &unit : units)
+    {
+        if ((sequenceValue(unit.ppid) + (unit.count - 1)) >= (36UL * 36 * 36 * 36))
+        {
+            fprintf(stderr, "%s:%u: sequence %s of the ppid overflows before %u units\n", manifest_path, unsigned(unit.line_number),
+                    unit.ppid.substr(PPID_SEQUENCE, PPID_SEQUENCE_SIZE).c_str(), unsigned(unit.count));
+            valid = false;
+            continue;
+        }
+        std::string ppid = unit.ppid;
+        for (uint32_t index = 0; index < unit.count; ++index)
+        {
+            if (index != 0)
+                nextSequence(ppid);
+            if (!names.insert(unitName(unit, ppid)).second)
+            {
+                fprintf(stderr, "%s:%u: %s is used by an earlier unit\n", manifest_path, unsigned(unit.line_number), unitName(unit, ppid).c_str());
+                valid = false;
+                break;
+            }
+        }
+    }
+    if (!valid)
+        return 1;
+    if (!makeDirectories(output_dir))
+    {
+        fprintf(stderr, "%s: %s\n", output_dir.c_str(), strerror(errno));
+        return 1;
+    }
+
+    std::string summary;
+    uint32_t unit_count = 0;
+    for (const Unit &unit : units)
+    {
+        std::string ppid = unit.ppid;
+        for (uint32_t index = 0; index < unit.count; ++index)
+        {
+            if (index != 0)
+                nextSequence(ppid); // checked above
+
+            uint8_t image[IMAGE_SIZE], eeprom[EEPROM_SIZE];
+            buildImage(unit, ppid, image);
+            buildEeprom(image, unit.has_status ? unit.status : nullptr, eeprom);
+
+            const std::string path = output_dir + "/" + unitName(unit, ppid) + ".hex";
+            if (!writeFile(path, buildHex(eeprom)))
+            {
+                fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+                return 1;
+            }
+
+            summary += path;
+            summary += ',';
+            summary.append(reinterpret_cast<const char *>(image), IDENTITY_SIZE);
+            summary += '\n';
+            ++unit_count;
+        }
+    }
+
+    fwrite(summary.data(), 1, summary.size(), stdout);
+    fprintf(stderr, "%u images written to %s\n", unsigned(unit_count), output_dir.c_str());
+    return 0;
+}
@@ -0,0 +1,810 @@
+// static worst-case cycles between two samples of the line, from the disassembly of the firmware (avr-objdump)
+// - every DIRECT_READ() of the bare-metal build (ONEWIREHUB_WCET_SAMPLES) leaves its address in .debug_wcet_samples (see platform.h), these are the slot events
+// - from each sample in the given functions the longest path to the next sample is searched: through calls, returns into every
+//   caller and loops. polling-loops end at their own sample, other loops need a bound: counted (ldi rX,K .. dec rX, brne) or -l
+// - cycles per instruction of the AVRe core (attiny, atmega): branch taken +1, skip of a 2 word instruction +1
+// - the budget is the time the hub may be blind: a slot that starts right after a sample has to be answered before the master
+//   samples, MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US (AN126 A + E). exit code 1 if a path is longer
+//
+// usage: wcet [-f f_cpu] [-b budget_us] [-l function=bound].. [-c function=target].. [-v] firmware.elf function..
+//   -l  loops without a sample and without a counter in function run at most bound times
+//   -c  indirect calls (icall) in function go to target, e.g. -c OneWireHub::recvAndProcessCmd=DS2502::duty
+//   -v  prints every sample of the functions instead of the worst one
+//   OBJDUMP in the environment replaces avr-objdump
+
+#include "../src/OneWireHub.h"
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+constexpr uint8_t COUNTED_LOOP_LOOKBACK{8}; // instructions before a loop that are searched for the ldi of its counter
+
+constexpr int64_t NO_PATH{-1};
+constexpr double DEFAULT_F_CPU{8000000}; // attiny25 of the charger, "make wcet" passes F_CPU
+
+enum class Flow : uint8_t
+{
+    NEXT,   // everything that does not touch the program counter
+    BRANCH, // brXX
+    SKIP,   // cpse, sbrc, sbrs, sbic, sbis
+    JUMP,   // rjmp, jmp
+    CALL,   // rcall, call, icall, eicall
+    RETURN, // ret, reti
+    UNKNOWN // ijmp, eijmp
+};
+
+struct Instruction
+{
+    uint32_t address;
+    uint8_t size;
+    std::string mnemonic;
+    std::string operands;
+    int64_t target; // of branches, jumps and calls
+    uint32_t function;
+    Flow flow;
+    bool sample;
+};
+
+struct Function
+{
+    std::string name;
+    uint32_t start;
+};
+
+struct Edge
+{
+    uint32_t to;
+    uint8_t cycles;
+    bool back;
+};
+
+struct Worst
+{
+    int64_t cycles{NO_PATH};
+    uint32_t end{0}; // instruction the path ends at, a sample or a return without caller
+
+    Worst(void) = default;
+    Worst(const int64_t cycles, const uint32_t end) : cycles(cycles), end(end){};
+
+    void take(const Worst &other, const int64_t offset)
+    {
+        if ((other.cycles != NO_PATH) && (other.cycles + offset > cycles))
+        {
+            cycles = other.cycles + offset;
+            end = other.end;
+        }
+    }
+};
+
+struct Reach
+{
+    Worst sample;  // to the next sample
+    Worst returns; // to the return of the current function, without a sample on the way
+
+    void take(const Reach &other, const int64_t offset)
+    {
+        sample.take(other.sample, offset);
+        returns.take(other.returns, offset);
+    }
+};
+
+struct Loop
+{
+    std::vector<uint32_t> latches;
+    std::vector<bool> body;
+    bool done{false};
+    bool counting{false}; // guards against irreducible flow
+    int64_t extra{0};     // cycles of the additional marker-free iterations
+};
+
+struct Options
+{
+    double f_cpu{DEFAULT_F_CPU};
+    double budget_us{MASTER_TIME_WRITE_ONE_US + MASTER_TIME_READ_SAMPLE_US};
+    std::map<std::string, uint32_t> bounds;
+    std::multimap<std::string, std::string> indirect;
+    bool verbose{false};
+    std::string elf;
+    std::vector<std::string> functions;
+};
+
+static std::vector<Instruction> program;
+static std::vector<Function> functions;
+static std::map<uint32_t, uint32_t> by_address;
+static std::vector<std::vector<Edge>> edges;
+static std::vector<std::vector<uint32_t>> callees;      // entry instructions
+static std::vector<std::vector<uint32_t>> callers;      // per function: call instructions
+static std::vector<std::vector<uint32_t>> tail_callers; // per function: functions that jump to its entry
+static std::map<uint32_t, Loop> loops;                  // by head
+static std::set<std::string> problems;                  // printed once, sorted
+static Options options;
+
+static bool startsWith(const std::string &text, const std::string &prefix)
+{
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// "OneWireHub::sendBit" matches "OneWireHub::sendBit(bool)" and clones like "OneWireHub::sendBit(bool) [clone .constprop.0]"
+static bool nameMatches(const std::string &name, const std::string &wanted)
+{
+    return startsWith(name, wanted) && ((name.size() == wanted.size()) || (name[wanted.size()] == '(') || (name[wanted.size()] == ' ') || (name[wanted.size()] == '.'));
+}
+
+static std::vector<uint32_t> findFunctions(const std::string &wanted)
+{
+    std::vector<uint32_t> found;
+    for (uint32_t index = 0; index < functions.size(); ++index)
+        if (nameMatches(functions[index].name, wanted))
+            found.push_back(index);
+    return found;
+}
+
+static std::string describe(const uint32_t instruction)
+{
+    const Instruction &insn = program[instruction];
+    char text[32];
+    snprintf(text, sizeof(text), "0x%04" PRIx32 " ", insn.address);
+    return text + functions[insn.function].name;
+}
+
+static Flow classify(const std::string &mnemonic)
+{
+    if (mnemonic == "rjmp" || mnemonic == "jmp")
+        return Flow::JUMP;
+    if (mnemonic == "rcall" || mnemonic == "call" || mnemonic == "icall" || mnemonic == "eicall")
+        return Flow::CALL;
+    if (mnemonic == "ret" || mnemonic == "reti")
+        return Flow::RETURN;
+    if (mnemonic == "ijmp" || mnemonic == "eijmp")
+        return Flow::UNKNOWN;
+    if (mnemonic == "cpse" || mnemonic == "sbrc" || mnemonic == "sbrs" || mnemonic == "sbic" || mnemonic == "sbis")
+        return Flow::SKIP;
+    if (startsWith(mnemonic, "br") && (mnemonic != "break"))
+        return Flow::BRANCH;
+    return Flow::NEXT;
+}
+
+// cycles of the instruction without the extra cycle of a taken branch or a skip
+static uint8_t cyclesOf(const Instruction &insn)
+{
+    static const std::map<std::string, uint8_t> table{
+        {"adiw", 2}, {"sbiw", 2}, {"mul", 2}, {"muls", 2}, {"mulsu", 2}, {"fmul", 2}, {"fmuls", 2}, {"fmulsu", 2},
+        {"ld", 2}, {"ldd", 2}, {"lds", 2}, {"st", 2}, {"std", 2}, {"sts", 2}, {"push", 2}, {"pop", 2},
+        {"cbi", 2}, {"sbi", 2}, {"rjmp", 2}, {"ijmp", 2}, {"lpm", 3}, {"elpm", 3}, {"jmp", 3}, {"eijmp", 2},
+        {"rcall", 3}, {"icall", 3}, {"call", 4}, {"eicall", 4}, {"ret", 4}, {"reti", 4}};
+    const auto entry = table.find(insn.mnemonic);
+    return (entry == table.end()) ? 1 : entry->second;
+}
+
+static bool runObjdump(const std::string &arguments, std::vector<std::string> &lines)
+{
+    const char *const objdump = getenv("OBJDUMP");
+    const std::string command = std::string((objdump != nullptr) ? objdump : "avr-objdump") + " " + arguments + " '" + options.elf + "'";
+    FILE *const pipe = popen(command.c_str(), "r");
+    if (pipe == nullptr)
+        return false;
+    char buffer[512];
+    while (fgets(buffer, sizeof(buffer), pipe) != nullptr)
+    {
+        std::string line(buffer);
+        while (!line.empty() && ((line.back() == '\n') || (line.back() == '\r')))
+            line.pop_back();
+        lines.push_back(line);
+    }
+    return (pclose(pipe) == 0);
+}
+
+static std::vector<std::string> splitTabs(const std::string &line)
+{
+    std::vector<std::string> fields;
+    size_t start = 0;
+    while (true)
+    {
+        const size_t end = line.find('\t', start);
+        fields.push_back(line.substr(start, end - start));
+        if (end == std::string::npos)
+            return fields;
+        start = end + 1;
+    }
+}
+
+//      6c:	0e 94 34 00 	call	0x68	; 0x68 <_Z3foov>
+// 00000068 <foo()>:
+static bool parseDisassembly(const std::vector<std::string> &lines)
+{
+    for (const std::string &line : lines)
+    {
+        uint32_t address;
+        char name[400];
+        if ((sscanf(line.c_str(), "%" SCNx32 " <%399[^\n]", &address, name) == 2) && (line.size() > 2) && (line.compare(line.size() - 2, 2, ">:") == 0))
+        {
+            std::string text(name);
+            text.erase(text.size() - 2);
+            functions.push_back({text, address});
+            continue;
+        }
+
+        const std::vector<std::string> fields = splitTabs(line);
+        if ((fields.size() < 3) || functions.empty() || (sscanf(fields[0].c_str(), " %" SCNx32 ":", &address) != 1) || (fields[0].find(':') == std::string::npos))
+            continue;
+
+        Instruction insn{address, 0, "", "", NO_PATH, uint32_t(functions.size() - 1), Flow::NEXT, false};
+        for (const char character : fields[1])
+            insn.size += (character != ' ') ? 1 : 0;
+        insn.size /= 2;
+        insn.mnemonic = fields[2];
+        while (!insn.mnemonic.empty() && (insn.mnemonic.back() == ' '))
+            insn.mnemonic.pop_back();
+        if (fields.size() > 3)
+            insn.operands = fields[3];
+        insn.flow = classify(insn.mnemonic);
+
+        const size_t comment = line.find("; 0x");
+        if ((insn.flow == Flow::BRANCH || insn.flow == Flow::JUMP || insn.flow == Flow::CALL) && (comment != std::string::npos))
+            insn.target = int64_t(strtoul(line.c_str() + comment + 2, nullptr, 16));
+
+        by_address[address] = uint32_t(program.size());
+        program.push_back(insn);
+    }
+    return !program.empty();
+}
+
+// Contents of section .debug_wcet_samples:
+//  0000 68000000 7a000000 00000000           h...z.......
+static uint32_t parseSamples(const std::vector<std::string> &lines)
+{
+    std::vector<uint8_t> bytes;
+    for (const std::string &line : lines)
+    {
+        if ((line.size() < 2) || (line[0] != ' ') || (line.find("Contents") != std::string::npos))
+            continue;
+        const size_t data = line.find(' ', line.find_first_not_of(' '));
+        if (data == std::string::npos)
+            continue;
+        const std::string hex = line.substr(data, 36); // 4 groups of 4 bytes, the ascii column follows
+        for (size_t position = 0; position + 1 < hex.size(); ++position)
+        {
+            if (hex[position] == ' ')
+                continue;
+            bytes.push_back(uint8_t(strtoul(hex.substr(position, 2).c_str(), nullptr, 16)));
+            ++position;
+        }
+    }
+
+    uint32_t count = 0;
+    for (size_t index = 0; index + 3 < bytes.size(); index += 4)
+    {
+        const uint32_t address = bytes[index] | (bytes[index + 1] << 8) | (bytes[index + 2] << 16) | (uint32_t(bytes[index + 3]) << 24);
+        const auto insn = by_address.find(address);
+        if ((address == 0) || (insn == by_address.end()))
+            continue; // sample in code that was dropped by the linker
+        program[insn->second].sample = true;
+        ++count;
+    }
+    return count;
+}
+
+static bool lookup(const int64_t address, uint32_t &instruction)
+{
+    const auto insn = by_address.find(uint32_t(address));
+    if ((address < 0) || (insn == by_address.end()))
+        return false;
+    instruction = insn->second;
+    return true;
+}
+
+static uint32_t functionOfEntry(const uint32_t instruction)
+{
+    const Instruction &insn = program[instruction];
+    return (functions[insn.function].start == insn.address) ? insn.function : UINT32_MAX;
+}
+
+static void buildGraph(void)
+{
+    edges.assign(program.size(), {});
+    callees.assign(program.size(), {});
+    callers.assign(functions.size(), {});
+    tail_callers.assign(functions.size(), {});
+
+    for (uint32_t index = 0; index < program.size(); ++index)
+    {
+        const Instruction &insn = program[index];
+        const uint8_t cycles = cyclesOf(insn);
+        uint32_t next = 0, after = 0, target = 0;
+        const bool has_next = lookup(insn.address + insn.size, next);
+        const bool has_target = lookup(insn.target, target);
+
+        switch (insn.flow)
+        {
+        case Flow::NEXT:
+            if (has_next)
+                edges[index].push_back({next, cycles, false});
+            break;
+        case Flow::BRANCH:
+            if (has_next)
+                edges[index].push_back({next, cycles, false});
+            if (has_target)
+                edges[index].push_back({target, uint8_t(cycles + 1), false});
+            break;
+        case Flow::SKIP:
+            if (has_next)
+            {
+                edges[index].push_back({next, cycles, false});
+                if (lookup(program[next].address + program[next].size, after))
+                    edges[index].push_back({after, uint8_t(cycles + program[next].size / 2), false});
+            }
+            break;
+        case Flow::JUMP:
+            if (has_target)
+            {
+                edges[index].push_back({target, cycles, false});
+                const uint32_t entry = functionOfEntry(target);
+                if ((entry != UINT32_MAX) && (entry != insn.function))
+                    tail_callers[entry].push_back(insn.function);
+            }
+            else
+                problems.insert("jump to unknown address at " + describe(index));
+            break;
+        case Flow::CALL:
+            if (has_target)
+                callees[index].push_back(target);
+            else
+            {
+                const auto range = options.indirect.equal_range(functions[insn.function].name.substr(0, functions[insn.function].name.find('(')));
+                for (auto mapping = range.first; mapping != range.second; ++mapping)
+                    for (const uint32_t function : findFunctions(mapping->second))
+                        callees[index].push_back(by_address[functions[function].start]);
+            }
+            for (const uint32_t callee : callees[index])
+            {
+                const uint32_t entry = functionOfEntry(callee);
+                if (entry != UINT32_MAX)
+                    callers[entry].push_back(index);
+            }
+            if (has_next)
+                edges[index].push_back({next, 0, false}); // cycles of the call are added with the callee
+            break;
+        case Flow::RETURN:
+        case Flow::UNKNOWN:
+            break;
+        }
+    }
+}
+
+// depth-first from every function entry, an edge back into the current path closes a loop
+static void findLoops(void)
+{
+    std::vector<uint8_t> state(program.size(), 0); // 0 new, 1 on the path, 2 done
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+
+    for (const Function &function : functions)
+    {
+        uint32_t entry;
+        if (!lookup(function.start, entry) || state[entry] != 0)
+            continue;
+        stack.push_back({entry, 0});
+        state[entry] = 1;
+        while (!stack.empty())
+        {
+            const uint32_t node = stack.back().first;
+            const uint32_t edge = stack.back().second++;
+            if (edge == edges[node].size())
+            {
+                state[node] = 2;
+                stack.pop_back();
+                continue;
+            }
+            const uint32_t to = edges[node][edge].to;
+            if (state[to] == 1)
+            {
+                edges[node][edge].back = true;
+                loops[to].latches.push_back(node);
+            }
+            else if (state[to] == 0)
+            {
+                state[to] = 1;
+                stack.push_back({to, 0});
+            }
+        }
+    }
+
+    // body: everything that reaches a latch without passing the head
+    std::vector<std::vector<uint32_t>> predecessors(program.size());
+    for (uint32_t node = 0; node < program.size(); ++node)
+        for (const Edge &edge : edges[node])
+            predecessors[edge.to].push_back(node);
+
+    for (auto &entry : loops)
+    {
+        Loop &loop = entry.second;
+        loop.body.assign(program.size(), false);
+        loop.body[entry.first] = true;
+        std::vector<uint32_t> work(loop.latches);
+        while (!work.empty())
+        {
+            const uint32_t node = work.back();
+            work.pop_back();
+            if (loop.body[node])
+                continue;
+            loop.body[node] = true;
+            for (const uint32_t predecessor : predecessors[node])
+                work.push_back(predecessor);
+        }
+    }
+}
+
+static std::string firstOperand(const Instruction &insn)
+{
+    return insn.operands.substr(0, insn.operands.find(','));
+}
+
+// ldi rX, K .. dec rX (or subi rX, 0x01), brne head -> K iterations, 0 means 256
+static uint32_t countedBound(const uint32_t head, const Loop &loop)
+{
+    for (const uint32_t latch : loop.latches)
+    {
+        if ((program[latch].mnemonic != "brne") || (latch == 0))
+            continue;
+        const Instruction &step = program[latch - 1];
+        const bool decrement = (step.mnemonic == "dec") || ((step.mnemonic == "subi") && (step.operands.find("0x01") != std::string::npos));
+        if (!decrement)
+            continue;
+        const std::string counter = firstOperand(step);
+
+        bool written = false;
+        for (uint32_t node = 0; node < program.size(); ++node)
+            written |= loop.body[node] && (node != latch - 1) && (firstOperand(program[node]) == counter) && (program[node].flow == Flow::NEXT);
+        if (written)
+            continue;
+
+        for (uint32_t node = head, distance = 0; (node > 0) && (distance < COUNTED_LOOP_LOOKBACK); ++distance)
+        {
+            const Instruction &insn = program[--node];
+            if (loop.body[node] || (firstOperand(insn) != counter))
+                continue;
+            if (insn.mnemonic != "ldi")
+                break;
+            const uint32_t value = uint32_t(strtoul(insn.operands.c_str() + insn.operands.find(',') + 1, nullptr, 0)) & 0xFF;
+            return (value == 0) ? 256 : value;
+        }
+    }
+    return 0;
+}
+
+static Reach dag(uint32_t node);
+static int64_t loopExtra(uint32_t head);
+
+static Reach callSummary(const uint32_t node)
+{
+    Reach best;
+    for (const uint32_t callee : callees[node])
+        best.take(dag(callee), cyclesOf(program[node]));
+    return best;
+}
+
+// executing node and what follows, back edges are only taken by a continuation (after a return into the caller)
+static Reach expand(const uint32_t node, Reach (*const child)(uint32_t), const bool take_back)
+{
+    const Instruction &insn = program[node];
+    Reach best;
+
+    if (insn.flow == Flow::RETURN)
+    {
+        best.returns = Worst(cyclesOf(insn), node);
+        return best;
+    }
+    if (insn.flow == Flow::UNKNOWN)
+    {
+        problems.insert("indirect jump at " + describe(node));
+        return best;
+    }
+    if ((insn.flow == Flow::CALL) && callees[node].empty())
+    {
+        problems.insert("indirect call at " + describe(node) + ", name its target with -c");
+        return best;
+    }
+
+    Reach call;
+    if (insn.flow == Flow::CALL)
+    {
+        call = callSummary(node);
+        best.sample = call.sample;
+        if (call.returns.cycles == NO_PATH)
+            return best; // every path of the callee samples the line
+    }
+
+    for (const Edge &edge : edges[node])
+    {
+        if (edge.back && !take_back)
+            continue;
+        const Reach rest = edge.back ? dag(edge.to) : child(edge.to);
+        best.take(rest, edge.cycles + ((insn.flow == Flow::CALL) ? call.returns.cycles : 0));
+    }
+    return best;
+}
+
+static std::vector<Reach> dag_memo;
+static std::vector<uint8_t> dag_state;
+
+static Reach dag(const uint32_t node)
+{
+    if (program[node].sample)
+    {
+        Reach terminal;
+        terminal.sample = Worst(0, node);
+        return terminal;
+    }
+    if (dag_state[node] == 2)
+        return dag_memo[node];
+    if (dag_state[node] == 1)
+    {
+        problems.insert("recursion or irreducible loop at " + describe(node));
+        return Reach();
+    }
+    dag_state[node] = 1;
+
+    Reach best = expand(node, dag, false);
+    const int64_t extra = loopExtra(node);
+    Reach result;
+    result.take(best, extra);
+
+    dag_memo[node] = result;
+    dag_state[node] = 2;
+    return result;
+}
+
+// longest iteration of the loop that does not sample the line: head .. latch -> head
+static int64_t iteration(const uint32_t node, const uint32_t head, const Loop &loop, std::map<uint32_t, int64_t> &memo)
+{
+    if (program[node].sample)
+        return NO_PATH;
+    const auto known = memo.find(node);
+    if (known != memo.end())
+        return known->second;
+    memo[node] = NO_PATH; // cycles through a nested loop are closed by its own bound
+
+    const Instruction &insn = program[node];
+    int64_t call_cycles = 0;
+    if (insn.flow == Flow::CALL)
+    {
+        const Reach call = callSummary(node);
+        call_cycles = call.returns.cycles;
+    }
+
+    int64_t best = NO_PATH;
+    if ((call_cycles != NO_PATH) && (insn.flow != Flow::RETURN))
+    {
+        for (const Edge &edge : edges[node])
+        {
+            int64_t rest = NO_PATH;
+            if (edge.back && (edge.to == head))
+                rest = 0;
+            else if (!edge.back && loop.body[edge.to])
+                rest = iteration(edge.to, head, loop, memo);
+            if (rest != NO_PATH)
+                best = std::max(best, rest + edge.cycles + call_cycles);
+        }
+    }
+    if ((best != NO_PATH) && (node != head))
+        best += loopExtra(node);
+
+    memo[node] = best;
+    return best;
+}
+
+static int64_t loopExtra(const uint32_t head)
+{
+    const auto entry = loops.find(head);
+    if (entry == loops.end())
+        return 0;
+    Loop &loop = entry->second;
+    if (loop.done)
+        return loop.extra;
+    if (loop.counting)
+        return 0;
+    loop.counting = true;
+
+    std::map<uint32_t, int64_t> memo;
+    const int64_t cycles = iteration(head, head, loop, memo);
+    if (cycles != NO_PATH)
+    {
+        const std::string &function = functions[program[head].function].name;
+        uint32_t bound = countedBound(head, loop);
+        for (const auto &annotation : options.bounds)
+            if ((bound == 0) && nameMatches(function, annotation.first))
+                bound = annotation.second; // only for loops that are not counted
+        if (bound == 0)
+            problems.insert("loop without a sample at " + describe(head) + " has no bound, give one with -l");
+        else
+            loop.extra = int64_t(bound - 1) * cycles;
+        if (options.verbose)
+            fprintf(stderr, "loop at %s: %" PRId64 " cycles per iteration, bound %u\n", describe(head).c_str(), cycles, unsigned(bound));
+    }
+    loop.done = true;
+    return loop.extra;
+}
+
+static std::vector<Reach> cont_memo;
+static std::vector<uint8_t> cont_state;
+
+// like dag(), but loops the node is part of may be closed: the path came back from a callee into the middle of them
+static Reach cont(const uint32_t node)
+{
+    if (program[node].sample || (loops.count(node) != 0))
+        return dag(node);
+    if (cont_state[node] == 2)
+        return cont_memo[node];
+    if (cont_state[node] == 1)
+    {
+        problems.insert("irreducible loop at " + describe(node));
+        return Reach();
+    }
+    cont_state[node] = 1;
+    cont_memo[node] = expand(node, cont, true);
+    cont_state[node] = 2;
+    return cont_memo[node];
+}
+
+static std::vector<Worst> return_memo;
+static std::vector<uint8_t> return_state;
+
+// where a return of function goes on: the longest way through its callers to a sample, NO_PATH if nobody calls it (main(), an isr)
+static Worst continuation(const uint32_t function)
+{
+    if (return_state[function] == 2)
+        return return_memo[function];
+    if (return_state[function] == 1)
+        return Worst(); // recursion, reported by dag()
+    return_state[function] = 1;
+
+    Worst best;
+    for (const uint32_t call : callers[function])
+    {
+        uint32_t next;
+        if (!lookup(program[call].address + program[call].size, next))
+            continue;
+        const Reach rest = cont(next);
+        best.take(rest.sample, 0);
+        if (rest.returns.cycles == NO_PATH)
+            continue;
+        const Worst further = continuation(program[call].function);
+        best.take((further.cycles == NO_PATH) ? rest.returns : further, (further.cycles == NO_PATH) ? 0 : rest.returns.cycles);
+    }
+    for (const uint32_t caller : tail_callers[function])
+        best.take(continuation(caller), 0);
+
+    return_memo[function] = best;
+    return_state[function] = 2;
+    return best;
+}
+
+// from a sample (executing it) to the next sample
+static Worst fromSample(const uint32_t sample)
+{
+    const Reach reach = expand(sample, cont, true);
+    Worst best = reach.sample;
+    if (reach.returns.cycles != NO_PATH)
+    {
+        const Worst further = continuation(program[sample].function);
+        best.take((further.cycles == NO_PATH) ? reach.returns : further, (further.cycles == NO_PATH) ? 0 : reach.returns.cycles);
+    }
+    return best;
+}
+
+static bool parseArguments(int argc, char *argv[])
+{
+    for (int index = 1; index < argc; ++index)
+    {
+        const std::string argument(argv[index]);
+        const bool has_value = (index + 1 < argc);
+        if ((argument == "-f") && has_value)
+            options.f_cpu = strtod(argv[++index], nullptr); // a trailing L of F_CPU is ignored
+        else if ((argument == "-b") && has_value)
+            options.budget_us = strtod(argv[++index], nullptr);
+        else if (((argument == "-l") || (argument == "-c")) && has_value)
+        {
+            const std::string value(argv[++index]);
+            const size_t split = value.find('=');
+            if ((split == std::string::npos) || (split == 0) || (split + 1 == value.size()))
+                return false;
+            if (argument == "-l")
+                options.bounds[value.substr(0, split)] = uint32_t(strtoul(value.c_str() + split + 1, nullptr, 10));
+            else
+                options.indirect.insert({value.substr(0, split), value.substr(split + 1)});
+        }
+        else if (argument == "-v")
+            options.verbose = true;
+        else if (argument[0] == '-')
+            return false;
+        else if (options.elf.empty())
+            options.elf = argument;
+        else
+            options.functions.push_back(argument);
+    }
+    return !options.elf.empty() && !options.functions.empty() && (options.f_cpu > 0) && (options.budget_us > 0);
+}
+
+int main(int argc, char *argv[])
+{
+    if (!parseArguments(argc, argv))
+    {
+        fprintf(stderr, "usage: %s [-f f_cpu] [-b budget_us] [-l function=bound].. [-c function=target].. [-v] firmware.elf function..\n", argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> disassembly, samples;
+    if (!runObjdump("-d -C", disassembly) || !parseDisassembly(disassembly))
+    {
+        fprintf(stderr, "%s: no disassembly, is avr-objdump (or OBJDUMP) installed?\n", options.elf.c_str());
+        return 2;
+    }
+    runObjdump("-s -j .debug_wcet_samples", samples); // fails if the section is missing
+    if (parseSamples(samples) == 0)
+    {
+        fprintf(stderr, "%s: no samples of the line in .debug_wcet_samples, built with \"make bare\"?\n", options.elf.c_str());
+        return 2;
+    }
+
+    buildGraph();
+    findLoops();
+    dag_memo.assign(program.size(), Reach());
+    dag_state.assign(program.size(), 0);
+    cont_memo.assign(program.size(), Reach());
+    cont_state.assign(program.size(), 0);
+    return_memo.assign(functions.size(), Worst());
+    return_state.assign(functions.size(), 0);
+
+    const int64_t budget = int64_t(options.budget_us * options.f_cpu / 1000000.0);
+    printf("budget %.1f us = %" PRId64 " cycles @ %.1f MHz\n", options.budget_us, budget, options.f_cpu / 1000000.0);
+
+    bool over_budget = false;
+    for (const std::string &wanted : options.functions)
+    {
+        const std::vector<uint32_t> matches = findFunctions(wanted);
+        if (matches.empty())
+            printf("%-28s not in the firmware (inlined?)\n", wanted.c_str());
+
+        for (const uint32_t function : matches)
+        {
+            Worst worst;
+            uint32_t worst_start = 0, sample_count = 0;
+            for (uint32_t node = 0; node < program.size(); ++node)
+            {
+                if ((program[node].function != function) || !program[node].sample)
+                    continue;
+                ++sample_count;
+                const Worst path = fromSample(node);
+                if (options.verbose)
+                    printf("  %s -> %s: %" PRId64 " cycles\n", describe(node).c_str(), describe(path.end).c_str(), path.cycles);
+                if (path.cycles > worst.cycles)
+                {
+                    worst = path;
+                    worst_start = node;
+                }
+            }
+
+            const std::string &name = functions[function].name;
+            if (sample_count == 0)
+            {
+                printf("%-28s no sample of its own (reaches them through calls)\n", name.c_str());
+                continue;
+            }
+            const bool fails = (worst.cycles > budget);
+            over_budget |= fails;
+            printf("%-28s %3u samples, worst %4" PRId64 " cycles = %5.1f us %s\n", name.c_str(), unsigned(sample_count), worst.cycles, worst.cycles * 1000000.0 / options.f_cpu, fails ? "OVER BUDGET" : "ok");
+            printf("%-28s from %s\n%-28s to   %s%s\n", "", describe(worst_start).c_str(), "", describe(worst.end).c_str(), program[worst.end].sample ? "" : " (return without caller)");
+        }
+    }
+
+    for (const std::string &problem : problems)
+        fprintf(stderr, "%s\n", problem.c_str());
+    if (!problems.empty())
+        return 2;
+    return over_budget ? 1 : 0;
+}